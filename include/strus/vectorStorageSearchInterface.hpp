@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Interface for the searches and statistics of the standard vector storage client not covered by the VectorStorageClientInterface
+/// \file vectorStorageSearchInterface.hpp
+#ifndef _STRUS_VECTOR_STORAGE_SEARCH_INTERFACE_HPP_INCLUDED
+#define _STRUS_VECTOR_STORAGE_SEARCH_INTERFACE_HPP_INCLUDED
+#include "strus/storage/vectorQueryResult.hpp"
+#include "strus/storage/wordVector.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/// \brief strus toplevel namespace
+namespace strus {
+
+/// \brief Result of a search over multiple types
+class VectorQueryTypedResult
+{
+public:
+	VectorQueryTypedResult( const std::string& type_, const VectorQueryResult& result_)
+		:m_type(type_),m_result(result_){}
+	VectorQueryTypedResult( const VectorQueryTypedResult& o)
+		:m_type(o.m_type),m_result(o.m_result){}
+
+	const std::string& type() const			{return m_type;}
+	const VectorQueryResult& result() const		{return m_result;}
+	const std::string& value() const		{return m_result.value();}
+	double weight() const				{return m_result.weight();}
+
+private:
+	std::string m_type;
+	VectorQueryResult m_result;
+};
+
+/// \brief Statistics of the cache of search results of a vector storage client
+struct VectorQueryResultCacheStatistics
+{
+	std::size_t hits;		///< number of searches answered by the cache
+	std::size_t misses;		///< number of searches not found in the cache
+	std::size_t entries;		///< number of searches in the cache
+
+	VectorQueryResultCacheStatistics()
+		:hits(0),misses(0),entries(0){}
+	VectorQueryResultCacheStatistics( std::size_t hits_, std::size_t misses_, std::size_t entries_)
+		:hits(hits_),misses(misses_),entries(entries_){}
+	VectorQueryResultCacheStatistics( const VectorQueryResultCacheStatistics& o)
+		:hits(o.hits),misses(o.misses),entries(o.entries){}
+};
+
+/// \brief Interface for consuming the results of a radius search one by one
+class VectorQueryResultConsumerInterface
+{
+public:
+	/// \brief Destructor
+	virtual ~VectorQueryResultConsumerInterface(){}
+	/// \brief Consume one result
+	/// \return false, if the search should be stopped
+	virtual bool consume( const VectorQueryResult& result)=0;
+};
+
+/// \brief Restriction of the results of searches to a set of features, created once and used for many searches
+/// \note Created with VectorStorageSearchInterface::createSearchRestriction, can only be used with the client that created it
+class VectorSearchRestrictionInterface
+{
+public:
+	/// \brief Destructor
+	virtual ~VectorSearchRestrictionInterface(){}
+
+	/// \brief Get the number of features of the restriction known to the storage at its creation
+	virtual int nofFeatures() const=0;
+};
+
+/// \brief Interface for the searches and statistics of the standard vector storage client not covered by the VectorStorageClientInterface
+/// \note The client created by the standard vector storage (createVectorStorage_std) implements this interface, get it with a dynamic_cast of the VectorStorageClientInterface
+/// \note All searches of the standard vector storage client (including VectorStorageClientInterface::findSimilar) return results with a weight bigger than or equal to the minimum similarity passed
+class VectorStorageSearchInterface
+{
+public:
+	/// \brief Destructor
+	virtual ~VectorStorageSearchInterface(){}
+
+	/// \brief Get the number of searchers of feature types created (LSH values loaded) since the client has been created
+	/// \note Concurrent searches of a type whose searcher does not exist yet create it only once
+	/// \return the number of searchers created
+	virtual int nofSearchersCreated() const=0;
+
+	/// \brief Get the statistics of the cache of search results (configuration parameter resultcache)
+	/// \note A commit drops the cached results of the types it changes
+	/// \return the statistics, all counts 0 if the client has no cache of search results
+	virtual VectorQueryResultCacheStatistics queryResultCacheStatistics() const=0;
+
+	/// \brief Find all features of a type with a similarity above a threshold without a limit of the number of results
+	/// \param[in] consumer receiver of the results
+	/// \param[in] type name of the feature type
+	/// \param[in] vec vector to search for
+	/// \param[in] minSimilarity minimum similarity of the results, all results passed have a weight bigger than or equal to it
+	/// \param[in] speedRecallFactor factor for the speed/recall tradeoff of the LSH filter
+	/// \param[in] realVecWeights true, if the weights should be calculated with the real vectors instead of the LSH values
+	/// \param[in] sorted true, if the results should be passed to the consumer with descending weight (all candidates are collected first), false for passing them in the order of the scan as they are found
+	/// \return the number of results passed to the consumer, including the one the consumer stopped the search with
+	virtual int findSimilarWithinRadius( VectorQueryResultConsumerInterface& consumer, const std::string& type, const WordVector& vec, double minSimilarity, double speedRecallFactor, bool realVecWeights, bool sorted) const=0;
+
+	/// \brief Create a restriction of the results of searches to a set of features
+	/// \param[in] features names of the features allowed as results, names not known to the storage are ignored
+	/// \note The names are resolved once, the set of slots of the searcher of a type is built on its first use and rebuilt only if the searcher of the type has been replaced by a commit
+	/// \return the restriction (ownership passed to the caller) or NULL on error
+	virtual VectorSearchRestrictionInterface* createSearchRestriction( const std::vector<std::string>& features) const=0;
+
+	/// \brief Find the most similar features of a type restricted to a set of features
+	/// \note The restriction is applied in the scan of the LSH filter, features not in the set never become candidates
+	/// \param[in] restriction the set of features allowed as results created with createSearchRestriction of this client
+	/// \remark other parameters as in VectorStorageClientInterface::findSimilar
+	/// \return the best results in the set of features with descending weight
+	virtual std::vector<VectorQueryResult> findSimilarRestricted( const std::string& type, const WordVector& vec, const VectorSearchRestrictionInterface& restriction, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const=0;
+
+	/// \brief Find the most similar features of multiple types with one LSH value calculation for all types
+	/// \param[in] types list of the feature types to search
+	/// \param[in] vec vector to search for
+	/// \param[in] maxNofResults maximum number of results per type
+	/// \param[in] minSimilarity minimum similarity of the results, all results have a weight bigger than or equal to it
+	/// \param[in] speedRecallFactor factor for the speed/recall tradeoff of the LSH filter
+	/// \param[in] realVecWeights true, if the weights should be calculated with the real vectors instead of the LSH values
+	/// \note The types are searched in parallel by the calling thread and the threads of the search pool of the client (configuration parameter searchthreads)
+	/// \return the best results for each type in the order of the types passed, the same as the results of findSimilar of each type
+	virtual std::vector<std::vector<VectorQueryResult> > findSimilarMulti( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const=0;
+
+	/// \brief Find the most similar features of multiple types with one LSH value calculation for all types
+	/// \remark parameters as in findSimilarMulti, maxNofResults is the maximum number of results of all types
+	/// \return the best results of all types merged, sorted by descending weight
+	virtual std::vector<VectorQueryTypedResult> findSimilarMultiMerged( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const=0;
+};
+
+}//namespace
+#endif
+
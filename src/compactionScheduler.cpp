@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Background compaction of the vector storage database driven by the volume of data written
+#include "compactionScheduler.hpp"
+#include "strus/databaseClientInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "internationalization.hpp"
+
+using namespace strus;
+
+CompactionScheduler::CompactionScheduler( DatabaseClientInterface* database_, std::size_t writeThreshold_, unsigned int minInterval_, ErrorBufferInterface* errorhnd_)
+	:m_database(database_),m_errorhnd(errorhnd_),m_writeThreshold(writeThreshold_),m_minInterval(minInterval_)
+	,m_mutex(),m_cond(),m_idleCond(),m_pending(false),m_running(false),m_stopped(false),m_lastCompaction(std::time(NULL)),m_stats(),m_lastError(),m_thread()
+{
+	m_thread.reset( new strus::thread( &CompactionScheduler::run, this));
+}
+
+CompactionScheduler::~CompactionScheduler()
+{
+	(void)stop();
+}
+
+void CompactionScheduler::notifyWrites( std::size_t nofBytes)
+{
+	strus::scoped_lock lock( m_mutex);
+	m_stats.bytesWritten += nofBytes;
+	if (m_pending || m_stopped || m_stats.bytesWritten < m_writeThreshold) return;
+	if (std::difftime( std::time(NULL), m_lastCompaction) < (double)m_minInterval) return;
+	m_pending = true;
+	m_cond.notify_one();
+}
+
+void CompactionScheduler::waitIdle()
+{
+	strus::unique_lock lock( m_mutex);
+	while ((m_pending && !m_stopped) || m_running) m_idleCond.wait( lock);
+}
+
+std::string CompactionScheduler::stop()
+{
+	{
+		strus::scoped_lock lock( m_mutex);
+		m_stopped = true;
+		m_cond.notify_one();
+	}
+	if (m_thread.get())
+	{
+		m_thread->join();
+		m_thread.reset();
+	}
+	strus::scoped_lock lock( m_mutex);
+	return m_lastError;
+}
+
+CompactionScheduler::Statistics CompactionScheduler::statistics() const
+{
+	strus::scoped_lock lock( m_mutex);
+	return m_stats;
+}
+
+void CompactionScheduler::run()
+{
+	for (;;)
+	{
+		{
+			strus::unique_lock lock( m_mutex);
+			while (!m_pending && !m_stopped) m_cond.wait( lock);
+			if (m_stopped) break;
+			m_pending = false;
+			m_running = true;
+			m_stats.bytesWritten = 0;
+		}
+		bool success = m_database->compactDatabase();
+		std::string error;
+		if (!success)
+		{
+			const char* msg = m_errorhnd->fetchError();
+			error = msg ? msg : _TXT("unknown error");
+		}
+		strus::scoped_lock lock( m_mutex);
+		m_lastCompaction = std::time(NULL);
+		m_running = false;
+		if (success)
+		{
+			++m_stats.nofCompactions;
+		}
+		else
+		{
+			m_lastError = error;
+		}
+		m_idleCond.notify_all();
+	}
+	{
+		strus::scoped_lock lock( m_mutex);
+		m_idleCond.notify_all();
+	}
+	m_errorhnd->releaseContext();
+}
+
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Background compaction of the vector storage database driven by the volume of data written
+#ifndef _STRUS_VECTOR_COMPACTION_SCHEDULER_HPP_INCLUDED
+#define _STRUS_VECTOR_COMPACTION_SCHEDULER_HPP_INCLUDED
+#include "strus/base/thread.hpp"
+#include "strus/reference.hpp"
+#include <string>
+#include <cstddef>
+#include <ctime>
+
+namespace strus {
+
+/// \brief Forward declaration
+class DatabaseClientInterface;
+/// \brief Forward declaration
+class ErrorBufferInterface;
+
+/// \brief Background thread compacting the database when the volume of data committed exceeds a threshold
+/// \note A compaction is only triggered by a commit, at the earliest after a minimum interval since the last compaction
+class CompactionScheduler
+{
+public:
+	/// \brief Constructor, starts the background thread
+	/// \param[in] database_ database client to compact, must outlive the scheduler
+	/// \param[in] writeThreshold_ number of bytes committed since the last compaction triggering a compaction
+	/// \param[in] minInterval_ minimum number of seconds between the end of a compaction and the start of the next
+	/// \param[in] errorhnd_ error buffer interface
+	CompactionScheduler( DatabaseClientInterface* database_, std::size_t writeThreshold_, unsigned int minInterval_, ErrorBufferInterface* errorhnd_);
+	~CompactionScheduler();
+
+	/// \brief Count the bytes of a commit and trigger a compaction if the threshold is exceeded
+	void notifyWrites( std::size_t nofBytes);
+
+	/// \brief Wait for the end of a compaction triggered or running, returns immediately if there is none
+	void waitIdle();
+
+	/// \brief Wait for the end of a running compaction and stop the background thread
+	/// \return the error of the last compaction failed or an empty string
+	std::string stop();
+
+	struct Statistics
+	{
+		std::size_t nofCompactions;	///< number of compactions done in the background
+		std::size_t bytesWritten;	///< number of bytes committed since the start of the last compaction
+
+		Statistics()
+			:nofCompactions(0),bytesWritten(0){}
+		Statistics( const Statistics& o)
+			:nofCompactions(o.nofCompactions),bytesWritten(o.bytesWritten){}
+	};
+
+	/// \brief Get the statistics of the scheduler
+	Statistics statistics() const;
+
+private:
+	void run();
+
+private:
+	CompactionScheduler( const CompactionScheduler&){}		//... non copyable
+	void operator=( const CompactionScheduler&){}		//... non copyable
+
+private:
+	DatabaseClientInterface* m_database;
+	ErrorBufferInterface* m_errorhnd;
+	std::size_t m_writeThreshold;
+	unsigned int m_minInterval;
+	mutable strus::mutex m_mutex;
+	strus::condition_variable m_cond;
+	strus::condition_variable m_idleCond;	///< signaled at the end of a compaction and when the background thread terminates
+	bool m_pending;				///< true if a compaction is triggered and not yet started
+	bool m_running;				///< true if a compaction is running
+	bool m_stopped;				///< true if the background thread is asked to terminate
+	std::time_t m_lastCompaction;		///< time of the end of the last compaction
+	Statistics m_stats;
+	std::string m_lastError;		///< error of the last compaction failed
+	Reference<strus::thread> m_thread;
+};
+
+}//namespace
+#endif
+
@@ -20,6 +20,8 @@
 #include "simHash.hpp"
 #include <cstring>
 #include <cstdio>
+#include <cctype>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <limits>
@@ -29,18 +31,293 @@ using namespace strus;
 
 #define MODULENAME   "vector storage"
 
-DatabaseAdapter::DatabaseAdapter( const DatabaseInterface* database_, const std::string& config_, ErrorBufferInterface* errorhnd_)
-	:m_database(database_->createClient(config_)),m_errorhnd(errorhnd_)
+const char* strus::simHashLayoutName( SimHashLayout layout)
+{
+	switch (layout)
+	{
+		case SimHashLayoutKey: return "key";
+		case SimHashLayoutBlock: return "block";
+	}
+	return 0;
+}
+
+SimHashLayout strus::simHashLayoutFromName( const std::string& name)
+{
+	std::string nam;
+	std::string::const_iterator ni = name.begin(), ne = name.end();
+	for (; ni != ne; ++ni) nam.push_back( std::tolower( *ni));
+	if (nam == "key") return SimHashLayoutKey;
+	if (nam == "block") return SimHashLayoutBlock;
+	throw strus::runtime_error( _TXT("unknown layout of LSH values '%s' (expected one of key,block)"), name.c_str());
+}
+
+static int featnoSampleIntervalFromString( const std::string& value)
+{
+	std::istringstream in( value);
+	int rt = 0;
+	if (!(in >> rt) || rt <= 0)
+	{
+		throw strus::runtime_error( _TXT("illegal distance of the position markers of features '%s' stored (positive number expected)"), value.c_str());
+	}
+	return rt;
+}
+
+DatabaseAdapter::DatabaseAdapter( const DatabaseInterface* database_, const std::string& config_, ErrorBufferInterface* errorhnd_, std::size_t nameCacheSize_, std::size_t compactionWriteThreshold_, unsigned int compactionMinInterval_)
+	:m_database(database_->createClient(config_)),m_frozen(),m_errorhnd(errorhnd_),m_vecenc(VectorEncodingFloat32),m_simHashLayout(SimHashLayoutKey),m_featnoSampleInterval(FeatnoSampleInterval),m_nameCache(),m_compactionScheduler()
 {
 	if (!m_database.get()) throw strus::runtime_error( _TXT("failed to create database client for %s: %s"), MODULENAME, m_errorhnd->fetchError());
+	std::string vecenc = readVariable( "vecenc");
+	if (!vecenc.empty())
+	{
+		m_vecenc = vectorEncodingFromName( vecenc);
+	}
+	std::string lshlayout = readVariable( "lshlayout");
+	if (!lshlayout.empty())
+	{
+		m_simHashLayout = simHashLayoutFromName( lshlayout);
+	}
+	std::string sampleint = readVariable( "sampleint");
+	if (!sampleint.empty())
+	{
+		m_featnoSampleInterval = featnoSampleIntervalFromString( sampleint);
+	}
+	if (nameCacheSize_)
+	{
+		m_nameCache.reset( new KeyValueCache( nameCacheSize_));
+	}
+	if (compactionWriteThreshold_)
+	{
+		m_compactionScheduler.reset( new CompactionScheduler( m_database.get(), compactionWriteThreshold_, compactionMinInterval_, m_errorhnd));
+	}
+}
+
+DatabaseAdapter::DatabaseAdapter( const Reference<FrozenStorage>& frozen_, ErrorBufferInterface* errorhnd_, std::size_t nameCacheSize_)
+	:m_database(),m_frozen(frozen_),m_errorhnd(errorhnd_),m_vecenc(VectorEncodingFloat32),m_simHashLayout(SimHashLayoutKey),m_featnoSampleInterval(FeatnoSampleInterval),m_nameCache(),m_compactionScheduler()
+{
+	std::string vecenc = readVariable( "vecenc");
+	if (!vecenc.empty())
+	{
+		m_vecenc = vectorEncodingFromName( vecenc);
+	}
+	std::string lshlayout = readVariable( "lshlayout");
+	if (!lshlayout.empty())
+	{
+		m_simHashLayout = simHashLayoutFromName( lshlayout);
+	}
+	std::string sampleint = readVariable( "sampleint");
+	if (!sampleint.empty())
+	{
+		m_featnoSampleInterval = featnoSampleIntervalFromString( sampleint);
+	}
+	if (nameCacheSize_)
+	{
+		m_nameCache.reset( new KeyValueCache( nameCacheSize_));
+	}
 }
 
 DatabaseAdapter::DatabaseAdapter( const DatabaseAdapter& o)
-	:m_database(o.m_database),m_errorhnd(o.m_errorhnd)
+	:m_database(o.m_database),m_frozen(o.m_frozen),m_errorhnd(o.m_errorhnd),m_vecenc(o.m_vecenc),m_simHashLayout(o.m_simHashLayout),m_featnoSampleInterval(o.m_featnoSampleInterval),m_nameCache(o.m_nameCache),m_compactionScheduler(o.m_compactionScheduler)
 {}
 
-DatabaseAdapter::Transaction::Transaction( DatabaseClientInterface* database, ErrorBufferInterface* errorhnd_)
-	:m_errorhnd(errorhnd_),m_transaction( database->createTransaction())
+/// \brief View on the serialization of a block of LSH values in the layout SimHashLayoutBlock
+/// \note The block is serialized as [nof,bits,featno...,words...] with all numbers in network byte order and the words of each value packed without gaps
+class SimHashBlockView
+{
+public:
+	SimHashBlockView()
+		:m_nof(0),m_bits(0),m_arsize(0),m_featnoar(0),m_wordar(0){}
+
+	SimHashBlockView( const char* blob, std::size_t blobsize, const Index& typeno, const Index& blockno)
+		:m_nof(0),m_bits(0),m_arsize(0),m_featnoar(0),m_wordar(0)
+	{
+		if (blobsize < 2 * sizeof(uint32_t))
+		{
+			throw strus::runtime_error(_TXT("corrupt data in block %d of LSH values stored for type %d"), blockno, typeno);
+		}
+		m_nof = readUint32( blob);
+		m_bits = readUint32( blob + sizeof(uint32_t));
+		m_arsize = SimHash::arsize( m_bits);
+		m_featnoar = blob + 2 * sizeof(uint32_t);
+		m_wordar = m_featnoar + m_nof * sizeof(uint32_t);
+		if (blobsize != 2 * sizeof(uint32_t) + m_nof * (sizeof(uint32_t) + m_arsize * sizeof(uint64_t)))
+		{
+			throw strus::runtime_error(_TXT("corrupt data in block %d of LSH values stored for type %d"), blockno, typeno);
+		}
+	}
+
+	int size() const
+	{
+		return m_nof;
+	}
+
+	Index featno( int idx) const
+	{
+		return readUint32( m_featnoar + idx * sizeof(uint32_t));
+	}
+
+	/// \brief Get the index of the first value with a feature number bigger than or equal to a feature number
+	int upperBound( const Index& featno_) const
+	{
+		int lo = 0, hi = m_nof;
+		while (lo < hi)
+		{
+			int mid = (lo + hi) / 2;
+			if (featno( mid) < featno_) lo = mid+1; else hi = mid;
+		}
+		return lo;
+	}
+
+	/// \brief Get the index of the value of a feature or -1 if it is not part of the block
+	int find( const Index& featno_) const
+	{
+		int idx = upperBound( featno_);
+		return (idx < m_nof && featno( idx) == featno_) ? idx : -1;
+	}
+
+	SimHash get( int idx) const
+	{
+		return SimHash::fromPackedWords( m_wordar + idx * m_arsize * sizeof(uint64_t), m_bits, featno( idx));
+	}
+
+	void get( SimHash& res, int idx) const
+	{
+		SimHash::fromPackedWords( res, m_wordar + idx * m_arsize * sizeof(uint64_t), m_bits, featno( idx));
+	}
+
+	static std::string serialization( const std::vector<SimHash>& ar)
+	{
+		std::string rt;
+		if (ar.empty()) return rt;
+		int bits = ar[0].size();
+		rt.reserve( 2 * sizeof(uint32_t) + ar.size() * (sizeof(uint32_t) + SimHash::arsize( bits) * sizeof(uint64_t)));
+		appendUint32( rt, ar.size());
+		appendUint32( rt, bits);
+		std::vector<SimHash>::const_iterator ai = ar.begin(), ae = ar.end();
+		for (; ai != ae; ++ai)
+		{
+			if (ai->size() != bits) throw strus::runtime_error(_TXT("LSH values with different sizes in one block"));
+			appendUint32( rt, ai->id());
+		}
+		for (ai = ar.begin(); ai != ae; ++ai)
+		{
+			ai->appendPackedWords( rt);
+		}
+		return rt;
+	}
+
+private:
+	static uint32_t readUint32( const char* ptr)
+	{
+		uint32_t val;
+		std::memcpy( &val, ptr, sizeof(val));
+		return ByteOrder<uint32_t>::ntoh( val);
+	}
+	static void appendUint32( std::string& out, uint32_t val)
+	{
+		val = ByteOrder<uint32_t>::hton( val);
+		out.append( (const char*)&val, sizeof(val));
+	}
+
+private:
+	int m_nof;
+	int m_bits;
+	int m_arsize;
+	const char* m_featnoar;
+	const char* m_wordar;
+};
+
+/// \brief Forward walk over the feature numbers with an LSH value of a type in ascending order
+/// \note Visits only the keys in the layout SimHashLayoutKey and only the feature numbers of the blocks in the layout SimHashLayoutBlock, no LSH value or vector is decoded
+class FeatnoWalker
+{
+public:
+	FeatnoWalker( const DatabaseAdapter* database, SimHashLayout layout_, const Index& typeno_, ErrorBufferInterface* errorhnd)
+		:m_cursor(database->createCursor()),m_layout(layout_),m_typeno(typeno_),m_domainkeysize(0),m_blockfeatnos(),m_blockidx(0)
+	{
+		if (!m_cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), errorhnd->fetchError());
+	}
+
+	/// \brief Position the walk on the first feature with a number bigger than or equal to a feature number
+	/// \param[in] featno the feature number to start from, 0 for the start of the type
+	/// \return the feature number or 0 if there is none
+	Index seek( const Index& featno)
+	{
+		DatabaseKeyBuffer keyprefix( m_layout == SimHashLayoutBlock ? DatabaseAdapter::KeyFeatureSimHashBlock : DatabaseAdapter::KeyFeatureSimHash);
+		keyprefix[ m_typeno];
+		m_domainkeysize = keyprefix.size();
+
+		DatabaseCursorInterface::Slice key;
+		if (featno)
+		{
+			keyprefix[ m_layout == SimHashLayoutBlock ? DatabaseAdapter::simHashBlockno( featno) : featno];
+			key = m_cursor->seekUpperBound( keyprefix.c_str(), keyprefix.size(), m_domainkeysize);
+		}
+		else
+		{
+			key = m_cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
+		}
+		return m_layout == SimHashLayoutBlock ? seekBlock( key, featno) : keyFeatno( key);
+	}
+
+	/// \brief Get the next feature number of the walk
+	/// \return the feature number or 0 at the end of the type
+	Index next()
+	{
+		if (m_layout == SimHashLayoutBlock)
+		{
+			if (++m_blockidx < (int)m_blockfeatnos.size()) return m_blockfeatnos[ m_blockidx];
+			return seekBlock( m_cursor->seekNext(), 0);
+		}
+		return keyFeatno( m_cursor->seekNext());
+	}
+
+private:
+	Index keyFeatno( const DatabaseCursorInterface::Slice& key) const
+	{
+		if (!key.defined()) return 0;
+		Index rt;
+		DatabaseKeyScanner key_scanner( key.ptr()+m_domainkeysize, key.size()-m_domainkeysize);
+		key_scanner[ rt];
+		return rt;
+	}
+
+	Index seekBlock( DatabaseCursorInterface::Slice key, const Index& featno)
+	{
+		// ... copy the feature numbers of the block, the value slice is only valid until the next cursor move
+		m_blockfeatnos.clear();
+		m_blockidx = 0;
+		for (; key.defined(); key = m_cursor->seekNext())
+		{
+			Index blockno = keyFeatno( key);
+			DatabaseCursorInterface::Slice blob = m_cursor->value();
+			SimHashBlockView block( blob.ptr(), blob.size(), m_typeno, blockno);
+			int bi = featno ? block.upperBound( featno) : 0, be = block.size();
+			if (bi < be)
+			{
+				m_blockfeatnos.reserve( be - bi);
+				for (; bi < be; ++bi)
+				{
+					m_blockfeatnos.push_back( block.featno( bi));
+				}
+				return m_blockfeatnos[ 0];
+			}
+		}
+		return 0;
+	}
+
+private:
+	strus::local_ptr<DatabaseCursorInterface> m_cursor;
+	SimHashLayout m_layout;
+	Index m_typeno;
+	std::size_t m_domainkeysize;
+	std::vector<Index> m_blockfeatnos;	///< feature numbers of the current block from the position of the walk on
+	int m_blockidx;
+};
+
+DatabaseAdapter::Transaction::Transaction( DatabaseClientInterface* database, VectorEncoding vecenc_, KeyValueCache* nameCache_, CompactionScheduler* compactionScheduler_, ErrorBufferInterface* errorhnd_)
+	:m_errorhnd(errorhnd_),m_vecenc(vecenc_),m_transaction( database->createTransaction()),m_writeBuffer(),m_writeBufferSize(0)
+	,m_nameCache(nameCache_),m_nameCacheInvalidations(),m_nameCacheClear(false)
+	,m_compactionScheduler(compactionScheduler_),m_nofBytesWritten(0)
 {
 	if (!m_transaction.get())
 	{
@@ -51,18 +328,130 @@ DatabaseAdapter::Transaction::Transaction( DatabaseClientInterface* database, Er
 
 bool DatabaseAdapter::Transaction::commit()
 {
-	return m_transaction->commit();
+	flushWrites();
+	if (!m_transaction->commit()) return false;
+	if (m_nameCache)
+	{
+		if (m_nameCacheClear)
+		{
+			m_nameCache->clear();
+		}
+		else
+		{
+			m_nameCache->invalidate( m_nameCacheInvalidations);
+		}
+		m_nameCacheInvalidations.clear();
+		m_nameCacheClear = false;
+	}
+	if (m_compactionScheduler)
+	{
+		m_compactionScheduler->notifyWrites( m_nofBytesWritten);
+	}
+	m_nofBytesWritten = 0;
+	return true;
 }
 
 void DatabaseAdapter::Transaction::rollback()
 {
+	m_writeBuffer.clear();
+	m_writeBufferSize = 0;
+	m_nameCacheInvalidations.clear();
+	m_nameCacheClear = false;
+	m_nofBytesWritten = 0;
 	m_transaction->rollback();
 }
 
+void DatabaseAdapter::Transaction::write( const char* key, std::size_t keysize, const char* value, std::size_t valuesize)
+{
+	m_writeBuffer.push_back( KeyValue());
+	m_writeBuffer.back().key.append( key, keysize);
+	m_writeBuffer.back().value.append( value, valuesize);
+	m_writeBufferSize += keysize + valuesize;
+	m_nofBytesWritten += keysize + valuesize;
+	if (m_writeBufferSize > MaxWriteBufferSize)
+	{
+		flushWrites();
+	}
+}
+
+struct KeyValueRefOrder
+{
+	template <class KeyValueType>
+	bool operator()( const KeyValueType* a, const KeyValueType* b) const
+	{
+		return a->key < b->key;
+	}
+};
+
+void DatabaseAdapter::Transaction::flushWrites()
+{
+	// ... emit the writes ordered by key, the last write of a key wins
+	std::vector<const KeyValue*> order;
+	order.reserve( m_writeBuffer.size());
+	std::vector<KeyValue>::const_iterator wi = m_writeBuffer.begin(), we = m_writeBuffer.end();
+	for (; wi != we; ++wi)
+	{
+		order.push_back( &*wi);
+	}
+	std::stable_sort( order.begin(), order.end(), KeyValueRefOrder());
+
+	std::vector<const KeyValue*>::const_iterator oi = order.begin(), oe = order.end();
+	while (oi != oe)
+	{
+		std::vector<const KeyValue*>::const_iterator next = oi + 1;
+		if (next == oe || (*oi)->key != (*next)->key)
+		{
+			m_transaction->write( (*oi)->key.c_str(), (*oi)->key.size(), (*oi)->value.c_str(), (*oi)->value.size());
+			if (m_nameCache && isNameCacheKeyPrefix( (*oi)->key[0]))
+			{
+				m_nameCacheInvalidations.push_back( (*oi)->key);
+			}
+		}
+		oi = next;
+	}
+	m_writeBuffer.clear();
+	m_writeBufferSize = 0;
+}
+
+DatabaseAdapter::Transaction* DatabaseAdapter::createTransaction()
+{
+	if (m_frozen.get()) throw strus::runtime_error( _TXT("vector storage served from the frozen storage file %s is read only"), m_frozen->path().c_str());
+	return new Transaction( m_database.get(), m_vecenc, m_nameCache.get(), m_compactionScheduler.get(), m_errorhnd);
+}
+
+DatabaseCursorInterface* DatabaseAdapter::createCursor() const
+{
+	return m_frozen.get() ? m_frozen->createCursor() : m_database->createCursor( DatabaseOptions());
+}
+
+bool DatabaseAdapter::readDatabaseValue( const char* keystr, std::size_t keysize, std::string& blob, const DatabaseOptions& options) const
+{
+	return m_frozen.get() ? m_frozen->readValue( keystr, keysize, blob) : m_database->readValue( keystr, keysize, blob, options);
+}
+
+bool DatabaseAdapter::readValue( const char* keystr, std::size_t keysize, std::string& blob, const DatabaseOptions& options) const
+{
+	if (!m_nameCache.get() || !keysize || !isNameCacheKeyPrefix( keystr[0]))
+	{
+		return readDatabaseValue( keystr, keysize, blob, options);
+	}
+	std::string key( keystr, keysize);
+	bool found = false;
+	unsigned int ticket = 0;
+	if (m_nameCache->get( key, blob, found, ticket))
+	{
+		return found;
+	}
+	found = readDatabaseValue( keystr, keysize, blob, options);
+	if (!found && (m_errorhnd->hasError() || !isNameCacheMissKeyPrefix( keystr[0]))) return false;
+	m_nameCache->put( key, blob, found, ticket);
+	return found;
+}
+
 Index DatabaseAdapter::readIndexValue( const char* keystr, std::size_t keysize, bool errorIfNotFound) const
 {
 	std::string blob;
-	if (!m_database->readValue( keystr, keysize, blob, DatabaseOptions().useCache()))
+	if (!readValue( keystr, keysize, blob, DatabaseOptions().useCache()))
 	{
 		if (m_errorhnd->hasError())
 		{
@@ -83,19 +472,25 @@ Index DatabaseAdapter::readIndexValue( const char* keystr, std::size_t keysize,
 std::string DatabaseAdapter::readStringValue( const char* keystr, std::size_t keysize, bool errorIfNotFound) const
 {
 	std::string rt;
-	if (!m_database->readValue( keystr, keysize, rt, DatabaseOptions()))
+	if (!readStringValue( rt, keystr, keysize) && errorIfNotFound)
+	{
+		throw strus::runtime_error(_TXT("required key not found in vector database"));
+	}
+	return rt;
+}
+
+bool DatabaseAdapter::readStringValue( std::string& res, const char* keystr, std::size_t keysize) const
+{
+	if (!readValue( keystr, keysize, res, DatabaseOptions()))
 	{
 		if (m_errorhnd->hasError())
 		{
 			throw strus::runtime_error(_TXT("failed to read string value from vector database: %s"), m_errorhnd->fetchError());
 		}
-		if (errorIfNotFound)
-		{
-			throw strus::runtime_error(_TXT("required key not found in vector database"));
-		}
-		return std::string();
+		res.clear();
+		return false;
 	}
-	return rt;
+	return true;
 }
 
 template <typename ScalarType>
@@ -170,7 +565,7 @@ void DatabaseAdapter::Transaction::writeVariable( const std::string& name, const
 {
 	DatabaseKeyBuffer key( KeyVariable);
 	key( name);
-	m_transaction->write( key.c_str(), key.size(), value.c_str(), value.size());
+	write( key.c_str(), key.size(), value.c_str(), value.size());
 }
 
 std::string DatabaseAdapter::readVariable( const std::string& name) const
@@ -185,7 +580,7 @@ std::vector<DatabaseAdapter::VariableDef> DatabaseAdapter::readVariables() const
 	std::vector<VariableDef> rt;
 	DatabaseKeyBuffer keyprefix( KeyVariable);
 
-	strus::local_ptr<strus::DatabaseCursorInterface> cursor( m_database->createCursor( DatabaseOptions()));
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
 	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
 
 	DatabaseCursorInterface::Slice key = cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
@@ -202,7 +597,7 @@ std::vector<std::string> DatabaseAdapter::readTypes() const
 	std::vector<std::string> rt;
 	DatabaseKeyBuffer keyprefix( KeyFeatureTypePrefix);
 
-	strus::local_ptr<strus::DatabaseCursorInterface> cursor( m_database->createCursor( DatabaseOptions()));
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
 	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
 
 	DatabaseCursorInterface::Slice key = cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
@@ -221,12 +616,12 @@ void DatabaseAdapter::Transaction::writeType( const std::string& type, const Ind
 		key( type);
 		DatabaseValueBuffer buffer;
 		buffer[ typeno];
-		m_transaction->write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+		write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
 	}{
 		DatabaseKeyBuffer key( KeyFeatureTypeInvPrefix);
 		key[ typeno];
 		DatabaseValueBuffer buffer;
-		m_transaction->write( key.c_str(), key.size(), type.c_str(), type.size());
+		write( key.c_str(), key.size(), type.c_str(), type.size());
 	}
 }
 
@@ -251,12 +646,12 @@ void DatabaseAdapter::Transaction::writeFeature( const std::string& feature, con
 		key( feature);
 		DatabaseValueBuffer buffer;
 		buffer[ featno];
-		m_transaction->write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+		write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
 	}{
 		DatabaseKeyBuffer key( KeyFeatureValueInvPrefix);
 		key[ featno];
 		DatabaseValueBuffer buffer;
-		m_transaction->write( key.c_str(), key.size(), feature.c_str(), feature.size());
+		write( key.c_str(), key.size(), feature.c_str(), feature.size());
 	}
 }
 
@@ -274,8 +669,8 @@ std::string DatabaseAdapter::readFeatName( const Index& featno) const
 	return readStringValue( key.c_str(), key.size(), true);
 }
 
-DatabaseAdapter::FeatureCursor::FeatureCursor( const DatabaseClientInterface* database)
-	:m_cursor( database->createCursor( DatabaseOptions()))
+DatabaseAdapter::FeatureCursor::FeatureCursor( const DatabaseAdapter* database)
+	:m_cursor( database->createCursor())
 {}
 
 bool DatabaseAdapter::FeatureCursor::skip( const char* keyptr, std::size_t keysize, std::string& keyfound)
@@ -339,13 +734,42 @@ strus::Index DatabaseAdapter::FeatureCursor::getCurrentFeatureIndex() const
 	return rt;
 }
 
+DatabaseAdapter::VectorCursor::VectorCursor( const DatabaseAdapter* database, VectorEncoding vecenc_, const Index& typeno)
+	:m_cursor( database->createCursor()),m_vecenc(vecenc_),m_keyprefix()
+{
+	if (!m_cursor.get()) throw std::runtime_error( _TXT("error creating database cursor"));
+	DatabaseKeyBuffer keyprefix( KeyFeatureVector);
+	keyprefix[ typeno];
+	m_keyprefix.append( keyprefix.c_str(), keyprefix.size());
+}
+
+bool DatabaseAdapter::VectorCursor::getCurrent( const DatabaseCursorInterface::Slice& key, Index& featno, WordVector& vec)
+{
+	if (!key.defined()) return false;
+	DatabaseKeyScanner key_scanner( key.ptr()+m_keyprefix.size(), key.size()-m_keyprefix.size());
+	key_scanner[ featno];
+	DatabaseCursorInterface::Slice blob = m_cursor->value();
+	vec = vectorFromEncodedSerialization( blob.ptr(), blob.size(), m_vecenc);
+	return true;
+}
+
+bool DatabaseAdapter::VectorCursor::loadFirst( Index& featno, WordVector& vec)
+{
+	return getCurrent( m_cursor->seekFirst( m_keyprefix.c_str(), m_keyprefix.size()), featno, vec);
+}
+
+bool DatabaseAdapter::VectorCursor::loadNext( Index& featno, WordVector& vec)
+{
+	return getCurrent( m_cursor->seekNext(), featno, vec);
+}
+
 std::vector<Index> DatabaseAdapter::readFeatureTypeRelations( const Index& featno) const
 {
 	DatabaseKeyBuffer key( KeyFeatureTypeRelations);
 	key[ featno];
 
 	std::string blob;
-	if (!m_database->readValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
+	if (!readValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
 	{
 		if (m_errorhnd->hasError())
 		{
@@ -365,19 +789,137 @@ void DatabaseAdapter::Transaction::writeFeatureTypeRelations( const Index& featn
 	key[ featno];
 
 	std::string blob = vectorSerialization<Index>( typenolist);
-	m_transaction->write( key.c_str(), key.size(), blob.c_str(), blob.size());
+	write( key.c_str(), key.size(), blob.c_str(), blob.size());
+}
+
+Index DatabaseAdapter::readFeatnoSample( const Index& typeno, int sampleidx) const
+{
+	DatabaseKeyBuffer key( KeyFeatnoSample);
+	key[ typeno][ sampleidx];
+	return readIndexValue( key.c_str(), key.size(), false);
+}
+
+void DatabaseAdapter::Transaction::writeFeatnoSample( const Index& typeno, int sampleidx, const Index& featno)
+{
+	DatabaseKeyBuffer key( KeyFeatnoSample);
+	key[ typeno][ sampleidx];
+	DatabaseValueBuffer buffer;
+	buffer[ featno];
+	write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+}
+
+std::vector<DatabaseAdapter::FeatnoSample> DatabaseAdapter::calculateFeatnoSamples( const Index& typeno, const std::vector<Index>& newFeatnolist, bool cleared) const
+{
+	std::vector<FeatnoSample> rt;
+	if (newFeatnolist.empty()) return rt;
+
+	// ... find the last marker before the first feature inserted, the markers up to it stay valid
+	int startsample = 0;
+	Index featnostart = 0;
+	if (!cleared)
+	{
+		DatabaseKeyBuffer sampleprefix( KeyFeatnoSample);
+		sampleprefix[ typeno];
+		std::size_t sampledomainkeysize = sampleprefix.size();
+
+		strus::local_ptr<strus::DatabaseCursorInterface> samplecursor( createCursor());
+		if (!samplecursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
+		DatabaseCursorInterface::Slice key = samplecursor->seekFirst( sampleprefix.c_str(), sampleprefix.size());
+		for (; key.defined(); key = samplecursor->seekNext())
+		{
+			DatabaseValueScanner scanner( samplecursor->value());
+			Index featno = 0;
+			scanner[ featno];
+			if (featno >= newFeatnolist[0]) break;
+
+			DatabaseKeyScanner key_scanner( key.ptr()+sampledomainkeysize, key.size()-sampledomainkeysize);
+			key_scanner[ startsample];
+			featnostart = featno;
+		}
+	}
+	// ... merge the features stored after the marker with the ones inserted and set a marker at every interval
+	FeatnoWalker walker( this, m_simHashLayout, typeno, m_errorhnd);
+	Index storedFeatno = cleared ? 0 : walker.seek( featnostart);
+	int ordinal = startsample * m_featnoSampleInterval;
+	std::vector<Index>::const_iterator ni = newFeatnolist.begin(), ne = newFeatnolist.end();
+	for (;;)
+	{
+		Index featno;
+		if (ni != ne && (!storedFeatno || *ni < storedFeatno))
+		{
+			featno = *ni++;
+		}
+		else if (storedFeatno)
+		{
+			featno = storedFeatno;
+			storedFeatno = walker.next();
+		}
+		else
+		{
+			break;
+		}
+		if (ordinal > startsample * m_featnoSampleInterval && ordinal % m_featnoSampleInterval == 0)
+		{
+			rt.push_back( FeatnoSample( ordinal / m_featnoSampleInterval, featno));
+		}
+		++ordinal;
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to calculate position markers: %s"), m_errorhnd->fetchError());
+	}
+	return rt;
+}
+
+void DatabaseAdapter::updateFeatnoSamples( Transaction& transaction, const Index& typeno, const std::vector<Index>& newFeatnolist, bool cleared) const
+{
+	std::vector<FeatnoSample> samples = calculateFeatnoSamples( typeno, newFeatnolist, cleared);
+	std::vector<FeatnoSample>::const_iterator si = samples.begin(), se = samples.end();
+	for (; si != se; ++si)
+	{
+		transaction.writeFeatnoSample( typeno, si->sampleidx, si->featno);
+	}
 }
 
 Index DatabaseAdapter::readFeatnoStart( const Index& typeno, int idx) const
 {
+	// ... start the walk from the closest position marker before the ordinal
+	Index featnostart = 0;
+	int sampleidx = idx / m_featnoSampleInterval;
+	if (sampleidx > 0)
+	{
+		featnostart = readFeatnoSample( typeno, sampleidx);
+		if (featnostart)
+		{
+			idx -= sampleidx * m_featnoSampleInterval;
+		}
+		else if (readNofVectors( typeno) <= idx)
+		{
+			return 0;
+		}
+		//... else a storage created without position markers, walk from the start
+	}
+	if (m_simHashLayout == SimHashLayoutBlock)
+	{
+		return readFeatnoStartBlock( typeno, featnostart, idx);
+	}
 	DatabaseKeyBuffer keyprefix( KeyFeatureSimHash);
 	keyprefix[ typeno];
 	int domainkeysize = keyprefix.size();
 
-	strus::local_ptr<strus::DatabaseCursorInterface> cursor( m_database->createCursor( DatabaseOptions()));
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
 	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
 
-	DatabaseCursorInterface::Slice key = cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
+	DatabaseCursorInterface::Slice key;
+	if (featnostart)
+	{
+		keyprefix[ featnostart];
+		key = cursor->seekUpperBound( keyprefix.c_str(), keyprefix.size(), domainkeysize);
+	}
+	else
+	{
+		key = cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
+	}
 	for (; key.defined() && idx > 0; key = cursor->seekNext(),--idx){}
 	if (key.defined())
 	{
@@ -389,6 +931,40 @@ Index DatabaseAdapter::readFeatnoStart( const Index& typeno, int idx) const
 	return 0;
 }
 
+Index DatabaseAdapter::readFeatnoStartBlock( const Index& typeno, const Index& featnostart, int idx) const
+{
+	DatabaseKeyBuffer keyprefix( KeyFeatureSimHashBlock);
+	keyprefix[ typeno];
+	int domainkeysize = keyprefix.size();
+
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
+	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
+
+	// ... skip whole blocks by their number of elements instead of visiting every value
+	DatabaseCursorInterface::Slice key;
+	if (featnostart)
+	{
+		keyprefix[ simHashBlockno( featnostart)];
+		key = cursor->seekUpperBound( keyprefix.c_str(), keyprefix.size(), domainkeysize);
+	}
+	else
+	{
+		key = cursor->seekFirst( keyprefix.c_str(), keyprefix.size());
+	}
+	for (; key.defined(); key = cursor->seekNext())
+	{
+		Index blockno;
+		DatabaseKeyScanner key_scanner( key.ptr()+domainkeysize, key.size()-domainkeysize);
+		key_scanner[ blockno];
+		DatabaseCursorInterface::Slice blob = cursor->value();
+		SimHashBlockView block( blob.ptr(), blob.size(), typeno, blockno);
+		int startidx = featnostart ? block.upperBound( featnostart) : 0;
+		if (idx < block.size() - startidx) return block.featno( startidx + idx);
+		idx -= block.size() - startidx;
+	}
+	return 0;
+}
+
 Index DatabaseAdapter::readNofTypeno() const
 {
 	DatabaseKeyBuffer key( KeyNofTypeno);
@@ -400,7 +976,7 @@ void DatabaseAdapter::Transaction::writeNofTypeno( const Index& typeno)
 	DatabaseKeyBuffer key( KeyNofTypeno);
 	DatabaseValueBuffer buffer;
 	buffer[ typeno];
-	m_transaction->write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+	write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
 }
 
 Index DatabaseAdapter::readNofFeatno() const
@@ -414,7 +990,7 @@ void DatabaseAdapter::Transaction::writeNofFeatno( const Index& featno)
 	DatabaseKeyBuffer key( KeyNofFeatno);
 	DatabaseValueBuffer buffer;
 	buffer[ featno];
-	m_transaction->write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+	write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
 }
 
 int DatabaseAdapter::readNofVectors( const Index& typeno) const
@@ -430,27 +1006,33 @@ void DatabaseAdapter::Transaction::writeNofVectors( const Index& typeno, const I
 	key[ typeno];
 	DatabaseValueBuffer buffer;
 	buffer[ nofVectors];
-	m_transaction->write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
+	write( key.c_str(), key.size(), buffer.c_str(), buffer.size());
 }
 
 WordVector DatabaseAdapter::readVector( const Index& typeno, const Index& featno) const
+{
+	WordVector rt;
+	std::string blob;
+	readVector( rt, blob, typeno, featno);
+	return rt;
+}
+
+bool DatabaseAdapter::readVector( WordVector& res, std::string& blob, const Index& typeno, const Index& featno) const
 {
 	DatabaseKeyBuffer key( KeyFeatureVector);
 	key[ typeno][ featno];
 
-	std::string blob;
-	if (!m_database->readValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
+	if (!readDatabaseValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
 	{
 		if (m_errorhnd->hasError())
 		{
 			throw strus::runtime_error(_TXT("failed to read feature vector: %s"), m_errorhnd->fetchError());
 		}
-		else
-		{
-			return WordVector();
-		}
+		res.clear();
+		return false;
 	}
-	return vectorFromSerialization<float>( blob);
+	vectorFromEncodedSerialization( res, blob.c_str(), blob.size(), m_vecenc);
+	return true;
 }
 
 void DatabaseAdapter::Transaction::writeVector( const Index& typeno, const Index& featno, const WordVector& vec)
@@ -458,37 +1040,71 @@ void DatabaseAdapter::Transaction::writeVector( const Index& typeno, const Index
 	DatabaseKeyBuffer key( KeyFeatureVector);
 	key[ typeno][ featno];
 
-	std::string blob( vectorSerialization<float>( vec));
-	m_transaction->write( key.c_str(), key.size(), blob.c_str(), blob.size());
+	std::string blob( vectorEncodedSerialization( vec, m_vecenc));
+	write( key.c_str(), key.size(), blob.c_str(), blob.size());
 }
 
 SimHash DatabaseAdapter::readSimHash( const Index& typeno, const Index& featno) const
 {
+	SimHash rt;
+	std::string blob;
+	readSimHash( rt, blob, typeno, featno);
+	return rt;
+}
+
+bool DatabaseAdapter::readSimHash( SimHash& res, std::string& blob, const Index& typeno, const Index& featno) const
+{
+	if (m_simHashLayout == SimHashLayoutBlock)
+	{
+		Index blockno = simHashBlockno( featno);
+		DatabaseKeyBuffer key( KeyFeatureSimHashBlock);
+		key[ typeno][ blockno];
+
+		if (!readDatabaseValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
+		{
+			if (m_errorhnd->hasError())
+			{
+				throw strus::runtime_error(_TXT("failed to read LSH values: %s"), m_errorhnd->fetchError());
+			}
+			res = SimHash();
+			return false;
+		}
+		SimHashBlockView block( blob.c_str(), blob.size(), typeno, blockno);
+		int idx = block.find( featno);
+		if (idx < 0)
+		{
+			res = SimHash();
+			return false;
+		}
+		block.get( res, idx);
+		return true;
+	}
 	DatabaseKeyBuffer key( KeyFeatureSimHash);
 	key[ typeno][ featno];
 
-	std::string blob;
-	if (!m_database->readValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
+	if (!readDatabaseValue( key.c_str(), key.size(), blob, DatabaseOptions().useCache()))
 	{
 		if (m_errorhnd->hasError())
 		{
 			throw strus::runtime_error(_TXT("failed to read feature vector: %s"), m_errorhnd->fetchError());
 		}
-		else
-		{
-			return SimHash();
-		}
+		res = SimHash();
+		return false;
 	}
-	SimHash rt = SimHash::fromSerialization( blob);
-	if (rt.id() != featno)
+	SimHash::fromSerialization( res, blob.c_str(), blob.size());
+	if (res.id() != featno)
 	{
 		throw strus::runtime_error(_TXT("corrupt data in vector stored for type %d, value %d"), typeno, featno);
 	}
-	return rt;
+	return true;
 }
 
 std::vector<SimHash> DatabaseAdapter::readSimHashVector( const Index& typeno, const Index& featnostart, int numberOfResults) const
 {
+	if (m_simHashLayout == SimHashLayoutBlock)
+	{
+		return readSimHashVectorBlocks( typeno, featnostart, numberOfResults);
+	}
 	DatabaseKeyBuffer keyprefix( KeyFeatureSimHash);
 	keyprefix[ typeno];
 	unsigned int domainkeysize = keyprefix.size();
@@ -496,7 +1112,7 @@ std::vector<SimHash> DatabaseAdapter::readSimHashVector( const Index& typeno, co
 
 	std::vector<SimHash> rt;
 
-	strus::local_ptr<strus::DatabaseCursorInterface> cursor( m_database->createCursor( DatabaseOptions()));
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
 	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
 
 	DatabaseCursorInterface::Slice key = cursor->seekUpperBound( keyprefix.c_str(), keyprefix.size(), domainkeysize);
@@ -515,11 +1131,395 @@ std::vector<SimHash> DatabaseAdapter::readSimHashVector( const Index& typeno, co
 	return rt;
 }
 
+std::vector<SimHash> DatabaseAdapter::readSimHashVectorBlocks( const Index& typeno, const Index& featnostart, int numberOfResults) const
+{
+	DatabaseKeyBuffer keyprefix( KeyFeatureSimHashBlock);
+	keyprefix[ typeno];
+	unsigned int domainkeysize = keyprefix.size();
+	keyprefix[ simHashBlockno( featnostart)];
+
+	std::vector<SimHash> rt;
+
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( createCursor());
+	if (!cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), m_errorhnd->fetchError());
+
+	DatabaseCursorInterface::Slice key = cursor->seekUpperBound( keyprefix.c_str(), keyprefix.size(), domainkeysize);
+	for (; key.defined() && numberOfResults > 0; key = cursor->seekNext())
+	{
+		Index blockno;
+		DatabaseKeyScanner key_scanner( key.ptr()+domainkeysize, key.size()-domainkeysize);
+		key_scanner[ blockno];
+		DatabaseCursorInterface::Slice blob = cursor->value();
+		SimHashBlockView block( blob.ptr(), blob.size(), typeno, blockno);
+
+		int bi = block.upperBound( featnostart), be = block.size();
+		for (; bi < be && numberOfResults > 0; ++bi,--numberOfResults)
+		{
+			rt.push_back( block.get( bi));
+		}
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to read LSH values: %s"), m_errorhnd->fetchError());
+	}
+	return rt;
+}
+
+DatabaseAdapter::SimHashCursor::SimHashCursor( const DatabaseAdapter* database_, SimHashLayout layout_, const Index& typeno_)
+	:m_cursor( database_->createCursor()),m_layout(layout_),m_typeno(typeno_),m_keyprefix(),m_defined(false),m_block(),m_blockidx(0)
+{
+	if (!m_cursor.get()) throw std::runtime_error( _TXT("error creating database cursor"));
+	DatabaseKeyBuffer keyprefix( m_layout == SimHashLayoutBlock ? KeyFeatureSimHashBlock : KeyFeatureSimHash);
+	keyprefix[ m_typeno];
+	m_keyprefix.append( keyprefix.c_str(), keyprefix.size());
+}
+
+void DatabaseAdapter::SimHashCursor::setCurrent( const DatabaseCursorInterface::Slice& key)
+{
+	m_defined = key.defined();
+	if (m_defined && m_layout == SimHashLayoutBlock)
+	{
+		// ... the block is copied, because the value of the cursor is only valid until it is moved
+		DatabaseCursorInterface::Slice blob = m_cursor->value();
+		m_block.assign( blob.ptr(), blob.size());
+		m_blockidx = 0;
+	}
+}
+
+bool DatabaseAdapter::SimHashCursor::loadFirst( std::vector<SimHash>& buf, std::size_t maxsize)
+{
+	setCurrent( m_cursor->seekFirst( m_keyprefix.c_str(), m_keyprefix.size()));
+	return loadNext( buf, maxsize);
+}
+
+bool DatabaseAdapter::SimHashCursor::loadNext( std::vector<SimHash>& buf, std::size_t maxsize)
+{
+	buf.clear();
+	while (m_defined && buf.size() < maxsize)
+	{
+		if (m_layout == SimHashLayoutBlock)
+		{
+			SimHashBlockView block( m_block.c_str(), m_block.size(), m_typeno, 0);
+			for (; m_blockidx < block.size() && buf.size() < maxsize; ++m_blockidx)
+			{
+				buf.push_back( block.get( m_blockidx));
+			}
+			if (m_blockidx < block.size()) break;
+		}
+		else
+		{
+			DatabaseCursorInterface::Slice blob = m_cursor->value();
+			buf.push_back( SimHash::fromSerialization( blob.ptr(), blob.size()));
+		}
+		setCurrent( m_cursor->seekNext());
+	}
+	return !buf.empty();
+}
+
 std::vector<SimHash> DatabaseAdapter::readSimHashVector( const Index& typeno) const
 {
 	return readSimHashVector( typeno, 1, std::numeric_limits<int>::max());
 }
 
+/// \brief Cursor to visit the values of features of a type in ascending order of the feature numbers with one forward sweep
+class SortedFeatureValueCursor
+{
+public:
+	SortedFeatureValueCursor( const DatabaseAdapter* database, ErrorBufferInterface* errorhnd, DatabaseAdapter::KeyPrefix prefix, const Index& typeno)
+		:m_cursor( database->createCursor()),m_keyprefix( prefix),m_domainkeysize(0),m_featno(0),m_seekno(0),m_positioned(false)
+	{
+		if (!m_cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), errorhnd->fetchError());
+		m_keyprefix[ typeno];
+		m_domainkeysize = m_keyprefix.size();
+	}
+	/// \brief Constructor for a key space with the feature number as only key element
+	SortedFeatureValueCursor( const DatabaseAdapter* database, ErrorBufferInterface* errorhnd, DatabaseAdapter::KeyPrefix prefix)
+		:m_cursor( database->createCursor()),m_keyprefix( prefix),m_domainkeysize(0),m_featno(0),m_seekno(0),m_positioned(false)
+	{
+		if (!m_cursor.get()) throw strus::runtime_error(_TXT("failed to create database cursor: %s"), errorhnd->fetchError());
+		m_domainkeysize = m_keyprefix.size();
+	}
+
+	/// \brief Position the cursor on the value of a feature
+	/// \return true if the value was found
+	bool seek( const Index& featno)
+	{
+		if (!m_positioned || featno < m_seekno)
+		{
+			seekUpperBound( featno);
+		}
+		else
+		{
+			// ... for features close to the current position some steps forward are cheaper than a new seek
+			for (int si=0; si < MaxSeekNextSteps && m_featno && m_featno < featno; ++si)
+			{
+				setCurrent( m_cursor->seekNext());
+			}
+			if (m_featno && m_featno < featno)
+			{
+				seekUpperBound( featno);
+			}
+		}
+		m_seekno = featno;
+		return m_featno == featno;
+	}
+
+	DatabaseCursorInterface::Slice value() const
+	{
+		return m_cursor->value();
+	}
+
+private:
+	void seekUpperBound( const Index& featno)
+	{
+		DatabaseKeyBuffer key( m_keyprefix);
+		key[ featno];
+		setCurrent( m_cursor->seekUpperBound( key.c_str(), key.size(), m_domainkeysize));
+		m_positioned = true;
+	}
+
+	void setCurrent( const DatabaseCursorInterface::Slice& key)
+	{
+		if (key.defined())
+		{
+			DatabaseKeyScanner key_scanner( key.ptr()+m_domainkeysize, key.size()-m_domainkeysize);
+			key_scanner[ m_featno];
+		}
+		else
+		{
+			m_featno = 0;
+		}
+	}
+
+private:
+	enum {MaxSeekNextSteps=8};
+	strus::local_ptr<DatabaseCursorInterface> m_cursor;
+	DatabaseKeyBuffer m_keyprefix;
+	std::size_t m_domainkeysize;
+	Index m_featno;
+	Index m_seekno;
+	bool m_positioned;
+};
+
+struct FeatnoIndexOrder
+{
+	explicit FeatnoIndexOrder( const std::vector<Index>& featnolist_)
+		:featnolist(&featnolist_){}
+
+	bool operator()( std::size_t a, std::size_t b) const
+	{
+		return (*featnolist)[ a] < (*featnolist)[ b];
+	}
+
+	const std::vector<Index>* featnolist;
+};
+
+std::vector<std::string> DatabaseAdapter::readFeatNames( const std::vector<Index>& featnolist) const
+{
+	std::vector<std::string> rt( featnolist.size());
+	if (featnolist.empty()) return rt;
+
+	// ... visit the features in ascending order, duplicates are read once
+	std::vector<std::size_t> order;
+	order.reserve( featnolist.size());
+	for (std::size_t fidx=0; fidx < featnolist.size(); ++fidx)
+	{
+		order.push_back( fidx);
+	}
+	std::sort( order.begin(), order.end(), FeatnoIndexOrder( featnolist));
+
+	// ... the names found in the cache are taken from there, only the misses are read with one ordered sweep
+	std::vector<std::size_t> misses;
+	std::vector<unsigned int> tickets;
+	std::vector<std::size_t>::const_iterator oi = order.begin(), oe = order.end();
+	for (; oi != oe; ++oi)
+	{
+		const Index featno = featnolist[ *oi];
+		if (oi != order.begin() && featnolist[ *(oi-1)] == featno) continue;
+		if (m_nameCache.get())
+		{
+			DatabaseKeyBuffer key( KeyFeatureValueInvPrefix);
+			key[ featno];
+			bool found = false;
+			unsigned int ticket = 0;
+			if (m_nameCache->get( std::string( key.c_str(), key.size()), rt[ *oi], found, ticket))
+			{
+				if (!found) throw strus::runtime_error(_TXT("required key not found in vector database"));
+				continue;
+			}
+			tickets.push_back( ticket);
+		}
+		misses.push_back( *oi);
+	}
+	if (!misses.empty())
+	{
+		SortedFeatureValueCursor cursor( this, m_errorhnd, KeyFeatureValueInvPrefix);
+		std::vector<std::size_t>::const_iterator mi = misses.begin(), me = misses.end();
+		for (int midx=0; mi != me; ++mi,++midx)
+		{
+			const Index featno = featnolist[ *mi];
+			if (cursor.seek( featno))
+			{
+				rt[ *mi] = cursor.value().tostring();
+				if (m_nameCache.get())
+				{
+					DatabaseKeyBuffer key( KeyFeatureValueInvPrefix);
+					key[ featno];
+					m_nameCache->put( std::string( key.c_str(), key.size()), rt[ *mi], true, tickets[ midx]);
+				}
+			}
+			else
+			{
+				if (m_errorhnd->hasError()) break;
+				throw strus::runtime_error(_TXT("required key not found in vector database"));
+			}
+		}
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to read feature names: %s"), m_errorhnd->fetchError());
+	}
+	// ... the duplicates get the name of their first occurrence
+	for (oi = order.begin(); oi != oe; ++oi)
+	{
+		if (oi != order.begin() && featnolist[ *(oi-1)] == featnolist[ *oi])
+		{
+			rt[ *oi] = rt[ *(oi-1)];
+		}
+	}
+	return rt;
+}
+
+std::vector<WordVector> DatabaseAdapter::readVectors( const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	std::vector<WordVector> rt;
+	readVectors( rt, typeno, featnolist);
+	return rt;
+}
+
+void DatabaseAdapter::readVectors( std::vector<WordVector>& res, const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	res.resize( featnolist.size());
+	if (featnolist.empty()) return;
+
+	SortedFeatureValueCursor cursor( this, m_errorhnd, KeyFeatureVector, typeno);
+	std::vector<WordVector>::iterator ri = res.begin();
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	for (; fi != fe; ++fi,++ri)
+	{
+		if (cursor.seek( *fi))
+		{
+			DatabaseCursorInterface::Slice blob = cursor.value();
+			vectorFromEncodedSerialization( *ri, blob.ptr(), blob.size(), m_vecenc);
+		}
+		else
+		{
+			ri->clear();
+		}
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to read feature vectors: %s"), m_errorhnd->fetchError());
+	}
+}
+
+std::vector<SimHash> DatabaseAdapter::readSimHashes( const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	std::vector<SimHash> rt;
+	readSimHashes( rt, typeno, featnolist);
+	return rt;
+}
+
+void DatabaseAdapter::readSimHashes( std::vector<SimHash>& res, const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	res.resize( featnolist.size());
+	if (featnolist.empty()) return;
+	std::vector<SimHash>::iterator ri = res.begin();
+	if (m_simHashLayout == SimHashLayoutBlock)
+	{
+		// ... the block of the previous feature is kept, sorted feature lists read every block once
+		Index blockno = 0;
+		std::string blob;
+		SimHashBlockView block;
+		std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+		for (; fi != fe; ++fi,++ri)
+		{
+			Index fi_blockno = simHashBlockno( *fi);
+			if (fi_blockno != blockno)
+			{
+				blockno = fi_blockno;
+				DatabaseKeyBuffer key( KeyFeatureSimHashBlock);
+				key[ typeno][ blockno];
+				if (readDatabaseValue( key.c_str(), key.size(), blob, DatabaseOptions()))
+				{
+					block = SimHashBlockView( blob.c_str(), blob.size(), typeno, blockno);
+				}
+				else
+				{
+					block = SimHashBlockView();
+				}
+			}
+			int idx = block.find( *fi);
+			if (idx < 0)
+			{
+				*ri = SimHash();
+			}
+			else
+			{
+				block.get( *ri, idx);
+			}
+		}
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("failed to read LSH values: %s"), m_errorhnd->fetchError());
+		}
+		return;
+	}
+	SortedFeatureValueCursor cursor( this, m_errorhnd, KeyFeatureSimHash, typeno);
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	for (; fi != fe; ++fi,++ri)
+	{
+		if (cursor.seek( *fi))
+		{
+			DatabaseCursorInterface::Slice blob = cursor.value();
+			SimHash::fromSerialization( *ri, blob.ptr(), blob.size());
+			if (ri->id() != *fi)
+			{
+				throw strus::runtime_error(_TXT("corrupt data in vector stored for type %d, value %d"), typeno, *fi);
+			}
+		}
+		else
+		{
+			*ri = SimHash();
+		}
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to read LSH values: %s"), m_errorhnd->fetchError());
+	}
+}
+
+std::vector<Index> DatabaseAdapter::readFeatnosWithVector( const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	std::vector<Index> rt;
+	if (featnolist.empty()) return rt;
+
+	SortedFeatureValueCursor cursor( this, m_errorhnd, KeyFeatureVector, typeno);
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	for (; fi != fe; ++fi)
+	{
+		if (cursor.seek( *fi))
+		{
+			rt.push_back( *fi);
+		}
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to probe feature vectors: %s"), m_errorhnd->fetchError());
+	}
+	return rt;
+}
+
 void DatabaseAdapter::Transaction::writeSimHash( const Index& typeno, const Index& featno, const SimHash& hash)
 {
 	if (hash.id() != featno)
@@ -530,17 +1530,76 @@ void DatabaseAdapter::Transaction::writeSimHash( const Index& typeno, const Inde
 	key[ typeno][ featno];
 
 	std::string blob = hash.serialization();
-	m_transaction->write( key.c_str(), key.size(), blob.c_str(), blob.size());
+	write( key.c_str(), key.size(), blob.c_str(), blob.size());
+}
+
+std::vector<SimHash> DatabaseAdapter::readSimHashBlock( const Index& typeno, const Index& blockno) const
+{
+	std::vector<SimHash> rt;
+	DatabaseKeyBuffer key( KeyFeatureSimHashBlock);
+	key[ typeno][ blockno];
+
+	std::string blob;
+	if (!readDatabaseValue( key.c_str(), key.size(), blob, DatabaseOptions()))
+	{
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("failed to read LSH values: %s"), m_errorhnd->fetchError());
+		}
+		return rt;
+	}
+	SimHashBlockView block( blob.c_str(), blob.size(), typeno, blockno);
+	rt.reserve( block.size());
+	int bi = 0, be = block.size();
+	for (; bi != be; ++bi)
+	{
+		rt.push_back( block.get( bi));
+	}
+	return rt;
+}
+
+void DatabaseAdapter::Transaction::writeSimHashBlock( const Index& typeno, const Index& blockno, const std::vector<SimHash>& ar)
+{
+	DatabaseKeyBuffer key( KeyFeatureSimHashBlock);
+	key[ typeno][ blockno];
+	if (ar.empty())
+	{
+		flushWrites();
+		m_transaction->remove( key.c_str(), key.size());
+		return;
+	}
+	std::vector<SimHash>::const_iterator ai = ar.begin(), ae = ar.end();
+	for (; ai != ae; ++ai)
+	{
+		if (simHashBlockno( ai->id()) != blockno)
+		{
+			throw strus::runtime_error(_TXT("try to store SimHash for type %d, value %d in block %d"), typeno, ai->id(), blockno);
+		}
+	}
+	std::string blob = SimHashBlockView::serialization( ar);
+	write( key.c_str(), key.size(), blob.c_str(), blob.size());
 }
 
 void DatabaseAdapter::close()
 {
-	m_database->compactDatabase();
-	m_database->close();
+	std::string compactionError;
+	if (m_compactionScheduler.get())
+	{
+		compactionError = m_compactionScheduler->stop();
+	}
+	if (m_database.get())
+	{
+		m_database->close();
+	}
+	if (!compactionError.empty())
+	{
+		throw strus::runtime_error( _TXT("compaction of the database in the background failed: %s"), compactionError.c_str());
+	}
 }
 
 void DatabaseAdapter::compaction()
 {
+	if (m_frozen.get()) throw strus::runtime_error( _TXT("vector storage served from the frozen storage file %s is read only"), m_frozen->path().c_str());
 	m_database->compactDatabase();
 }
 
@@ -550,7 +1609,7 @@ LshModel DatabaseAdapter::readLshModel() const
 	DatabaseKeyBuffer key( KeyLshModel);
 	
 	std::string content;
-	if (!m_database->readValue( key.c_str(), key.size(), content, DatabaseOptions()))
+	if (!readDatabaseValue( key.c_str(), key.size(), content, DatabaseOptions()))
 	{
 		if (m_errorhnd->hasError())
 		{
@@ -569,11 +1628,13 @@ void DatabaseAdapter::Transaction::writeLshModel( const LshModel& model)
 	DatabaseKeyBuffer key( KeyLshModel);	
 	std::string content( model.serialization());
 
-	m_transaction->write( key.c_str(), key.size(), content.c_str(), content.size());
+	write( key.c_str(), key.size(), content.c_str(), content.size());
 }
 
 void DatabaseAdapter::Transaction::deleteSubTree( const KeyPrefix& prefix)
 {
+	flushWrites();
+	if (isNameCacheKeyPrefix( prefix)) m_nameCacheClear = true;
 	DatabaseKeyBuffer key( prefix);
 	m_transaction->removeSubTree( key.c_str(), key.size());
 }
@@ -587,10 +1648,12 @@ void DatabaseAdapter::Transaction::clear()
 	deleteSubTree( KeyFeatureValueInvPrefix);
 	deleteSubTree( KeyFeatureVector);
 	deleteSubTree( KeyFeatureSimHash);
+	deleteSubTree( KeyFeatureSimHashBlock);
 	deleteSubTree( KeyNofVectors);
 	deleteSubTree( KeyNofTypeno);
 	deleteSubTree( KeyNofFeatno);
 	deleteSubTree( KeyFeatureTypeRelations);
+	deleteSubTree( KeyFeatnoSample);
 }
 
 struct DatabaseKeyNameTab
@@ -611,6 +1674,8 @@ struct DatabaseKeyNameTab
 		ar[ DatabaseAdapter::KeyNofFeatno - 32] = "noffeatno";
 		ar[ DatabaseAdapter::KeyLshModel - 32] = "lshmodel";
 		ar[ DatabaseAdapter::KeyFeatureTypeRelations - 32] = "firel";
+		ar[ DatabaseAdapter::KeyFeatureSimHashBlock - 32] = "simhashblock";
+		ar[ DatabaseAdapter::KeyFeatnoSample - 32] = "featnosample";
 	}
 	const char* operator[]( DatabaseAdapter::KeyPrefix i) const
 	{
@@ -654,7 +1719,7 @@ void DatabaseAdapter::DumpIterator::dumpKeyValue( std::ostream& out, const strus
 			DatabaseKeyScanner scanner( key.ptr()+1,key.size()-1);
 			Index typeno, featno;
 			scanner[ typeno][ featno];
-			WordVector vec = vectorFromSerialization<float>( value.ptr(), value.size());
+			WordVector vec = vectorFromEncodedSerialization( value.ptr(), value.size(), m_vecenc);
 			WordVector::const_iterator vi = vec.begin(), ve = vec.end();
 			for (int vidx=0; vi!=ve; ++vi,++vidx)
 			{
@@ -675,6 +1740,19 @@ void DatabaseAdapter::DumpIterator::dumpKeyValue( std::ostream& out, const strus
 			out << typeno << " " << featno << " " << hash.tostring() << std::endl;
 			break;
 		}
+		case DatabaseAdapter::KeyFeatureSimHashBlock:
+		{
+			DatabaseKeyScanner scanner( key.ptr()+1,key.size()-1);
+			Index typeno, blockno;
+			scanner[ typeno][ blockno];
+			SimHashBlockView block( value.ptr(), value.size(), typeno, blockno);
+			int bi = 0, be = block.size();
+			for (; bi != be; ++bi)
+			{
+				out << typeno << " " << block.featno( bi) << " " << block.get( bi).tostring() << std::endl;
+			}
+			break;
+		}
 		case DatabaseAdapter::KeyNofVectors:
 		{
 			DatabaseKeyScanner keyscanner( key.ptr()+1,key.size()-1);
@@ -686,6 +1764,17 @@ void DatabaseAdapter::DumpIterator::dumpKeyValue( std::ostream& out, const strus
 			out << no << " " << idx << std::endl;
 			break;
 		}
+		case DatabaseAdapter::KeyFeatnoSample:
+		{
+			DatabaseKeyScanner keyscanner( key.ptr()+1,key.size()-1);
+			Index typeno, sampleidx;
+			keyscanner[ typeno][ sampleidx];
+			DatabaseValueScanner valscanner( value);
+			Index featno = 0;
+			valscanner[ featno];
+			out << typeno << " " << sampleidx << " " << featno << std::endl;
+			break;
+		}
 		case DatabaseAdapter::KeyNofTypeno:
 		case DatabaseAdapter::KeyNofFeatno:
 		{
@@ -723,19 +1812,19 @@ void DatabaseAdapter::DumpIterator::dumpKeyValue( std::ostream& out, const strus
 	}
 }
 
-DatabaseAdapter::DumpIterator::DumpIterator( const DatabaseClientInterface* database, ErrorBufferInterface* errorhnd_)
-	:m_errorhnd(errorhnd_),m_cursor(database->createCursor( DatabaseOptions())),m_keyidx(0),m_first(true)
+DatabaseAdapter::DumpIterator::DumpIterator( const DatabaseAdapter* database, VectorEncoding vecenc_, ErrorBufferInterface* errorhnd_)
+	:m_errorhnd(errorhnd_),m_vecenc(vecenc_),m_cursor(database->createCursor()),m_keyidx(0),m_first(true)
 {
 	if (!m_cursor.get()) throw std::runtime_error( _TXT("error creating database cursor"));
 }
 
 bool DatabaseAdapter::DumpIterator::dumpNext( std::ostream& out)
 {
-	enum {NofKeyPrefixes=12};
+	enum {NofKeyPrefixes=14};
 	static const KeyPrefix order[NofKeyPrefixes] = {
 						KeyVariable,KeyFeatureTypePrefix,KeyFeatureValuePrefix,KeyFeatureTypeInvPrefix,
-						KeyFeatureValueInvPrefix,KeyFeatureVector,KeyFeatureSimHash,KeyNofVectors,
-						KeyNofTypeno,KeyNofFeatno,KeyLshModel,KeyFeatureTypeRelations
+						KeyFeatureValueInvPrefix,KeyFeatureVector,KeyFeatureSimHash,KeyFeatureSimHashBlock,KeyNofVectors,
+						KeyFeatnoSample,KeyNofTypeno,KeyNofFeatno,KeyLshModel,KeyFeatureTypeRelations
 					};
 	for (;;)
 	{
@@ -12,13 +12,18 @@
 #include "strus/databaseClientInterface.hpp"
 #include "strus/databaseTransactionInterface.hpp"
 #include "strus/databaseCursorInterface.hpp"
+#include "strus/storage/databaseOptions.hpp"
 #include "strus/storage/wordVector.hpp"
 #include "strus/reference.hpp"
 #include "strus/storage/index.hpp"
 #include "strus/base/stdint.h"
 #include "simHash.hpp"
 #include "lshModel.hpp"
+#include "vectorEncoding.hpp"
 #include "stringList.hpp"
+#include "keyValueCache.hpp"
+#include "compactionScheduler.hpp"
+#include "frozenStorage.hpp"
 #include <vector>
 #include <string>
 #include <iostream>
@@ -28,15 +33,73 @@ namespace strus {
 /// \brief Forward declaration
 class ErrorBufferInterface;
 
+/// \brief Layout of the LSH values stored, defined on storage creation
+enum SimHashLayout
+{
+	SimHashLayoutKey,		///< one key per LSH value
+	SimHashLayoutBlock		///< LSH values packed into blocks of a fixed range of feature numbers for fast sequential loading
+};
+
+/// \brief Get the name of a layout of the LSH values as used in the configuration
+const char* simHashLayoutName( SimHashLayout layout);
+/// \brief Get the layout of the LSH values from its name in the configuration
+SimHashLayout simHashLayoutFromName( const std::string& name);
+
 class DatabaseAdapter
 {
 public:
-	DatabaseAdapter( const DatabaseInterface* database_, const std::string& config, ErrorBufferInterface* errorhnd_);
+	enum {SimHashBlockSize=4096};	///< range of feature numbers of a block of LSH values in the layout SimHashLayoutBlock
+	enum {FeatnoSampleInterval=65536};	///< default distance in ordinals of the position markers of the features of a type, used if not defined on storage creation
+
+	/// \brief Constructor
+	/// \param[in] nameCacheSize_ maximum number of entries of the cache for the name resolution and the feature type relations, 0 for no cache
+	/// \param[in] compactionWriteThreshold_ number of bytes committed triggering a compaction in the background, 0 for compaction only on explicit request
+	/// \param[in] compactionMinInterval_ minimum number of seconds between two compactions in the background
+	DatabaseAdapter( const DatabaseInterface* database_, const std::string& config, ErrorBufferInterface* errorhnd_, std::size_t nameCacheSize_=0, std::size_t compactionWriteThreshold_=0, unsigned int compactionMinInterval_=0);
+	/// \brief Constructor for a read-only storage served from a frozen storage file without the key/value database
+	/// \param[in] nameCacheSize_ maximum number of entries of the cache for the name resolution and the feature type relations, 0 for no cache
+	DatabaseAdapter( const Reference<FrozenStorage>& frozen_, ErrorBufferInterface* errorhnd_, std::size_t nameCacheSize_=0);
 	DatabaseAdapter( const DatabaseAdapter& o);
 	~DatabaseAdapter(){}
 
 	void checkVersion();
 
+	/// \brief Get the encoding of the vectors stored, defined on storage creation
+	VectorEncoding vectorEncoding() const
+	{
+		return m_vecenc;
+	}
+	/// \brief Get the layout of the LSH values stored, defined on storage creation
+	SimHashLayout simHashLayout() const
+	{
+		return m_simHashLayout;
+	}
+	/// \brief Get the distance in ordinals of the position markers of the features of a type, defined on storage creation
+	int featnoSampleInterval() const
+	{
+		return m_featnoSampleInterval;
+	}
+	/// \brief Evaluate if the storage is served from a frozen storage file and is read only
+	bool isFrozen() const
+	{
+		return m_frozen.get() != 0;
+	}
+	/// \brief Get the statistics of the cache for the name resolution and the feature type relations
+	KeyValueCache::Statistics nameCacheStatistics() const
+	{
+		return m_nameCache.get() ? m_nameCache->statistics() : KeyValueCache::Statistics();
+	}
+	/// \brief Get the statistics of the compaction in the background
+	CompactionScheduler::Statistics compactionStatistics() const
+	{
+		return m_compactionScheduler.get() ? m_compactionScheduler->statistics() : CompactionScheduler::Statistics();
+	}
+	/// \brief Get the number of the block of LSH values of a feature in the layout SimHashLayoutBlock
+	static Index simHashBlockno( const Index& featno)
+	{
+		return (featno-1) / SimHashBlockSize + 1;
+	}
+
 	typedef std::pair<std::string,std::string> VariableDef;
 	std::vector<VariableDef> readVariables() const;
 	std::string readVariable( const std::string& name) const;
@@ -49,11 +112,15 @@ public:
 	strus::Index readFeatno( const std::string& feature) const;
 	std::string readTypeName( const Index& typeno) const;
 	std::string readFeatName( const Index& featno) const;
+	/// \brief Get the names of a list of features with one forward cursor sweep over the keys in ascending order of the feature numbers
+	/// \param[in] featnolist list of feature numbers in any order
+	/// \return the names in the order of featnolist
+	std::vector<std::string> readFeatNames( const std::vector<Index>& featnolist) const;
 
 	class FeatureCursor
 	{
 	public:
-		explicit FeatureCursor( const DatabaseClientInterface* database_);
+		explicit FeatureCursor( const DatabaseAdapter* database_);
 		FeatureCursor( const FeatureCursor& o)
 			:m_cursor(o.m_cursor){}
 		bool skip( const char* keyptr, std::size_t keysize, std::string& keyfound);
@@ -69,23 +136,119 @@ public:
 		Reference<DatabaseCursorInterface> m_cursor;
 	};
 
+	class VectorCursor
+	{
+	public:
+		VectorCursor( const DatabaseAdapter* database_, VectorEncoding vecenc_, const Index& typeno_);
+		VectorCursor( const VectorCursor& o)
+			:m_cursor(o.m_cursor),m_vecenc(o.m_vecenc),m_keyprefix(o.m_keyprefix){}
+		bool loadFirst( Index& featno, WordVector& vec);
+		bool loadNext( Index& featno, WordVector& vec);
+
+	private:
+		bool getCurrent( const DatabaseCursorInterface::Slice& key, Index& featno, WordVector& vec);
+
+	private:
+		Reference<DatabaseCursorInterface> m_cursor;
+		VectorEncoding m_vecenc;
+		std::string m_keyprefix;
+	};
+
+	/// \brief Cursor for one linear pass over the LSH values of a type in ascending order of the feature numbers
+	class SimHashCursor
+	{
+	public:
+		SimHashCursor( const DatabaseAdapter* database_, SimHashLayout layout_, const Index& typeno_);
+		/// \brief Load the first values
+		/// \param[out] buf buffer filled with the values loaded, its previous content is discarded
+		/// \param[in] maxsize maximum number of values to load
+		/// \return false if there are no values left
+		bool loadFirst( std::vector<SimHash>& buf, std::size_t maxsize);
+		/// \brief Load the values following the ones loaded by the previous call
+		/// \param[out] buf buffer filled with the values loaded, its previous content is discarded
+		/// \param[in] maxsize maximum number of values to load
+		/// \return false if there are no values left
+		bool loadNext( std::vector<SimHash>& buf, std::size_t maxsize);
+
+	private:
+		void setCurrent( const DatabaseCursorInterface::Slice& key);
+
+	private:
+		Reference<DatabaseCursorInterface> m_cursor;
+		SimHashLayout m_layout;
+		Index m_typeno;
+		std::string m_keyprefix;
+		bool m_defined;			///< false if the end of the values is reached
+		std::string m_block;		///< current block of values in the layout SimHashLayoutBlock
+		int m_blockidx;			///< index of the next value in the current block
+	};
+
 	std::vector<Index> readFeatureTypeRelations( const Index& featno) const;
 	int readNofVectors( const Index& typeno) const;
+	/// \brief Get the feature number of the vector with a given ordinal (0-based) in ascending order of the feature numbers of a type
+	/// \note Starts the walk from the closest position marker before the ordinal
+	/// \return the feature number or 0 if the ordinal is out of range
 	Index readFeatnoStart( const Index& typeno, int idx) const;
+	/// \brief Get the feature number of a position marker of a type, the feature with the ordinal sampleidx*featnoSampleInterval()
+	/// \return the feature number or 0 if the marker does not exist
+	Index readFeatnoSample( const Index& typeno, int sampleidx) const;
 
 	WordVector readVector( const Index& typeno, const Index& featno) const;
 	SimHash readSimHash( const Index& typeno, const Index& featno) const;
+	/// \brief Read the vector of a feature into a vector reused by the caller
+	/// \param[out] res the vector read, its memory is reused, empty if not found
+	/// \param[in,out] blob buffer for the value read, reused by the caller for subsequent reads
+	/// \return true if found
+	bool readVector( WordVector& res, std::string& blob, const Index& typeno, const Index& featno) const;
+	/// \brief Read the LSH value of a feature into a value reused by the caller
+	/// \param[out] res the LSH value read, its array is reused if it has the same size, undefined if not found
+	/// \param[in,out] blob buffer for the value read, reused by the caller for subsequent reads
+	/// \return true if found
+	bool readSimHash( SimHash& res, std::string& blob, const Index& typeno, const Index& featno) const;
 	std::vector<SimHash> readSimHashVector( const Index& typeno, const Index& featnostart, int numberOfResults) const;
 	std::vector<SimHash> readSimHashVector( const Index& typeno) const;
 
+	/// \brief Read the vectors of a list of features of a type with one forward cursor sweep
+	/// \param[in] featnolist list of feature numbers, expected to be sorted in ascending order
+	/// \return the vectors in the order of featnolist, an empty vector for a feature not found
+	std::vector<WordVector> readVectors( const Index& typeno, const std::vector<Index>& featnolist) const;
+	/// \brief Read the vectors of a list of features of a type into a list reused by the caller
+	/// \param[out] res the vectors in the order of featnolist, the memory of the elements is reused
+	void readVectors( std::vector<WordVector>& res, const Index& typeno, const std::vector<Index>& featnolist) const;
+	/// \brief Read the LSH values of a list of features of a type with one forward cursor sweep
+	/// \param[in] featnolist list of feature numbers, expected to be sorted in ascending order
+	/// \return the LSH values in the order of featnolist, an undefined LSH value for a feature not found
+	std::vector<SimHash> readSimHashes( const Index& typeno, const std::vector<Index>& featnolist) const;
+	/// \brief Read the LSH values of a list of features of a type into a list reused by the caller
+	/// \param[out] res the LSH values in the order of featnolist, the arrays of the elements are reused
+	void readSimHashes( std::vector<SimHash>& res, const Index& typeno, const std::vector<Index>& featnolist) const;
+	/// \brief Get the features of a list that have a vector of a type stored, with one forward cursor sweep over the keys without reading the vectors
+	/// \param[in] featnolist list of feature numbers, expected to be sorted in ascending order
+	/// \return the subset of featnolist with a vector stored
+	std::vector<Index> readFeatnosWithVector( const Index& typeno, const std::vector<Index>& featnolist) const;
+	/// \brief Read the LSH values of a block in the layout SimHashLayoutBlock
+	/// \return the LSH values of the block sorted by feature number, empty if the block does not exist
+	std::vector<SimHash> readSimHashBlock( const Index& typeno, const Index& blockno) const;
+
 	LshModel readLshModel() const;
 
+	/// \brief Stop the compaction in the background and close the database without compacting it
 	void close();
+	/// \brief Compact the database explicitly
 	void compaction();
 
 private:
 	Index readIndexValue( const char* keystr, std::size_t keysize, bool errorIfNotFound) const;
 	std::string readStringValue( const char* keystr, std::size_t keysize, bool errorIfNotFound) const;
+	/// \brief Read a string value into a buffer reused by the caller
+	/// \return true if found, res cleared if not found
+	bool readStringValue( std::string& res, const char* keystr, std::size_t keysize) const;
+	/// \brief Read a value, through the name cache if the key is of a key space cached
+	bool readValue( const char* keystr, std::size_t keysize, std::string& blob, const DatabaseOptions& options) const;
+	/// \brief Read a value from the frozen storage file or from the database
+	bool readDatabaseValue( const char* keystr, std::size_t keysize, std::string& blob, const DatabaseOptions& options) const;
+	Index readFeatnoStartBlock( const Index& typeno, const Index& featnostart, int idx) const;
+	std::vector<SimHash> readSimHashVectorBlocks( const Index& typeno, const Index& featnostart, int numberOfResults) const;
 
 public:
 	enum KeyPrefix
@@ -101,13 +264,31 @@ public:
 		KeyNofTypeno='Y',			///< []                        ->  [nof]
 		KeyNofFeatno='Z',			///< []                        ->  [nof]
 		KeyLshModel = 'L',			///< []                        ->  [dim,bits,variations,matrix...]
-		KeyFeatureTypeRelations = 'R' 		///< [featno]                  ->  [typeno...]
+		KeyFeatureTypeRelations = 'R', 		///< [featno]                  ->  [typeno...]
+		KeyFeatureSimHashBlock = 'B',		///< [typeno,blockno]          ->  [nof,bits,featno...,words...]
+		KeyFeatnoSample = 'P'			///< [typeno,sampleidx]        ->  [featno]
 	};
 
+	/// \brief Evaluate if the values of a key space are held in the name cache
+	static bool isNameCacheKeyPrefix( char prefix)
+	{
+		return prefix == KeyFeatureTypePrefix || prefix == KeyFeatureValuePrefix
+			|| prefix == KeyFeatureTypeInvPrefix || prefix == KeyFeatureValueInvPrefix
+			|| prefix == KeyFeatureTypeRelations;
+	}
+	/// \brief Evaluate if the information that a key of a key space does not exist is held in the name cache
+	/// \note The names of types and features are defined by other clients of the database too, their commits do not invalidate the name cache of this client, a name not found has to be looked up in the database again
+	static bool isNameCacheMissKeyPrefix( char prefix)
+	{
+		return prefix != KeyFeatureTypePrefix && prefix != KeyFeatureValuePrefix;
+	}
+
 	class Transaction
 	{
 	public:
-		Transaction( DatabaseClientInterface* database, ErrorBufferInterface* errorhnd_);
+		/// \param[in] nameCache_ name cache to invalidate the keys written on commit or NULL
+		/// \param[in] compactionScheduler_ scheduler to notify about the bytes written on commit or NULL
+		Transaction( DatabaseClientInterface* database, VectorEncoding vecenc_, KeyValueCache* nameCache_, CompactionScheduler* compactionScheduler_, ErrorBufferInterface* errorhnd_);
 
 		void writeVersion();
 		void writeVariable( const std::string& name, const std::string& value);
@@ -119,9 +300,13 @@ public:
 		void writeNofTypeno( const Index& typeno);
 		void writeNofFeatno( const Index& featno);
 		void writeNofVectors( const Index& typeno, const Index& nofVectors);
+		void writeFeatnoSample( const Index& typeno, int sampleidx, const Index& featno);
 
 		void writeVector( const Index& typeno, const Index& featno, const WordVector& vec);
 		void writeSimHash( const Index& typeno, const Index& featno, const SimHash& hash);
+		/// \brief Write a block of LSH values in the layout SimHashLayoutBlock
+		/// \param[in] ar all LSH values of the block sorted by feature number, the block is deleted if empty
+		void writeSimHashBlock( const Index& typeno, const Index& blockno, const std::vector<SimHash>& ar);
 
 		void writeLshModel( const LshModel& model);
 
@@ -130,23 +315,70 @@ public:
 		bool commit();
 		void rollback();
 
+		/// \brief Emit the buffered writes sorted by key to the database transaction
+		/// \note Allows a caller to do the sorting of the bulk of the writes outside of a critical section
+		void flushWrites();
+
 	private:
 		void deleteSubTree( const KeyPrefix& prefix);
+		/// \brief Buffer a write to be emitted in key order on commit or when the buffer is full
+		void write( const char* key, std::size_t keysize, const char* value, std::size_t valuesize);
 
 	private:
+		enum {MaxWriteBufferSize=(64<<20)};		///< maximum size in bytes of the keys and values buffered before writing a sorted batch
+
+		struct KeyValue
+		{
+			std::string key;
+			std::string value;
+
+			KeyValue()
+				:key(),value(){}
+		};
+
 		ErrorBufferInterface* m_errorhnd;
+		VectorEncoding m_vecenc;
 		Reference<DatabaseTransactionInterface> m_transaction;
+		std::vector<KeyValue> m_writeBuffer;
+		std::size_t m_writeBufferSize;
+		KeyValueCache* m_nameCache;
+		std::vector<std::string> m_nameCacheInvalidations;	///< keys written that are invalidated in the name cache on commit
+		bool m_nameCacheClear;					///< true if a key space of the name cache is deleted and the whole name cache is invalidated on commit
+		CompactionScheduler* m_compactionScheduler;
+		std::size_t m_nofBytesWritten;				///< size of the keys and values written since the last commit or rollback
 	};
 
-	Transaction* createTransaction()
+	Transaction* createTransaction();
+
+	/// \brief Position marker of a type, the feature with the ordinal sampleidx*featnoSampleInterval()
+	struct FeatnoSample
 	{
-		return new Transaction( m_database.get(), m_errorhnd);
-	}
+		int sampleidx;
+		Index featno;
+
+		FeatnoSample( int sampleidx_, const Index& featno_)
+			:sampleidx(sampleidx_),featno(featno_){}
+		FeatnoSample( const FeatnoSample& o)
+			:sampleidx(o.sampleidx),featno(o.featno){}
+	};
+	/// \brief Calculate the position markers of a type changed by the insertion of new vectors from the vectors committed
+	/// \param[in] newFeatnolist features of the vectors inserted, sorted in ascending order, without the ones already stored
+	/// \param[in] cleared true if the storage is cleared by the transaction, the vectors stored are not considered then
+	/// \return the markers to write
+	/// \note Only the markers following the first feature inserted are recalculated, for new features appended this is a walk over the tail after the last marker
+	/// \note The walk visits the keys of the LSH values (or the feature numbers of their blocks), the vectors are not read
+	/// \note The result is only valid as long as no other vectors of the type are committed
+	std::vector<FeatnoSample> calculateFeatnoSamples( const Index& typeno, const std::vector<Index>& newFeatnolist, bool cleared) const;
+	/// \brief Write the position markers of a type changed by the insertion of new vectors
+	/// \param[in] transaction transaction to write the markers to
+	/// \param[in] newFeatnolist features of the vectors inserted, sorted in ascending order, without the ones already stored
+	/// \param[in] cleared true if the storage is cleared by the transaction, the vectors stored are not considered then
+	void updateFeatnoSamples( Transaction& transaction, const Index& typeno, const std::vector<Index>& newFeatnolist, bool cleared) const;
 
 	class DumpIterator
 	{
 	public:
-		DumpIterator( const DatabaseClientInterface* database, ErrorBufferInterface* errorhnd_);
+		DumpIterator( const DatabaseAdapter* database, VectorEncoding vecenc_, ErrorBufferInterface* errorhnd_);
 
 		bool dumpNext( std::ostream& out);
 
@@ -155,6 +387,7 @@ public:
 
 	private:
 		ErrorBufferInterface* m_errorhnd;
+		VectorEncoding m_vecenc;
 		Reference<DatabaseCursorInterface> m_cursor;
 		int m_keyidx;
 		bool m_first;
@@ -162,16 +395,20 @@ public:
 
 	DumpIterator* createDumpIterator() const
 	{
-		return new DumpIterator( m_database.get(), m_errorhnd);
-	}
-	const DatabaseClientInterface* database() const
-	{
-		return m_database.get();
+		return new DumpIterator( this, m_vecenc, m_errorhnd);
 	}
+	/// \brief Create a cursor on the frozen storage file or on the database
+	DatabaseCursorInterface* createCursor() const;
 
 private:
 	Reference<DatabaseClientInterface> m_database;
+	Reference<FrozenStorage> m_frozen;		///< frozen storage file the storage is served from instead of the database or NULL
 	ErrorBufferInterface* m_errorhnd;
+	VectorEncoding m_vecenc;
+	SimHashLayout m_simHashLayout;
+	int m_featnoSampleInterval;			///< distance in ordinals of the position markers of the features of a type
+	Reference<KeyValueCache> m_nameCache;
+	Reference<CompactionScheduler> m_compactionScheduler;
 };
 
 
@@ -0,0 +1,413 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Read-only image of a vector storage in a single memory mapped file
+#include "frozenStorage.hpp"
+#include "strus/databaseClientInterface.hpp"
+#include "strus/storage/databaseOptions.hpp"
+#include "strus/base/hton.hpp"
+#include "strus/base/local_ptr.hpp"
+#include "internationalization.hpp"
+#include <vector>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace strus;
+
+#define FROZEN_STORAGE_MAGIC "strusvfz"
+enum {FrozenStorageMagicSize=8, FrozenStorageVersion=1, NofPrefixTableElements=257};
+
+/// \brief Header of the file: magic, version, padding, number of entries, offset of the index, offset of the prefix table
+struct FrozenStorageHeader
+{
+	char magic[ FrozenStorageMagicSize];
+	uint32_t version;
+	uint32_t reserved;
+	uint64_t nofEntries;
+	uint64_t indexOffset;
+	uint64_t prefixTableOffset;
+};
+
+static uint32_t getUint32( const char* ptr)
+{
+	uint32_t nval;
+	std::memcpy( &nval, ptr, sizeof(nval));
+	return ByteOrder<uint32_t>::ntoh( nval);
+}
+
+static void appendUint32( std::string& buf, uint32_t val)
+{
+	uint32_t nval = ByteOrder<uint32_t>::hton( val);
+	buf.append( (const char*)&nval, sizeof(nval));
+}
+
+static int compareKeys( const char* k1, std::size_t k1size, const char* k2, std::size_t k2size)
+{
+	int cmp = std::memcmp( k1, k2, k1size < k2size ? k1size : k2size);
+	if (cmp) return cmp;
+	return k1size < k2size ? -1 : (k1size > k2size ? 1 : 0);
+}
+
+static bool startsWith( const DatabaseCursorInterface::Slice& key, const std::string& prefix)
+{
+	return key.size() >= prefix.size() && 0==std::memcmp( key.ptr(), prefix.c_str(), prefix.size());
+}
+
+FrozenStorage::FrozenStorage( const std::string& path_)
+	:m_path(path_),m_base(0),m_filesize(0),m_entriesEnd(0),m_nofEntries(0),m_index(0),m_prefixTable(0)
+{
+	int fd = ::open( m_path.c_str(), O_RDONLY);
+	if (fd < 0) throw strus::runtime_error( _TXT("failed to open frozen vector storage %s: %s"), m_path.c_str(), ::strerror(errno));
+	struct stat st;
+	if (::fstat( fd, &st) != 0)
+	{
+		int ec = errno;
+		::close( fd);
+		throw strus::runtime_error( _TXT("failed to get size of frozen vector storage %s: %s"), m_path.c_str(), ::strerror(ec));
+	}
+	m_filesize = st.st_size;
+	if (m_filesize < sizeof(FrozenStorageHeader))
+	{
+		::close( fd);
+		throw strus::runtime_error( _TXT("file %s is not a frozen vector storage"), m_path.c_str());
+	}
+	void* ptr = ::mmap( NULL, m_filesize, PROT_READ, MAP_SHARED, fd, 0);
+	int ec = errno;
+	::close( fd);
+	if (ptr == MAP_FAILED) throw strus::runtime_error( _TXT("failed to map frozen vector storage %s into memory: %s"), m_path.c_str(), ::strerror(ec));
+	m_base = (const char*)ptr;
+
+	const FrozenStorageHeader* header = (const FrozenStorageHeader*)m_base;
+	uint64_t indexOffset = ByteOrder<uint64_t>::ntoh( header->indexOffset);
+	uint64_t prefixTableOffset = ByteOrder<uint64_t>::ntoh( header->prefixTableOffset);
+	m_nofEntries = ByteOrder<uint64_t>::ntoh( header->nofEntries);
+	if (0!=std::memcmp( header->magic, FROZEN_STORAGE_MAGIC, FrozenStorageMagicSize)
+	||	ByteOrder<uint32_t>::ntoh( header->version) != FrozenStorageVersion
+	||	indexOffset % sizeof(uint64_t) != 0 || prefixTableOffset % sizeof(uint64_t) != 0
+	||	indexOffset < sizeof(FrozenStorageHeader) || indexOffset > m_filesize || prefixTableOffset > m_filesize
+	||	m_nofEntries > (m_filesize - indexOffset) / sizeof(uint64_t)
+	||	indexOffset + m_nofEntries * sizeof(uint64_t) > prefixTableOffset
+	||	prefixTableOffset + NofPrefixTableElements * sizeof(uint64_t) > m_filesize)
+	{
+		::munmap( (void*)m_base, m_filesize);
+		throw strus::runtime_error( _TXT("file %s is not a frozen vector storage of version %d"), m_path.c_str(), (int)FrozenStorageVersion);
+	}
+	m_entriesEnd = indexOffset;
+	m_index = (const uint64_t*)(m_base + indexOffset);
+	m_prefixTable = (const uint64_t*)(m_base + prefixTableOffset);
+
+	// ... the prefix table has to be ascending and within the index, the entry offsets of the index are checked on access
+	uint64_t prev = 0;
+	for (int pi=0; pi < NofPrefixTableElements; ++pi)
+	{
+		uint64_t idx = ByteOrder<uint64_t>::ntoh( m_prefixTable[ pi]);
+		if (idx < prev || idx > m_nofEntries || (pi == 0 && idx != 0) || (pi == NofPrefixTableElements-1 && idx != m_nofEntries))
+		{
+			::munmap( (void*)m_base, m_filesize);
+			m_base = 0;
+			throw strus::runtime_error( _TXT("frozen vector storage %s is corrupt: %s"), m_path.c_str(), _TXT("invalid prefix table"));
+		}
+		prev = idx;
+	}
+}
+
+FrozenStorage::~FrozenStorage()
+{
+	if (m_base) ::munmap( (void*)m_base, m_filesize);
+}
+
+const char* FrozenStorage::entry( std::size_t idx) const
+{
+	// ... an entry has to be completely within the area of the entries between the header and the index
+	uint64_t ofs = ByteOrder<uint64_t>::ntoh( m_index[ idx]);
+	if (ofs < sizeof(FrozenStorageHeader) || ofs > m_entriesEnd || m_entriesEnd - ofs < 2*sizeof(uint32_t))
+	{
+		throw strus::runtime_error( _TXT("frozen vector storage %s is corrupt: %s"), m_path.c_str(), _TXT("entry offset out of range"));
+	}
+	const char* ent = m_base + ofs;
+	uint64_t entrysize = (uint64_t)2*sizeof(uint32_t) + getUint32( ent) + getUint32( ent + sizeof(uint32_t));
+	if (m_entriesEnd - ofs < entrysize)
+	{
+		throw strus::runtime_error( _TXT("frozen vector storage %s is corrupt: %s"), m_path.c_str(), _TXT("entry size out of range"));
+	}
+	return ent;
+}
+
+DatabaseCursorInterface::Slice FrozenStorage::key( std::size_t idx) const
+{
+	const char* ent = entry( idx);
+	return DatabaseCursorInterface::Slice( ent + 2*sizeof(uint32_t), getUint32( ent));
+}
+
+DatabaseCursorInterface::Slice FrozenStorage::value( std::size_t idx) const
+{
+	const char* ent = entry( idx);
+	uint32_t keysize = getUint32( ent);
+	return DatabaseCursorInterface::Slice( ent + 2*sizeof(uint32_t) + keysize, getUint32( ent + sizeof(uint32_t)));
+}
+
+std::size_t FrozenStorage::prefixEnd( unsigned char prefix) const
+{
+	return ByteOrder<uint64_t>::ntoh( m_prefixTable[ (std::size_t)prefix + 1]);
+}
+
+std::size_t FrozenStorage::lowerBound( const char* keyptr, std::size_t keysize) const
+{
+	// ... the search is restricted to the range of the first byte of the key with the prefix table
+	std::size_t lo = 0, hi = m_nofEntries;
+	if (keysize)
+	{
+		unsigned char prefix = (unsigned char)keyptr[0];
+		lo = ByteOrder<uint64_t>::ntoh( m_prefixTable[ prefix]);
+		hi = prefixEnd( prefix);
+	}
+	while (lo < hi)
+	{
+		std::size_t mid = lo + (hi - lo) / 2;
+		DatabaseCursorInterface::Slice midkey = key( mid);
+		if (compareKeys( midkey.ptr(), midkey.size(), keyptr, keysize) < 0)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid;
+		}
+	}
+	return lo;
+}
+
+bool FrozenStorage::readValue( const char* keyptr, std::size_t keysize, std::string& res) const
+{
+	std::size_t idx = lowerBound( keyptr, keysize);
+	if (idx >= m_nofEntries) return false;
+	DatabaseCursorInterface::Slice found = key( idx);
+	if (0!=compareKeys( found.ptr(), found.size(), keyptr, keysize)) return false;
+	DatabaseCursorInterface::Slice val = value( idx);
+	res.assign( val.ptr(), val.size());
+	return true;
+}
+
+/// \brief Cursor on a frozen storage with the semantics of a database cursor restricted to a domain (key prefix) or an upper bound key
+class FrozenStorageCursor
+	:public DatabaseCursorInterface
+{
+public:
+	explicit FrozenStorageCursor( const FrozenStorage* storage_)
+		:m_storage(storage_),m_idx(0),m_defined(false),m_domainkey(),m_upkey(),m_hasUpkey(false){}
+	virtual ~FrozenStorageCursor(){}
+
+	virtual Slice seekUpperBound( const char* key, std::size_t keysize, std::size_t domainkeysize)
+	{
+		m_domainkey.assign( key, domainkeysize);
+		m_hasUpkey = false;
+		return position( m_storage->lowerBound( key, keysize));
+	}
+
+	virtual Slice seekUpperBoundRestricted( const char* key, std::size_t keysize, const char* upkey, std::size_t upkeysize)
+	{
+		m_domainkey.clear();
+		m_upkey.assign( upkey, upkeysize);
+		m_hasUpkey = true;
+		return position( m_storage->lowerBound( key, keysize));
+	}
+
+	virtual Slice seekFirst( const char* domainkey, std::size_t domainkeysize)
+	{
+		m_domainkey.assign( domainkey, domainkeysize);
+		m_hasUpkey = false;
+		return position( m_storage->lowerBound( domainkey, domainkeysize));
+	}
+
+	virtual Slice seekLast( const char* domainkey, std::size_t domainkeysize)
+	{
+		m_domainkey.assign( domainkey, domainkeysize);
+		m_hasUpkey = false;
+		// ... the last key with the domain prefix is before the first key bigger than all keys with the prefix
+		std::string upkey( m_domainkey);
+		while (!upkey.empty() && (unsigned char)upkey[ upkey.size()-1] == 0xFF) upkey.resize( upkey.size()-1);
+		std::size_t end;
+		if (upkey.empty())
+		{
+			end = m_storage->size();
+		}
+		else
+		{
+			upkey[ upkey.size()-1] = (char)((unsigned char)upkey[ upkey.size()-1] + 1);
+			end = m_storage->lowerBound( upkey.c_str(), upkey.size());
+		}
+		if (end == 0) return undefine();
+		return position( end-1);
+	}
+
+	virtual Slice seekNext()
+	{
+		if (!m_defined) return Slice();
+		return position( m_idx+1);
+	}
+
+	virtual Slice seekPrev()
+	{
+		if (!m_defined || m_idx == 0) return undefine();
+		return position( m_idx-1);
+	}
+
+	virtual Slice key() const
+	{
+		return m_defined ? m_storage->key( m_idx) : Slice();
+	}
+
+	virtual Slice value() const
+	{
+		return m_defined ? m_storage->value( m_idx) : Slice();
+	}
+
+private:
+	Slice position( std::size_t idx)
+	{
+		if (idx >= m_storage->size()) return undefine();
+		Slice rt = m_storage->key( idx);
+		if (!startsWith( rt, m_domainkey)) return undefine();
+		if (m_hasUpkey && compareKeys( rt.ptr(), rt.size(), m_upkey.c_str(), m_upkey.size()) >= 0) return undefine();
+		m_idx = idx;
+		m_defined = true;
+		return rt;
+	}
+
+	Slice undefine()
+	{
+		m_defined = false;
+		return Slice();
+	}
+
+private:
+	const FrozenStorage* m_storage;
+	std::size_t m_idx;
+	bool m_defined;
+	std::string m_domainkey;
+	std::string m_upkey;
+	bool m_hasUpkey;
+};
+
+DatabaseCursorInterface* FrozenStorage::createCursor() const
+{
+	return new FrozenStorageCursor( this);
+}
+
+/// \brief Output file of an export
+class FrozenStorageOutput
+{
+public:
+	explicit FrozenStorageOutput( const std::string& path_)
+		:m_path(path_),m_file(::fopen( path_.c_str(), "wb")),m_pos(0)
+	{
+		if (!m_file) throw strus::runtime_error( _TXT("failed to open file %s for writing the frozen vector storage: %s"), m_path.c_str(), ::strerror(errno));
+	}
+	~FrozenStorageOutput()
+	{
+		if (m_file) ::fclose( m_file);
+	}
+
+	void write( const char* ptr, std::size_t size)
+	{
+		if (size != ::fwrite( ptr, 1, size, m_file))
+		{
+			throw strus::runtime_error( _TXT("failed to write frozen vector storage %s: %s"), m_path.c_str(), ::strerror(errno));
+		}
+		m_pos += size;
+	}
+	void writeUint64Array( const std::vector<uint64_t>& ar)
+	{
+		std::vector<uint64_t>::const_iterator ai = ar.begin(), ae = ar.end();
+		for (; ai != ae; ++ai)
+		{
+			uint64_t nval = ByteOrder<uint64_t>::hton( *ai);
+			write( (const char*)&nval, sizeof(nval));
+		}
+	}
+	void alignTo( std::size_t alignment)
+	{
+		static const char padding[ sizeof(uint64_t)] = {0,0,0,0,0,0,0,0};
+		std::size_t rest = m_pos % alignment;
+		if (rest) write( padding, alignment - rest);
+	}
+	void writeHeaderAndClose( const FrozenStorageHeader& header)
+	{
+		if (0!=::fseek( m_file, 0, SEEK_SET))
+		{
+			throw strus::runtime_error( _TXT("failed to write frozen vector storage %s: %s"), m_path.c_str(), ::strerror(errno));
+		}
+		if (1 != ::fwrite( &header, sizeof(header), 1, m_file))
+		{
+			throw strus::runtime_error( _TXT("failed to write frozen vector storage %s: %s"), m_path.c_str(), ::strerror(errno));
+		}
+		int rt = ::fclose( m_file);
+		m_file = 0;
+		if (rt) throw strus::runtime_error( _TXT("failed to close frozen vector storage %s: %s"), m_path.c_str(), ::strerror(errno));
+	}
+	std::size_t pos() const
+	{
+		return m_pos;
+	}
+
+private:
+	std::string m_path;
+	FILE* m_file;
+	std::size_t m_pos;
+};
+
+std::size_t FrozenStorage::exportDatabase( const DatabaseClientInterface* database, const std::string& path)
+{
+	strus::local_ptr<DatabaseCursorInterface> cursor( database->createCursor( DatabaseOptions()));
+	if (!cursor.get()) throw std::runtime_error( _TXT("error creating database cursor"));
+
+	FrozenStorageOutput output( path);
+	FrozenStorageHeader header;
+	std::memset( &header, 0, sizeof(header));
+	output.write( (const char*)&header, sizeof(header));
+
+	std::vector<uint64_t> index;
+	std::vector<uint64_t> prefixTable;
+	prefixTable.reserve( NofPrefixTableElements);
+	std::string entryhdr;
+	for (unsigned int prefix=0; prefix <= 0xFF; ++prefix)
+	{
+		prefixTable.push_back( index.size());
+		char domainkey = (char)(unsigned char)prefix;
+		DatabaseCursorInterface::Slice key = cursor->seekFirst( &domainkey, 1);
+		for (; key.defined(); key = cursor->seekNext())
+		{
+			DatabaseCursorInterface::Slice value = cursor->value();
+			index.push_back( output.pos());
+			entryhdr.clear();
+			appendUint32( entryhdr, key.size());
+			appendUint32( entryhdr, value.size());
+			output.write( entryhdr.c_str(), entryhdr.size());
+			output.write( key.ptr(), key.size());
+			output.write( value.ptr(), value.size());
+		}
+	}
+	prefixTable.push_back( index.size());
+
+	output.alignTo( sizeof(uint64_t));
+	std::memcpy( header.magic, FROZEN_STORAGE_MAGIC, FrozenStorageMagicSize);
+	header.version = ByteOrder<uint32_t>::hton( FrozenStorageVersion);
+	header.nofEntries = ByteOrder<uint64_t>::hton( index.size());
+	header.indexOffset = ByteOrder<uint64_t>::hton( output.pos());
+	output.writeUint64Array( index);
+	header.prefixTableOffset = ByteOrder<uint64_t>::hton( output.pos());
+	output.writeUint64Array( prefixTable);
+	output.writeHeaderAndClose( header);
+	return index.size();
+}
+
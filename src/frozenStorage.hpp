@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Read-only image of a vector storage in a single memory mapped file
+#ifndef _STRUS_VECTOR_FROZEN_STORAGE_HPP_INCLUDED
+#define _STRUS_VECTOR_FROZEN_STORAGE_HPP_INCLUDED
+#include "strus/databaseCursorInterface.hpp"
+#include "strus/base/stdint.h"
+#include <string>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Forward declaration
+class DatabaseClientInterface;
+
+/// \brief Read-only image of all key/value pairs of a vector storage in a single file, memory mapped and accessed without parsing
+/// \note The file consists of a header, the entries [keysize,valuesize,key,value] sorted by key, an index with the offsets of the entries
+///		and a table with the index of the first entry of every possible first byte of a key (the key prefixes of the storage),
+///		with all numbers in network byte order. The LSH model, the dictionaries of types and features, the LSH values,
+///		the vectors and the feature type relations are all stored as the key/value pairs of the storage database.
+/// \note The header, the index and the prefix table are checked when opening the file, every entry is checked against the bounds
+///		of the entries area when accessed, so a truncated or corrupt file leads to an exception and not to a read outside the mapping
+/// \remark Only the key/value pairs are shared between processes mapping the same file. The structures built from them
+///		(the LSH values of a searcher, the vectors of memvectypes, the product quantization codes of pqtypes, the caches)
+///		are decoded into the private heap memory of every process, as with a storage served from the database.
+class FrozenStorage
+{
+public:
+	/// \brief Open a file and map it into memory
+	explicit FrozenStorage( const std::string& path_);
+	~FrozenStorage();
+
+	/// \brief Write all key/value pairs of a database to a file in the frozen storage format
+	/// \param[in] database database client to read from, must not be changed while exporting
+	/// \param[in] path path of the file to write
+	/// \return the number of key/value pairs written
+	static std::size_t exportDatabase( const DatabaseClientInterface* database, const std::string& path);
+
+	/// \brief Read the value of a key
+	/// \return true if found
+	bool readValue( const char* key, std::size_t keysize, std::string& value) const;
+
+	/// \brief Create a cursor on the key/value pairs with the semantics of a database cursor
+	DatabaseCursorInterface* createCursor() const;
+
+	/// \brief Get the number of key/value pairs
+	std::size_t size() const
+	{
+		return m_nofEntries;
+	}
+	/// \brief Get the index of the first entry with a key not smaller than a given key
+	std::size_t lowerBound( const char* key, std::size_t keysize) const;
+	/// \brief Get the index of the first entry with a key starting with a byte bigger than a given byte
+	std::size_t prefixEnd( unsigned char prefix) const;
+	/// \brief Get the key of an entry
+	DatabaseCursorInterface::Slice key( std::size_t idx) const;
+	/// \brief Get the value of an entry
+	DatabaseCursorInterface::Slice value( std::size_t idx) const;
+
+	const std::string& path() const
+	{
+		return m_path;
+	}
+
+private:
+	const char* entry( std::size_t idx) const;
+
+private:
+	FrozenStorage( const FrozenStorage&){}		//... non copyable
+	void operator=( const FrozenStorage&){}		//... non copyable
+
+private:
+	std::string m_path;
+	const char* m_base;			///< start of the memory mapped file
+	std::size_t m_filesize;			///< size of the file in bytes
+	std::size_t m_entriesEnd;		///< end offset of the area of the entries (start of the index)
+	std::size_t m_nofEntries;		///< number of key/value pairs
+	const uint64_t* m_index;		///< offsets of the entries
+	const uint64_t* m_prefixTable;		///< index of the first entry for every first byte of a key, 257 elements
+};
+
+}//namespace
+#endif
+
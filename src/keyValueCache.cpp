@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Sharded, thread safe and size bounded LRU cache of database values
+#include "keyValueCache.hpp"
+
+using namespace strus;
+
+bool KeyValueCache::get( const std::string& key, std::string& value, bool& found, unsigned int& ticket)
+{
+	CachedValue cached;
+	if (!m_cache.get( key, cached, ticket)) return false;
+	found = cached.found;
+	if (found) value = cached.value;
+	return true;
+}
+
+void KeyValueCache::put( const std::string& key, const std::string& value, bool found, unsigned int ticket)
+{
+	m_cache.put( key, CachedValue( found ? value : std::string(), found), ShardedLruCache<CachedValue>::ShardTicket( ticket));
+}
+
+void KeyValueCache::invalidate( const std::vector<std::string>& keys)
+{
+	std::vector<std::string>::const_iterator ki = keys.begin(), ke = keys.end();
+	for (; ki != ke; ++ki)
+	{
+		m_cache.remove( *ki);
+	}
+}
+
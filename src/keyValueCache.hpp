@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Sharded, thread safe and size bounded LRU cache of database values
+#ifndef _STRUS_VECTOR_KEY_VALUE_CACHE_HPP_INCLUDED
+#define _STRUS_VECTOR_KEY_VALUE_CACHE_HPP_INCLUDED
+#include "shardedLruCache.hpp"
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Sharded, thread safe and size bounded LRU cache of database values
+/// \note Caches also the information that a key does not exist in the database
+/// \note A value read from the database is only inserted if the shard was not invalidated since the lookup that missed,
+///		so a read overlapping a commit cannot put an outdated value into the cache
+class KeyValueCache
+{
+public:
+	typedef ShardedLruCacheStatistics Statistics;
+
+	/// \brief Constructor
+	/// \param[in] maxNofEntries_ maximum number of entries of the cache as a whole
+	explicit KeyValueCache( std::size_t maxNofEntries_)
+		:m_cache(maxNofEntries_){}
+	~KeyValueCache(){}
+
+	/// \brief Lookup a key
+	/// \param[in] key the database key
+	/// \param[out] value the value of the key if found in the cache and defined in the database
+	/// \param[out] found true if the key is defined in the database, only valid if the key was found in the cache
+	/// \param[out] ticket ticket to pass to put after reading the value from the database on a miss
+	/// \return true if the key was found in the cache
+	bool get( const std::string& key, std::string& value, bool& found, unsigned int& ticket);
+
+	/// \brief Insert the value of a key read from the database after a miss
+	/// \param[in] key the database key
+	/// \param[in] value the value read, ignored if not found
+	/// \param[in] found true if the key is defined in the database
+	/// \param[in] ticket ticket returned by the get that missed
+	void put( const std::string& key, const std::string& value, bool found, unsigned int ticket);
+
+	/// \brief Remove the entries of a list of keys
+	void invalidate( const std::vector<std::string>& keys);
+
+	/// \brief Remove all entries
+	void clear()
+	{
+		m_cache.clear();
+	}
+
+	/// \brief Get the statistics of all shards
+	Statistics statistics() const
+	{
+		return m_cache.statistics();
+	}
+
+private:
+	struct CachedValue
+	{
+		std::string value;
+		bool found;
+
+		CachedValue()
+			:value(),found(false){}
+		CachedValue( const std::string& value_, bool found_)
+			:value(value_),found(found_){}
+		CachedValue( const CachedValue& o)
+			:value(o.value),found(o.found){}
+	};
+
+private:
+	KeyValueCache( const KeyValueCache&);		//... non copyable
+	void operator=( const KeyValueCache&);		//... non copyable
+
+private:
+	ShardedLruCache<CachedValue> m_cache;
+};
+
+}//namespace
+#endif
+
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Product quantization of the normalized vectors of a type for approximate reranking of search results without database reads
+#include "productQuantizer.hpp"
+#include "vectorKernels.hpp"
+#include "armautils.hpp"
+#include "internationalization.hpp"
+#include <algorithm>
+#include <limits>
+
+using namespace strus;
+
+ProductQuantizer::ProductQuantizer( const DatabaseAdapter* database_, const Index& typeno_, int vecdim_, int nofSubspaces_)
+	:m_vecdim(vecdim_),m_nofSubspaces(nofSubspaces_),m_subspaceStart(),m_codebook(),m_codes(),m_featnoar()
+{
+	if (m_nofSubspaces <= 0 || m_nofSubspaces > m_vecdim)
+	{
+		throw strus::runtime_error( _TXT("number of subspaces for product quantization out of range: %d (vector dimension %d)"), m_nofSubspaces, m_vecdim);
+	}
+	int si = 0, se = m_nofSubspaces;
+	for (; si != se; ++si)
+	{
+		m_subspaceStart.push_back( (si * m_vecdim) / m_nofSubspaces);
+	}
+	m_subspaceStart.push_back( m_vecdim);
+
+	// [1] Train the codebooks with a sample of vectors picked with a regular stride:
+	int nofVectors = database_->readNofVectors( typeno_);
+	int stride = nofVectors > MaxNofTrainingSamples ? ((nofVectors + MaxNofTrainingSamples - 1) / MaxNofTrainingSamples) : 1;
+	std::vector<float> samples;
+	Index featno;
+	WordVector vec;
+	{
+		DatabaseAdapter::VectorCursor cursor( database_, database_->vectorEncoding(), typeno_);
+		bool more = cursor.loadFirst( featno, vec);
+		for (int vidx=0; more; more = cursor.loadNext( featno, vec),++vidx)
+		{
+			if (vidx % stride != 0) continue;
+			if ((int)vec.size() != m_vecdim)
+			{
+				throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), m_vecdim, (int)vec.size());
+			}
+			arma::fvec normvec = strus::normalizeVector( vec);
+			samples.insert( samples.end(), normvec.begin(), normvec.end());
+		}
+	}
+	if (samples.empty()) return;
+	train( samples);
+
+	// [2] Encode all vectors:
+	m_codes.reserve( (std::size_t)nofVectors * m_nofSubspaces);
+	m_featnoar.reserve( nofVectors);
+	DatabaseAdapter::VectorCursor cursor( database_, database_->vectorEncoding(), typeno_);
+	bool more = cursor.loadFirst( featno, vec);
+	for (; more; more = cursor.loadNext( featno, vec))
+	{
+		if ((int)vec.size() != m_vecdim)
+		{
+			throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), m_vecdim, (int)vec.size());
+		}
+		arma::fvec normvec = strus::normalizeVector( vec);
+		std::size_t codeidx = m_codes.size();
+		m_codes.resize( codeidx + m_nofSubspaces);
+		encode( &m_codes[ codeidx], normvec.memptr());
+		m_featnoar.push_back( featno);
+	}
+}
+
+static float squareDistance( const float* v1, const float* v2, int size)
+{
+	float rt = 0.0;
+	for (int vi=0; vi != size; ++vi)
+	{
+		float diff = v1[ vi] - v2[ vi];
+		rt += diff * diff;
+	}
+	return rt;
+}
+
+void ProductQuantizer::train( const std::vector<float>& samples)
+{
+	m_codebook.resize( (std::size_t)NofCentroids * m_vecdim, 0.0);
+	int si = 0, se = m_nofSubspaces;
+	for (; si != se; ++si)
+	{
+		trainSubspace( si, samples);
+	}
+}
+
+void ProductQuantizer::trainSubspace( int subspace, const std::vector<float>& samples)
+{
+	int subdim = subspaceDim( subspace);
+	int startdim = m_subspaceStart[ subspace];
+	std::size_t nofSamples = samples.size() / m_vecdim;
+	float* centroids = &m_codebook[ NofCentroids * startdim];
+
+	// Initialize the centroids with samples picked with a regular stride:
+	int ci = 0, ce = NofCentroids;
+	for (; ci != ce; ++ci)
+	{
+		std::size_t sidx = ((std::size_t)ci * nofSamples) / NofCentroids;
+		std::copy( &samples[ sidx * m_vecdim + startdim], &samples[ sidx * m_vecdim + startdim] + subdim, centroids + ci * subdim);
+	}
+	// Lloyd iterations:
+	std::vector<int> assignment( nofSamples, -1);
+	std::vector<float> sums( (std::size_t)NofCentroids * subdim);
+	std::vector<int> counts( NofCentroids);
+	int iteration = 0;
+	for (; iteration < NofTrainingIterations; ++iteration)
+	{
+		bool changed = false;
+		std::size_t sidx = 0;
+		for (; sidx != nofSamples; ++sidx)
+		{
+			const float* sample = &samples[ sidx * m_vecdim + startdim];
+			int best = 0;
+			float bestdist = std::numeric_limits<float>::max();
+			for (ci = 0; ci != ce; ++ci)
+			{
+				float dist = squareDistance( sample, centroids + ci * subdim, subdim);
+				if (dist < bestdist)
+				{
+					bestdist = dist;
+					best = ci;
+				}
+			}
+			if (assignment[ sidx] != best)
+			{
+				assignment[ sidx] = best;
+				changed = true;
+			}
+		}
+		if (!changed) break;
+
+		std::fill( sums.begin(), sums.end(), 0.0);
+		std::fill( counts.begin(), counts.end(), 0);
+		for (sidx = 0; sidx != nofSamples; ++sidx)
+		{
+			const float* sample = &samples[ sidx * m_vecdim + startdim];
+			float* sum = &sums[ assignment[ sidx] * subdim];
+			for (int di=0; di != subdim; ++di) sum[ di] += sample[ di];
+			++counts[ assignment[ sidx]];
+		}
+		for (ci = 0; ci != ce; ++ci)
+		{
+			if (counts[ ci] == 0) continue; //... keep empty clusters where they are
+			float* centroid = centroids + ci * subdim;
+			const float* sum = &sums[ ci * subdim];
+			for (int di=0; di != subdim; ++di) centroid[ di] = sum[ di] / counts[ ci];
+		}
+	}
+}
+
+void ProductQuantizer::encode( unsigned char* code, const float* normvec) const
+{
+	int si = 0, se = m_nofSubspaces;
+	for (; si != se; ++si)
+	{
+		int subdim = subspaceDim( si);
+		const float* subvec = normvec + m_subspaceStart[ si];
+		int best = 0;
+		float bestdist = std::numeric_limits<float>::max();
+		int ci = 0, ce = NofCentroids;
+		for (; ci != ce; ++ci)
+		{
+			float dist = squareDistance( subvec, centroid( si, ci), subdim);
+			if (dist < bestdist)
+			{
+				bestdist = dist;
+				best = ci;
+			}
+		}
+		code[ si] = (unsigned char)best;
+	}
+}
+
+void ProductQuantizer::createLookupTable( std::vector<float>& lut, const float* normvec) const
+{
+	lut.resize( (std::size_t)m_nofSubspaces * NofCentroids);
+	if (m_codebook.empty()) return;
+	int si = 0, se = m_nofSubspaces;
+	for (; si != se; ++si)
+	{
+		int subdim = subspaceDim( si);
+		const float* subvec = normvec + m_subspaceStart[ si];
+		float* lutrow = &lut[ si * NofCentroids];
+		int ci = 0, ce = NofCentroids;
+		for (; ci != ce; ++ci)
+		{
+			lutrow[ ci] = strus::dotProduct( subvec, centroid( si, ci), subdim);
+		}
+	}
+}
+
+bool ProductQuantizer::similarity( const Index& featno, const std::vector<float>& lut, double& res) const
+{
+	std::vector<Index>::const_iterator fi = std::lower_bound( m_featnoar.begin(), m_featnoar.end(), featno);
+	if (fi == m_featnoar.end() || *fi != featno) return false;
+	const unsigned char* code = &m_codes[ (fi - m_featnoar.begin()) * m_nofSubspaces];
+	const float* lutrow = &lut[0];
+	float sum = 0.0;
+	int si = 0, se = m_nofSubspaces;
+	for (; si != se; ++si,lutrow += NofCentroids)
+	{
+		sum += lutrow[ code[ si]];
+	}
+	res = sum;
+	return true;
+}
+
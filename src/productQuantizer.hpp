@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Product quantization of the normalized vectors of a type for approximate reranking of search results without database reads
+#ifndef _STRUS_VECTOR_PRODUCT_QUANTIZER_HPP_INCLUDED
+#define _STRUS_VECTOR_PRODUCT_QUANTIZER_HPP_INCLUDED
+#include "strus/storage/index.hpp"
+#include "databaseAdapter.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Product quantization of the normalized vectors of a type for approximate reranking of search results without database reads
+/// \note The vector space is split into subspaces, each with a codebook of 256 centroids trained with k-means from a sample of the vectors stored.
+///	Every vector is represented by one byte per subspace, the index of the closest centroid.
+///	The similarity to a query vector is approximated with a lookup table of the dot products of the query subvectors with the centroids (asymmetric distance computation).
+class ProductQuantizer
+{
+public:
+	enum {
+		NofCentroids=256,		///< number of centroids per subspace, a code is one byte
+		MaxNofTrainingSamples=4096,	///< maximum number of vectors used for training the codebooks
+		NofTrainingIterations=8		///< number of k-means iterations for training the codebooks
+	};
+
+	/// \brief Constructor that trains the codebooks and encodes all vectors of a type
+	/// \param[in] database_ database to read the vectors from
+	/// \param[in] typeno_ type of the vectors
+	/// \param[in] vecdim_ dimension of the vectors
+	/// \param[in] nofSubspaces_ number of subspaces, bytes per vector encoded
+	ProductQuantizer( const DatabaseAdapter* database_, const Index& typeno_, int vecdim_, int nofSubspaces_);
+	~ProductQuantizer(){}
+
+	/// \brief Create the lookup table of a query for the approximation of similarities
+	/// \param[out] lut lookup table of the dot products of the query subvectors with all centroids
+	/// \param[in] normvec normalized query vector
+	void createLookupTable( std::vector<float>& lut, const float* normvec) const;
+
+	/// \brief Get the approximated similarity (cosine) of a query to the vector of a feature
+	/// \param[in] featno feature number of the vector to compare with
+	/// \param[in] lut lookup table of the query created with createLookupTable
+	/// \param[out] res the similarity approximated
+	/// \return true if the vector of the feature was found, false else
+	bool similarity( const Index& featno, const std::vector<float>& lut, double& res) const;
+
+	/// \brief Get the dimension of the vectors
+	int vecdim() const
+	{
+		return m_vecdim;
+	}
+	/// \brief Get the number of subspaces
+	int nofSubspaces() const
+	{
+		return m_nofSubspaces;
+	}
+	/// \brief Get the number of vectors encoded
+	std::size_t size() const
+	{
+		return m_featnoar.size();
+	}
+
+private:
+	ProductQuantizer( const ProductQuantizer&){}	//... non copyable
+	void operator=( const ProductQuantizer&){}	//... non copyable
+
+	void train( const std::vector<float>& samples);
+	void trainSubspace( int subspace, const std::vector<float>& samples);
+	void encode( unsigned char* code, const float* normvec) const;
+	int subspaceDim( int subspace) const
+	{
+		return m_subspaceStart[ subspace+1] - m_subspaceStart[ subspace];
+	}
+	const float* centroid( int subspace, int cidx) const
+	{
+		return &m_codebook[ NofCentroids * m_subspaceStart[ subspace] + cidx * subspaceDim( subspace)];
+	}
+
+private:
+	int m_vecdim;
+	int m_nofSubspaces;
+	std::vector<int> m_subspaceStart;	///< start dimension of the subspaces with the end of the last as additional element
+	std::vector<float> m_codebook;		///< centroids of all subspaces, the ones of a subspace start at NofCentroids * m_subspaceStart[ subspace]
+	std::vector<unsigned char> m_codes;	///< codes of the vectors, m_nofSubspaces bytes per vector
+	std::vector<Index> m_featnoar;		///< feature numbers of the vectors encoded in ascending order
+};
+
+}//namespace
+#endif
+
@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Sharded, thread safe and size bounded LRU cache of the results of vector searches
+#include "queryResultCache.hpp"
+#include "strus/base/stdint.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace strus;
+
+template <typename Scalar>
+static void appendBinary( std::string& buf, const Scalar& val)
+{
+	buf.append( (const char*)&val, sizeof(val));
+}
+
+std::string QueryResultCache::queryKey( const std::string& type, const SimHash& needle, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights)
+{
+	// ... the key is only used in the memory of this process, the binary representation of the numbers is used as it is
+	std::string rt;
+	std::string needlestr = needle.serialization();
+	rt.reserve( type.size() + needlestr.size() + vec.size() * sizeof(float) + 64);
+	appendBinary( rt, (uint32_t)type.size());
+	rt.append( type);
+	appendBinary( rt, maxNofResults);
+	appendBinary( rt, minSimilarity);
+	appendBinary( rt, speedRecallFactor);
+	rt.push_back( realVecWeights ? 1 : 0);
+	appendBinary( rt, (uint32_t)needlestr.size());
+	rt.append( needlestr);
+	if (!vec.empty())
+	{
+		rt.append( (const char*)&vec[0], vec.size() * sizeof(float));
+	}
+	return rt;
+}
+
+class QueryResultCache::TypeTicket
+{
+public:
+	TypeTicket( const QueryResultCache* cache_, const std::string& type_, unsigned int ticket_)
+		:m_cache(cache_),m_type(&type_),m_ticket(ticket_){}
+	bool operator()( unsigned int) const
+	{
+		return m_cache->isValidTicket( *m_type, m_ticket);
+	}
+private:
+	const QueryResultCache* m_cache;
+	const std::string* m_type;
+	unsigned int m_ticket;
+};
+
+struct QueryResultCache::TypeMatcher
+{
+	explicit TypeMatcher( const std::vector<std::string>& types_)
+		:types(&types_){}
+	bool operator()( const CachedResult& value) const
+	{
+		return std::find( types->begin(), types->end(), value.type) != types->end();
+	}
+	const std::vector<std::string>* types;
+};
+
+bool QueryResultCache::isValidTicket( const std::string& type, unsigned int ticket) const
+{
+	strus::scoped_lock lock( m_generation_mutex);
+	if (m_clearGeneration > ticket) return false;
+	std::map<std::string,unsigned int>::const_iterator gi = m_typeGenerationMap.find( type);
+	return gi == m_typeGenerationMap.end() || gi->second <= ticket;
+}
+
+bool QueryResultCache::get( const std::string& key, std::vector<VectorQueryResult>& results, unsigned int& ticket)
+{
+	{
+		// ... the ticket is taken before the lookup, an invalidation between the lookup and the search is not missed
+		strus::scoped_lock lock( m_generation_mutex);
+		ticket = m_generation;
+	}
+	CachedResult cached;
+	unsigned int shardTicket;
+	if (!m_cache.get( key, cached, shardTicket)) return false;
+	results.swap( cached.results);
+	return true;
+}
+
+void QueryResultCache::put( const std::string& key, const std::string& type, const std::vector<VectorQueryResult>& results, unsigned int ticket)
+{
+	// ... the ticket is checked with the shard locked, an invalidation of the type removing the entries of the shard after the check removes this one too
+	m_cache.put( key, CachedResult( type, results), TypeTicket( this, type, ticket));
+}
+
+void QueryResultCache::invalidateTypes( const std::vector<std::string>& types)
+{
+	if (types.empty()) return;
+	{
+		// ... only searches of the types invalidated started before are rejected, the generation is set before the entries are removed
+		strus::scoped_lock lock( m_generation_mutex);
+		++m_generation;
+		std::vector<std::string>::const_iterator ti = types.begin(), te = types.end();
+		for (; ti != te; ++ti)
+		{
+			m_typeGenerationMap[ *ti] = m_generation;
+		}
+	}
+	m_cache.removeIf( TypeMatcher( types));
+}
+
+void QueryResultCache::clear()
+{
+	{
+		strus::scoped_lock lock( m_generation_mutex);
+		m_clearGeneration = ++m_generation;
+		m_typeGenerationMap.clear();
+	}
+	m_cache.clear();
+}
+
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Sharded, thread safe and size bounded LRU cache of the results of vector searches
+#ifndef _STRUS_VECTOR_QUERY_RESULT_CACHE_HPP_INCLUDED
+#define _STRUS_VECTOR_QUERY_RESULT_CACHE_HPP_INCLUDED
+#include "strus/storage/vectorQueryResult.hpp"
+#include "strus/storage/wordVector.hpp"
+#include "strus/base/thread.hpp"
+#include "shardedLruCache.hpp"
+#include "simHash.hpp"
+#include <string>
+#include <map>
+#include <vector>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Sharded, thread safe and size bounded LRU cache of the results of vector searches
+/// \note The entries are invalidated per feature type searched
+/// \note A result is only inserted if its type was not invalidated since the lookup that missed,
+///		so a search overlapping a commit cannot put an outdated result into the cache
+class QueryResultCache
+{
+public:
+	typedef ShardedLruCacheStatistics Statistics;
+
+	/// \brief Constructor
+	/// \param[in] maxNofEntries_ maximum number of entries of the cache as a whole
+	explicit QueryResultCache( std::size_t maxNofEntries_)
+		:m_cache(maxNofEntries_),m_generation_mutex(),m_generation(0),m_clearGeneration(0),m_typeGenerationMap(){}
+	~QueryResultCache(){}
+
+	/// \brief Build the key of a search
+	/// \note The vector is part of the key besides its LSH value, because the reranking of the results with real or product quantized weights depends on it
+	static std::string queryKey( const std::string& type, const SimHash& needle, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights);
+
+	/// \brief Lookup a search
+	/// \param[in] key the key of the search built with queryKey
+	/// \param[out] results the results of the search if found
+	/// \param[out] ticket ticket to pass to put after doing the search on a miss
+	/// \return true if the search was found in the cache
+	bool get( const std::string& key, std::vector<VectorQueryResult>& results, unsigned int& ticket);
+
+	/// \brief Insert the results of a search after a miss
+	/// \param[in] key the key of the search built with queryKey
+	/// \param[in] type the feature type searched
+	/// \param[in] results the results of the search
+	/// \param[in] ticket ticket returned by the get that missed
+	void put( const std::string& key, const std::string& type, const std::vector<VectorQueryResult>& results, unsigned int ticket);
+
+	/// \brief Remove the entries of searches of a list of feature types
+	void invalidateTypes( const std::vector<std::string>& types);
+
+	/// \brief Remove all entries
+	void clear();
+
+	/// \brief Get the statistics of all shards
+	Statistics statistics() const
+	{
+		return m_cache.statistics();
+	}
+
+private:
+	struct CachedResult
+	{
+		std::string type;
+		std::vector<VectorQueryResult> results;
+
+		CachedResult()
+			:type(),results(){}
+		CachedResult( const std::string& type_, const std::vector<VectorQueryResult>& results_)
+			:type(type_),results(results_){}
+		CachedResult( const CachedResult& o)
+			:type(o.type),results(o.results){}
+	};
+	class TypeTicket;
+	friend class TypeTicket;
+	struct TypeMatcher;
+
+	/// \brief Test if a search of a type started with a ticket did not overlap an invalidation of the type
+	bool isValidTicket( const std::string& type, unsigned int ticket) const;
+
+private:
+	QueryResultCache( const QueryResultCache&);		//... non copyable
+	void operator=( const QueryResultCache&);		//... non copyable
+
+private:
+	ShardedLruCache<CachedResult> m_cache;
+	mutable strus::mutex m_generation_mutex;			///< mutual exclusion in the access of the generations
+	unsigned int m_generation;					///< incremented on every invalidation, the ticket of a lookup is its value
+	unsigned int m_clearGeneration;					///< generation of the last clear
+	std::map<std::string,unsigned int> m_typeGenerationMap;	///< generation of the last invalidation per type
+};
+
+}//namespace
+#endif
+
@@ -16,6 +16,7 @@
 #include <ostream>
 #include <sstream>
 #include <limits>
+#include <vector>
 
 namespace strus {
 
@@ -123,6 +124,17 @@ public:
 		return true;
 	}
 
+	/// \brief Get the elements kept sorted in ascending order
+	void getResult( std::vector<Element>& res) const
+	{
+		res.clear();
+		const_iterator ri = begin(), re = end();
+		for (; ri != re; ++ri)
+		{
+			res.push_back( *ri);
+		}
+	}
+
 	class const_iterator
 	{
 	public:
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Fixed size pool of threads shared by the searches of a vector storage client
+#include "searchWorkerPool.hpp"
+#include "strus/errorBufferInterface.hpp"
+
+using namespace strus;
+
+SearchWorkerPool::SearchWorkerPool( unsigned int nofThreads_, ErrorBufferInterface* errorhnd_)
+	:m_errorhnd(errorhnd_),m_mutex(),m_cond(),m_doneCond(),m_queue(),m_terminate(false),m_threads()
+{
+	m_threads.reserve( nofThreads_);
+	for (unsigned int tidx=0; tidx<nofThreads_; ++tidx)
+	{
+		Reference<strus::thread> th( new strus::thread( &SearchWorkerPool::runThread, this));
+		m_threads.push_back( th);
+	}
+}
+
+SearchWorkerPool::~SearchWorkerPool()
+{
+	{
+		strus::scoped_lock lock( m_mutex);
+		m_terminate = true;
+		m_cond.notify_all();
+	}
+	std::vector<Reference<strus::thread> >::iterator ti = m_threads.begin(), te = m_threads.end();
+	for (; ti != te; ++ti) (*ti)->join();
+}
+
+void SearchWorkerPool::setExhausted( Entry* entry)
+{
+	if (!entry->exhausted)
+	{
+		entry->exhausted = true;
+		m_queue.remove( entry);
+	}
+}
+
+void SearchWorkerPool::run( Task& task)
+{
+	Entry entry( &task);
+	if (!m_threads.empty())
+	{
+		strus::scoped_lock lock( m_mutex);
+		m_queue.push_back( &entry);
+		m_cond.notify_all();
+	}
+	while (task.runNext()){}
+
+	// ... wait for the threads of the pool still processing a unit of the task
+	strus::unique_lock lock( m_mutex);
+	setExhausted( &entry);
+	while (entry.nofActive > 0) m_doneCond.wait( lock);
+}
+
+void SearchWorkerPool::runThread()
+{
+	for (;;)
+	{
+		Entry* entry;
+		{
+			strus::unique_lock lock( m_mutex);
+			while (!m_terminate && m_queue.empty()) m_cond.wait( lock);
+			if (m_terminate) break;
+			entry = m_queue.front();
+			++entry->nofActive;
+		}
+		while (entry->task->runNext()){}
+		{
+			strus::scoped_lock lock( m_mutex);
+			setExhausted( entry);
+			--entry->nofActive;
+			m_doneCond.notify_all();
+		}
+	}
+	m_errorhnd->releaseContext();
+}
+
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Fixed size pool of threads shared by the searches of a vector storage client
+#ifndef _STRUS_VECTOR_SEARCH_WORKER_POOL_HPP_INCLUDED
+#define _STRUS_VECTOR_SEARCH_WORKER_POOL_HPP_INCLUDED
+#include "strus/base/thread.hpp"
+#include "strus/reference.hpp"
+#include <vector>
+#include <list>
+
+namespace strus {
+
+/// \brief Forward declaration
+class ErrorBufferInterface;
+
+/// \brief Fixed size pool of threads helping the calling threads to process the units of work of a search
+/// \note The threads are started once by the constructor, a search does not create any thread.
+///	The calling thread processes the units of its search too, so a search progresses even if all threads of the pool are busy.
+class SearchWorkerPool
+{
+public:
+	/// \brief Search split into units of work processed by the calling thread and the threads of the pool
+	class Task
+	{
+	public:
+		virtual ~Task(){}
+		/// \brief Process the next unit of work not processed yet
+		/// \note Must not throw, errors are stored in the task
+		/// \return false if there are no units of work left
+		virtual bool runNext()=0;
+	};
+
+	/// \brief Constructor, starts the threads
+	/// \param[in] nofThreads_ number of threads of the pool
+	/// \param[in] errorhnd_ error buffer interface
+	SearchWorkerPool( unsigned int nofThreads_, ErrorBufferInterface* errorhnd_);
+	~SearchWorkerPool();
+
+	/// \brief Process all units of work of a task with the calling thread and the threads of the pool idle
+	/// \note Returns when no thread is processing a unit of the task anymore
+	void run( Task& task);
+
+	/// \brief Get the number of threads of the pool
+	unsigned int nofThreads() const
+	{
+		return m_threads.size();
+	}
+
+private:
+	/// \brief Task queued with the number of threads processing it
+	struct Entry
+	{
+		Task* task;
+		int nofActive;		///< number of threads of the pool processing units of the task
+		bool exhausted;		///< true if there are no units left and the task has been removed from the queue
+
+		explicit Entry( Task* task_)
+			:task(task_),nofActive(0),exhausted(false){}
+	};
+
+	void runThread();
+	/// \brief Remove a task without units left from the queue
+	/// \note Call only with m_mutex held
+	void setExhausted( Entry* entry);
+
+private:
+	SearchWorkerPool( const SearchWorkerPool&){}		//... non copyable
+	void operator=( const SearchWorkerPool&){}		//... non copyable
+
+private:
+	ErrorBufferInterface* m_errorhnd;
+	strus::mutex m_mutex;
+	strus::condition_variable m_cond;		///< signals a task queued or the termination of the pool
+	strus::condition_variable m_doneCond;		///< signals a thread of the pool finished processing a task
+	std::list<Entry*> m_queue;			///< tasks with units not yet taken
+	bool m_terminate;				///< true if the threads are asked to terminate
+	std::vector<Reference<strus::thread> > m_threads;
+};
+
+}//namespace
+#endif
+
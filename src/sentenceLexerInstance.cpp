@@ -28,7 +28,7 @@ using namespace strus;
 #define SENTENCESIZE_AGAINST_COVERSIZE_WEIGHT 0.3
 #define DUPLICATES_AGAINST_COVERSIZE_WEIGHT 1.0
 
-SentenceLexerInstance::SentenceLexerInstance( const VectorStorageClient* vstorage_, const DatabaseClientInterface* database_, const SentenceLexerConfig& config_, ErrorBufferInterface* errorhnd_)
+SentenceLexerInstance::SentenceLexerInstance( const VectorStorageClient* vstorage_, const DatabaseAdapter* database_, const SentenceLexerConfig& config_, ErrorBufferInterface* errorhnd_)
 	:m_errorhnd(errorhnd_),m_debugtrace(0),m_vstorage(vstorage_),m_database(database_),m_config(config_)
 	,m_typepriomap()
 {
@@ -610,10 +610,25 @@ std::vector<SentenceGuess> SentenceLexerInstance::call( const std::vector<std::s
 		rt.reserve( maxNofResults);
 		std::vector<std::string> typestrmap;
 
-		// Build result returned:
+		// Resolve the names of the features of all results selected with one ordered scan:
+		std::vector<strus::Index> featnolist;
 		ri = ranks.begin();
 		re = ranks.end();
 		for (; ri != re && ri->weight >= minWeight + std::numeric_limits<double>::epsilon(); ++ri)
+		{
+			const FeatNumList& feats = sentences.ar()[ ri->idx];
+			FeatNumList::const_iterator fi = feats.begin(), fe = feats.end();
+			for (; fi != fe; ++fi)
+			{
+				if (fi->typeno != 0) featnolist.push_back( fi->featno);
+			}
+		}
+		std::vector<std::string> featnames = m_vstorage->getFeatNamesFromIndex( featnolist);
+		std::vector<std::string>::const_iterator ni = featnames.begin();
+
+		// Build result returned:
+		ri = ranks.begin();
+		for (; ri != re && ri->weight >= minWeight + std::numeric_limits<double>::epsilon(); ++ri)
 		{
 			SentenceTermList termlist;
 			const FeatNumList& feats = sentences.ar()[ ri->idx];
@@ -634,10 +649,7 @@ std::vector<SentenceGuess> SentenceLexerInstance::call( const std::vector<std::s
 					{
 						typestrmap[ fi->typeno] = m_vstorage->getTypeNameFromIndex( fi->typeno);
 					}
-					termlist.push_back(
-						SentenceTerm(
-							typestrmap[ fi->typeno], 
-							m_vstorage->getFeatNameFromIndex( fi->featno)));
+					termlist.push_back( SentenceTerm( typestrmap[ fi->typeno], *ni++));
 				}
 			}
 			rt.push_back( SentenceGuess( termlist, ri->weight));
@@ -25,8 +25,6 @@ class ErrorBufferInterface;
 class SentenceLexerContextInterface;
 /// \brief Forward declaration
 class DebugTraceContextInterface;
-/// \brief Forward declaration
-class DatabaseClientInterface;
 
 /// \brief Implementation of a sentence lexer based on a vector storage
 class SentenceLexerInstance
@@ -36,7 +34,7 @@ public:
 	/// \brief Constructor
 	SentenceLexerInstance(
 			const VectorStorageClient* vstorage_,
-			const DatabaseClientInterface* database_,
+			const DatabaseAdapter* database_,
 			const SentenceLexerConfig& config_,
 			ErrorBufferInterface* errorhnd_);
 
@@ -53,7 +51,7 @@ private:
 	ErrorBufferInterface* m_errorhnd;
 	DebugTraceContextInterface* m_debugtrace;
 	const VectorStorageClient* m_vstorage;
-	const DatabaseClientInterface* m_database;
+	const DatabaseAdapter* m_database;
 	SentenceLexerConfig m_config;
 	std::map<strus::Index,int> m_typepriomap;
 };
@@ -20,7 +20,7 @@ using namespace strus;
 
 SentenceLexerKeySearch::SentenceLexerKeySearch(
 		const VectorStorageClient* vstorage_,
-		const DatabaseClientInterface* database_,
+		const DatabaseAdapter* database_,
 		ErrorBufferInterface* errorhnd_,
 		char spaceSubst_,
 		char linkSubst_)
@@ -17,8 +17,6 @@
 
 namespace strus {
 
-/// \brief Forward declaration
-class DatabaseClientInterface;
 /// \brief Forward declaration
 class ErrorBufferInterface;
 
@@ -49,7 +47,7 @@ public:
 
 	SentenceLexerKeySearch(
 		const VectorStorageClient* vstorage_,
-		const DatabaseClientInterface* database_,
+		const DatabaseAdapter* database_,
 		ErrorBufferInterface* errorhnd_,
 		char spaceSubst_,
 		char linkSubst_);
@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Sharded, thread safe and size bounded LRU cache with string keys
+#ifndef _STRUS_VECTOR_SHARDED_LRU_CACHE_HPP_INCLUDED
+#define _STRUS_VECTOR_SHARDED_LRU_CACHE_HPP_INCLUDED
+#include "strus/base/thread.hpp"
+#include "strus/base/stdint.h"
+#include <string>
+#include <list>
+#include <map>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Statistics of a sharded LRU cache
+struct ShardedLruCacheStatistics
+{
+	std::size_t hits;		///< number of lookups answered by the cache
+	std::size_t misses;		///< number of lookups that missed
+	std::size_t entries;		///< number of entries in the cache
+
+	ShardedLruCacheStatistics()
+		:hits(0),misses(0),entries(0){}
+	ShardedLruCacheStatistics( const ShardedLruCacheStatistics& o)
+		:hits(o.hits),misses(o.misses),entries(o.entries){}
+};
+
+/// \brief Sharded, thread safe and size bounded LRU cache with string keys
+/// \note A value computed after a miss is only inserted if the admission passed to put accepts it,
+///		the admission gets the generation of the shard, incremented on every removal of a key and on clear
+template <class Value>
+class ShardedLruCache
+{
+public:
+	enum {NofShards=16};
+	typedef ShardedLruCacheStatistics Statistics;
+
+	/// \brief Constructor
+	/// \param[in] maxNofEntries_ maximum number of entries of the cache as a whole
+	explicit ShardedLruCache( std::size_t maxNofEntries_)
+		:m_maxNofEntriesPerShard((maxNofEntries_ + NofShards - 1) / NofShards){}
+	~ShardedLruCache(){}
+
+	/// \brief Admission of a value accepting it if the shard was not invalidated since the lookup that missed
+	class ShardTicket
+	{
+	public:
+		explicit ShardTicket( unsigned int ticket_)
+			:m_ticket(ticket_){}
+		bool operator()( unsigned int generation) const
+		{
+			return generation == m_ticket;
+		}
+	private:
+		unsigned int m_ticket;
+	};
+
+	/// \brief Lookup a key
+	/// \param[out] value the value of the key if found
+	/// \param[out] ticket generation of the shard of the key for a ShardTicket on a miss
+	/// \return true if the key was found in the cache
+	bool get( const std::string& key, Value& value, unsigned int& ticket)
+	{
+		Shard& sh = shard( key);
+		strus::scoped_lock lock( sh.mutex);
+		typename EntryMap::iterator mi = sh.map.find( key);
+		if (mi == sh.map.end())
+		{
+			++sh.misses;
+			ticket = sh.generation;
+			return false;
+		}
+		++sh.hits;
+		sh.lru.splice( sh.lru.begin(), sh.lru, mi->second);
+		value = mi->second->value;
+		return true;
+	}
+
+	/// \brief Insert the value of a key computed after a miss
+	/// \param[in] admission functor called with the generation of the shard with the shard locked, the value is inserted if it returns true
+	template <class Admission>
+	void put( const std::string& key, const Value& value, const Admission& admission)
+	{
+		Shard& sh = shard( key);
+		strus::scoped_lock lock( sh.mutex);
+		if (!m_maxNofEntriesPerShard || !admission( sh.generation)) return;
+
+		typename EntryMap::iterator mi = sh.map.find( key);
+		if (mi != sh.map.end())
+		{
+			// ... inserted by a concurrent lookup of the same key
+			return;
+		}
+		sh.lru.push_front( Entry( key, value));
+		sh.map[ key] = sh.lru.begin();
+		if (sh.map.size() > m_maxNofEntriesPerShard)
+		{
+			sh.map.erase( sh.lru.back().key);
+			sh.lru.pop_back();
+		}
+	}
+
+	/// \brief Remove the entry of a key and increment the generation of its shard
+	void remove( const std::string& key)
+	{
+		Shard& sh = shard( key);
+		strus::scoped_lock lock( sh.mutex);
+		++sh.generation;
+		typename EntryMap::iterator mi = sh.map.find( key);
+		if (mi != sh.map.end())
+		{
+			sh.lru.erase( mi->second);
+			sh.map.erase( mi);
+		}
+	}
+
+	/// \brief Remove the entries with a value matching a predicate
+	/// \note Does not change the generation of the shards, the admission of values computed concurrently has to be decided by the caller
+	template <class Predicate>
+	void removeIf( const Predicate& predicate)
+	{
+		for (int si=0; si < NofShards; ++si)
+		{
+			Shard& sh = m_shards[ si];
+			strus::scoped_lock lock( sh.mutex);
+			typename EntryList::iterator li = sh.lru.begin();
+			while (li != sh.lru.end())
+			{
+				if (predicate( li->value))
+				{
+					sh.map.erase( li->key);
+					li = sh.lru.erase( li);
+				}
+				else
+				{
+					++li;
+				}
+			}
+		}
+	}
+
+	/// \brief Remove all entries and increment the generation of all shards
+	void clear()
+	{
+		for (int si=0; si < NofShards; ++si)
+		{
+			Shard& sh = m_shards[ si];
+			strus::scoped_lock lock( sh.mutex);
+			++sh.generation;
+			sh.map.clear();
+			sh.lru.clear();
+		}
+	}
+
+	/// \brief Get the statistics of all shards
+	Statistics statistics() const
+	{
+		Statistics rt;
+		for (int si=0; si < NofShards; ++si)
+		{
+			const Shard& sh = m_shards[ si];
+			strus::scoped_lock lock( sh.mutex);
+			rt.hits += sh.hits;
+			rt.misses += sh.misses;
+			rt.entries += sh.map.size();
+		}
+		return rt;
+	}
+
+private:
+	struct Entry
+	{
+		std::string key;
+		Value value;
+
+		Entry( const std::string& key_, const Value& value_)
+			:key(key_),value(value_){}
+		Entry( const Entry& o)
+			:key(o.key),value(o.value){}
+	};
+	typedef std::list<Entry> EntryList;
+	typedef std::map<std::string,typename EntryList::iterator> EntryMap;
+
+	struct Shard
+	{
+		mutable strus::mutex mutex;
+		EntryList lru;			///< entries with the most recently used first
+		EntryMap map;
+		unsigned int generation;	///< incremented on every removal of a key and on clear
+		std::size_t hits;
+		std::size_t misses;
+
+		Shard()
+			:mutex(),lru(),map(),generation(0),hits(0),misses(0){}
+	};
+
+	Shard& shard( const std::string& key)
+	{
+		// ... FNV-1a hash of the key
+		uint32_t hs = 2166136261U;
+		std::string::const_iterator ki = key.begin(), ke = key.end();
+		for (; ki != ke; ++ki)
+		{
+			hs ^= (unsigned char)*ki;
+			hs *= 16777619U;
+		}
+		return m_shards[ hs % NofShards];
+	}
+
+private:
+	ShardedLruCache( const ShardedLruCache&){}		//... non copyable
+	void operator=( const ShardedLruCache&){}		//... non copyable
+
+private:
+	Shard m_shards[ NofShards];
+	std::size_t m_maxNofEntriesPerShard;
+};
+
+}//namespace
+#endif
+
@@ -305,23 +305,41 @@ std::string SimHash::serialization() const
 }
 
 SimHash SimHash::fromSerialization( const char* in, int insize)
+{
+	SimHash rt;
+	fromSerialization( rt, in, insize);
+	return rt;
+}
+
+void SimHash::resetSize( int size_, const Index& id_)
+{
+	m_id = id_;
+	if (m_ar && m_size == size_) return;
+
+	uint64_t* newar = (uint64_t*)std::malloc( SimHash_mallocSize( size_));
+	if (!newar) throw std::bad_alloc();
+	std::free( m_ar);
+	m_ar = newar;
+	m_size = size_;
+}
+
+void SimHash::fromSerialization( SimHash& res, const char* in, int insize)
 {
 	if (insize < 8) throw strus::runtime_error(_TXT("failed to build SimHash from serialization: %s"),_TXT("buffer too small"));
 
 	uint32_t const* nw = (const uint32_t*)(void*)(in);
 	uint32_t id_ = ByteOrder<uint32_t>::ntoh( *nw++);
 	uint32_t size_ = ByteOrder<uint32_t>::ntoh( *nw++);
-	SimHash rt( size_, false, id_);
-	int ai=0,ae=rt.arsize();
 	int expectsize = 2*sizeof(uint32_t) + SimHash_mallocSize(size_);
 	if (insize != expectsize) throw strus::runtime_error(_TXT("failed to build SimHash from serialization: %s"),_TXT("buffer size does not match"));
+	res.resetSize( size_, id_);
+	int ai=0,ae=res.arsize();
 	uint64_t const* nw64 = (const uint64_t*)nw;
 	for (; ai != ae; ++ai,++nw64)
 	{
 		uint64_t val = ByteOrder<uint64_t>::ntoh( *nw64);
-		rt.m_ar[ ai] = val;
+		res.m_ar[ ai] = val;
 	}
-	return rt;
 }
 
 SimHash SimHash::fromSerialization( const std::string& in)
@@ -329,6 +347,36 @@ SimHash SimHash::fromSerialization( const std::string& in)
 	return fromSerialization( in.c_str(), in.size());
 }
 
+SimHash SimHash::fromPackedWords( const char* in, int size_, const Index& id_)
+{
+	SimHash rt;
+	fromPackedWords( rt, in, size_, id_);
+	return rt;
+}
+
+void SimHash::fromPackedWords( SimHash& res, const char* in, int size_, const Index& id_)
+{
+	res.resetSize( size_, id_);
+	int ai=0,ae=res.arsize();
+	for (; ai != ae; ++ai,in+=sizeof(uint64_t))
+	{
+		uint64_t val;
+		std::memcpy( &val, in, sizeof(val));
+		res.m_ar[ ai] = ByteOrder<uint64_t>::ntoh( val);
+	}
+}
+
+void SimHash::appendPackedWords( std::string& out) const
+{
+	uint64_t const* ai = m_ar;
+	const uint64_t* ae = m_ar + arsize();
+	for (; ai != ae; ++ai)
+	{
+		uint64_t val = ByteOrder<uint64_t>::hton( *ai);
+		out.append( (const char*)&val, sizeof(val));
+	}
+}
+
 #define UINT64_CONST(hi,lo) (((uint64_t)hi << 32) | (uint64_t)lo)
 
 uint64_t hash64Bitshuffle( uint64_t a)
@@ -136,6 +136,19 @@ public:
 	static SimHash fromSerialization( const char* in, int insize);
 	/// \brief Deserialize
 	static SimHash fromSerialization( const std::string& blob);
+	/// \brief Deserialize from the words of a value in network byte order as packed into a block of values
+	/// \param[in] in pointer to the words of the value
+	/// \param[in] size_ number of bits of the value
+	/// \param[in] id_ feature number of the value
+	static SimHash fromPackedWords( const char* in, int size_, const Index& id_);
+	/// \brief Deserialize into an existing value, reusing its array if it has the same size
+	static void fromSerialization( SimHash& res, const char* in, int insize);
+	/// \brief Deserialize from the words of a value packed into a block of values into an existing value, reusing its array if it has the same size
+	static void fromPackedWords( SimHash& res, const char* in, int size_, const Index& id_);
+	/// \brief Resize to a number of bits without initializing the elements, keeping the array if the size does not change
+	void resetSize( int size_, const Index& id_);
+	/// \brief Append the words of this value in network byte order for packing it into a block of values
+	void appendPackedWords( std::string& out) const;
 
 	const uint64_t* ar() const			{return m_ar;}
 	/// \brief Get the size of the array used to represent the sim hash value
@@ -92,6 +92,27 @@ void SimHashBench::search( std::vector<SimHashSelect>& resbuf, uint64_t needle,
 	}
 }
 
+void SimHashBench::search( std::vector<SimHashSelect>& resbuf, uint64_t needle, int maxSimDist, const uint64_t* allowed) const
+{
+	std::size_t wi = 0, we = (m_arsize + 63) / 64;
+	for (; wi != we; ++wi)
+	{
+		uint64_t word = allowed[ wi];
+		while (word)
+		{
+			std::size_t ai = (wi << 6) + (strus::BitOperations::bitScanForward( word) - 1);
+			word &= word - 1;
+			if (ai >= m_arsize) break;
+
+			int simDist = strus::BitOperations::bitCount( m_ar[ ai] ^ needle);
+			if (simDist <= maxSimDist)
+			{
+				resbuf.push_back( SimHashSelect( m_startIdx + ai, simDist));
+			}
+		}
+	}
+}
+
 void SimHashBench::filter( std::vector<SimHashSelect>& resbuf, std::size_t residx, uint64_t needle, int maxSimDist, int maxSumSimDist) const
 {
 	std::size_t destidx = residx;
@@ -143,3 +164,30 @@ void SimHashBenchArray::append( const SimHash* sar, std::size_t sarsize, int sim
 
 
 
+
+void SimHashSlotSet::insert( int slotidx)
+{
+	if (slotidx < 0) throw strus::runtime_error(_TXT("illegal slot index %d"), slotidx);
+	std::size_t blockidx = slotidx / BlockSize;
+	std::size_t bitidx = slotidx % BlockSize;
+	if (blockidx >= m_blocks.size()) m_blocks.resize( blockidx+1);
+
+	std::vector<uint64_t>& blk = m_blocks[ blockidx];
+	if (blk.empty()) blk.resize( BlockWords, 0);
+
+	uint64_t mask = (uint64_t)1 << (bitidx & 63);
+	if (0==(blk[ bitidx >> 6] & mask))
+	{
+		blk[ bitidx >> 6] |= mask;
+		++m_size;
+	}
+}
+
+bool SimHashSlotSet::contains( int slotidx) const
+{
+	if (slotidx < 0) return false;
+	const uint64_t* blk = block( slotidx / BlockSize);
+	if (!blk) return false;
+	std::size_t bitidx = slotidx % BlockSize;
+	return 0!=(blk[ bitidx >> 6] & ((uint64_t)1 << (bitidx & 63)));
+}
@@ -60,6 +60,11 @@ public:
 	/// \param[out] resbuf buffer where to append result to
 	void search( std::vector<SimHashSelect>& resbuf, uint64_t needle, int maxSimDist) const;
 
+	/// \brief Search visiting only the elements allowed
+	/// \param[out] resbuf buffer where to append result to
+	/// \param[in] allowed bitmap block of the slots allowed in this bench (SimHashSlotSet::block)
+	void search( std::vector<SimHashSelect>& resbuf, uint64_t needle, int maxSimDist, const uint64_t* allowed) const;
+
 	/// \param[in,out] resbuf buffer with result to filter
 	void filter( std::vector<SimHashSelect>& resbuf, std::size_t residx, uint64_t needle, int maxSimDist, int maxSumSimDist) const;
 
@@ -79,6 +84,57 @@ private:
 };
 
 
+/// \brief Set of allowed slot indices (indices of elements in the array of LSH values) for restricting a search
+/// \note The bitmap is organized in blocks of the size of a bench, blocks without any slot allowed are not allocated
+class SimHashSlotSet
+{
+public:
+	enum {BlockSize=SimHashBench::Size, BlockWords=BlockSize/64};
+
+public:
+	SimHashSlotSet()
+		:m_blocks(),m_size(0){}
+	SimHashSlotSet( const SimHashSlotSet& o)
+		:m_blocks(o.m_blocks),m_size(o.m_size){}
+#if __cplusplus >= 201103L
+	SimHashSlotSet( SimHashSlotSet&& o)
+		:m_blocks(std::move(o.m_blocks)),m_size(o.m_size){}
+	SimHashSlotSet& operator=(SimHashSlotSet&& o)
+		{m_blocks=std::move(o.m_blocks); m_size=o.m_size; return *this;}
+#endif
+	SimHashSlotSet& operator=( const SimHashSlotSet& o)
+		{m_blocks=o.m_blocks; m_size=o.m_size; return *this;}
+
+	/// \brief Allow a slot
+	void insert( int slotidx);
+
+	/// \brief Test if a slot is allowed
+	bool contains( int slotidx) const;
+
+	/// \brief Get the bitmap block of a bench
+	/// \return the bitmap with BlockWords elements or NULL if no slot of this bench is allowed
+	const uint64_t* block( std::size_t benchidx) const
+	{
+		return (benchidx < m_blocks.size() && !m_blocks[ benchidx].empty()) ? &m_blocks[ benchidx][0] : 0;
+	}
+
+	/// \brief Get the number of slots allowed
+	std::size_t size() const
+	{
+		return m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+private:
+	std::vector<std::vector<uint64_t> > m_blocks;
+	std::size_t m_size;
+};
+
+
 /// \brief Structure holding one part of an array of LSH values to filter probable candidates for LSH comparison
 class SimHashBenchArray
 {
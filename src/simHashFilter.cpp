@@ -32,7 +32,7 @@ void SimHashFilter::append( const SimHash* sar, std::size_t sarsize)
 }
 
 
-void SimHashFilter::search( std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist) const
+void SimHashFilter::search( std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const
 {
 	if (!m_nofBenches) return;
 	resbuf.reserve( SimHashBench::Size);
@@ -53,7 +53,16 @@ void SimHashFilter::search( std::vector<SimHashSelect>& resbuf, const SimHash& n
 	{
 		std::size_t residx = resbuf.size();
 		std::size_t bi = 0, be = m_nofBenches;
-		m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist);
+		if (slotFilter)
+		{
+			const uint64_t* allowed = slotFilter->block( si);
+			if (!allowed) continue;
+			m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist, allowed);
+		}
+		else
+		{
+			m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist);
+		}
 		for (++bi; bi != be; ++bi)
 		{
 			int relSumSimDist = (bi+1) * relProbSimDist - bi * probSimDistSumLimitDecr;
@@ -62,7 +71,7 @@ void SimHashFilter::search( std::vector<SimHashSelect>& resbuf, const SimHash& n
 	}
 }
 
-void SimHashFilter::searchWithStats( Stats& stats, std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist) const
+void SimHashFilter::searchWithStats( Stats& stats, std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const
 {
 	stats.nofBenches = m_nofBenches;
 
@@ -85,7 +94,16 @@ void SimHashFilter::searchWithStats( Stats& stats, std::vector<SimHashSelect>& r
 	{
 		std::size_t residx = resbuf.size();
 		std::size_t bi = 0, be = m_nofBenches;
-		m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist);
+		if (slotFilter)
+		{
+			const uint64_t* allowed = slotFilter->block( si);
+			if (!allowed) continue;
+			m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist, allowed);
+		}
+		else
+		{
+			m_benchar[ bi][ si].search( resbuf, needle.ar()[ bi], relProbSimDist);
+		}
 		stats.nofCandidates[ bi] += resbuf.size() - residx;
 		for (++bi; bi != be; ++bi)
 		{
@@ -48,9 +48,10 @@ public:
 	void append( const SimHash* sar, std::size_t sarsize);
 
 	/// \param[out] resbuf buffer where to append result to
-	void search( std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist) const;
+	/// \param[in] slotFilter set of slots allowed as candidates or NULL if all slots are allowed
+	void search( std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const;
 
-	void searchWithStats( Stats& stats, std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist) const;
+	void searchWithStats( Stats& stats, std::vector<SimHashSelect>& resbuf, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const;
 
 	int maxProbSumDist( int maxSimDist, int maxProbSimDist) const;
 
@@ -8,7 +8,9 @@
 /// \brief Structure for retrieval of the most similar LSH values
 #include "simHashMap.hpp"
 #include "simHashRankList.hpp"
+#include "internationalization.hpp"
 #include <algorithm>
+#include <cstddef>
 
 using namespace strus;
 
@@ -33,14 +35,20 @@ void SimHashMap::load()
 	};
 	std::vector<SimHash> lshar;
 #endif
-	const SimHash* val = m_reader->loadFirst();
-	for (; val; val=m_reader->loadNext())
+	std::size_t blocksize = 0;
+	const SimHash* block = m_reader->loadFirstBlock( blocksize);
+	for (; block; block=m_reader->loadNextBlock( blocksize))
 	{
-		m_filter.append( val, 1);
-		m_idar.push_back( val->id());
+		m_filter.append( block, blocksize);
+		const SimHash* bi = block;
+		const SimHash* be = block + blocksize;
+		for (; bi != be; ++bi)
+		{
+			m_idar.push_back( bi->id());
 #ifdef STRUS_LOWLEVEL_DEBUG
-		lshar.push_back( *val);
+			lshar.push_back( *bi);
 #endif
+		}
 	}
 #ifdef STRUS_LOWLEVEL_DEBUG
 	std::vector<SimHash>::const_iterator li = lshar.begin(), le = lshar.end();
@@ -58,7 +66,7 @@ void SimHashMap::load()
 		for (++cidx; ci != ce && ci->simdist < 300; ++ci,++cidx){}
 		
 		chkar.resize( cidx);
-		std::vector<SimHashQueryResult> cres = findSimilar( *li, 340/*maxSimDist*/, 640/*maxProbSimDist*/, 20);
+		std::vector<SimHashQueryResult> cres = findSimilar( *li, 340/*maxSimDist*/, 640/*maxProbSimDist*/, 20, NULL/*slotFilter*/);
 		std::vector<SimHashQueryResult>::const_iterator ri = cres.begin(), re = cres.end();
 		for (; ri != re; ++ri)
 		{
@@ -89,112 +97,341 @@ void SimHashMap::load()
 #endif
 }
 
-int SimHashMap::getMaxSimDistFromBestFilterSamples( const std::vector<SimHashSelect>& candidates, const SimHash& needle, int maxNofElements, int nofSampleReads) const
+/// \brief Distance of a filter candidate used as bucket index for the top-k selection
+struct SimHashSelectDistance
 {
-	RankList<SimHashSelect> selectRanklist( nofSampleReads);
-	std::vector<SimHashSelect>::const_iterator ci = candidates.begin(), ce = candidates.end();
-	for (; ci != ce; ++ci)
+	static int get( const SimHashSelect& elem)
 	{
-		selectRanklist.insert( *ci);
+		return elem.shdiff;
 	}
-	int sampleDistAr[ RankList<SimHashSelect>::MaxSize];
-	int sampleDistArSize = 0;
+};
 
-	RankList<SimHashSelect>::const_iterator si = selectRanklist.begin(), se = selectRanklist.end();
-	for (; si != se; ++si)
+/// \brief Distance of a ranked LSH value used as bucket index for the top-k selection
+struct SimHashRankDistance
+{
+	static int get( const SimHashRank& elem)
 	{
-		Index elemid = m_idar[ si->idx];
-		SimHash shbuf;
-		const SimHash* val = m_reader->load( elemid, shbuf);
-		if (val)
+		return elem.simdist;
+	}
+};
+
+template <class RankListType, typename Element>
+static void selectBestElements( std::vector<Element>& res, RankListType& ranklist, const std::vector<Element>& elements)
+{
+	typename std::vector<Element>::const_iterator ei = elements.begin(), ee = elements.end();
+	for (; ei != ee; ++ei)
+	{
+		ranklist.insert( *ei);
+	}
+	ranklist.getResult( res);
+}
+
+void SimHashMap::getBestFilterSamples( std::vector<SimHashSelect>& res, const std::vector<SimHashSelect>& candidates, int nofSampleReads) const
+{
+	switch (m_topKMethod)
+	{
+		case TopKSelectRankList:
 		{
-			sampleDistAr[ sampleDistArSize++] = val->dist( needle);
+			if (nofSampleReads > RankList<SimHashSelect>::MaxSize)
+			{
+				// ... too many samples for a ranklist, select the best of all candidates
+				res = candidates;
+				if (res.size() > (std::size_t)nofSampleReads)
+				{
+					std::partial_sort( res.begin(), res.begin() + nofSampleReads, res.end());
+					res.resize( nofSampleReads);
+				}
+				else
+				{
+					std::sort( res.begin(), res.end());
+				}
+			}
+			else
+			{
+				RankList<SimHashSelect> ranklist( nofSampleReads);
+				selectBestElements( res, ranklist, candidates);
+			}
+			return;
+		}
+		case TopKSelectHeap:
+		{
+			TopKHeap<SimHashSelect> ranklist( nofSampleReads);
+			selectBestElements( res, ranklist, candidates);
+			return;
+		}
+		case TopKSelectBuckets:
+		{
+			TopKDistanceBuckets<SimHashSelect,SimHashSelectDistance> ranklist( nofSampleReads);
+			selectBestElements( res, ranklist, candidates);
+			return;
 		}
 	}
-	if (sampleDistArSize == 0) return 0;
-	std::sort( sampleDistAr, sampleDistAr + sampleDistArSize);
-	return maxNofElements >= sampleDistArSize ? 0 : sampleDistAr[ maxNofElements];
+	throw std::runtime_error( _TXT("unknown top-k selection method"));
 }
 
-std::vector<SimHashQueryResult> SimHashMap::findSimilar( const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements) const
+int SimHashMap::getMaxSimDistFromBestFilterSamples( const std::vector<SimHashSelect>& candidates, const SimHash& needle, int maxNofElements, int nofSampleReads) const
 {
-	if (m_idar.empty()) return std::vector<SimHashQueryResult>();
+	std::vector<SimHashSelect> samples;
+	getBestFilterSamples( samples, candidates, nofSampleReads);
 
-	SimHashRankList ranklist( maxNofElements);
+	std::vector<int> sampleDistAr;
+	sampleDistAr.reserve( samples.size());
 
-	std::vector<SimHashSelect> candidates;
-	m_filter.search( candidates, needle, maxSimDist, maxProbSimDist);
+	std::vector<Index> featnolist;
+	featnolist.reserve( samples.size());
+	std::vector<SimHashSelect>::const_iterator si = samples.begin(), se = samples.end();
+	for (; si != se; ++si)
+	{
+		featnolist.push_back( m_idar[ si->idx]);
+	}
+	std::sort( featnolist.begin(), featnolist.end());
 
-	int nofSampleReads = maxNofElements*2 + 10;
-	if (nofSampleReads > RankList<SimHashSelect>::MaxSize) nofSampleReads = RankList<SimHashSelect>::MaxSize;
+	std::vector<const SimHash*> valar;
+	std::vector<SimHash> valbuf;
+	m_reader->loadMultiple( valar, valbuf, featnolist);
 
-	int lastdist = getMaxSimDistFromBestFilterSamples( candidates, needle, maxNofElements, nofSampleReads);
-	if (lastdist == 0) lastdist = maxSimDist;
-	int probSum = m_filter.maxProbSumDist( maxSimDist, lastdist * ((float)maxProbSimDist / (float)maxSimDist) + 1);
+	std::vector<const SimHash*>::const_iterator vi = valar.begin(), ve = valar.end();
+	for (; vi != ve; ++vi)
+	{
+		if (*vi)
+		{
+			sampleDistAr.push_back( (*vi)->dist( needle));
+		}
+	}
+	if (sampleDistAr.empty()) return 0;
+	std::sort( sampleDistAr.begin(), sampleDistAr.end());
+	return maxNofElements >= (int)sampleDistAr.size() ? 0 : sampleDistAr[ maxNofElements];
+}
+
+SimHashSlotSet SimHashMap::createSlotSet( const std::vector<Index>& featnolist) const
+{
+	SimHashSlotSet rt;
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	for (; fi != fe; ++fi)
+	{
+		std::vector<Index>::const_iterator si = std::lower_bound( m_idar.begin(), m_idar.end(), *fi);
+		if (si != m_idar.end() && *si == *fi)
+		{
+			rt.insert( si - m_idar.begin());
+		}
+	}
+	return rt;
+}
 
+std::vector<Index> SimHashMap::getCandidateFeatnoList( const std::vector<SimHashSelect>& candidates, int probSum) const
+{
+	std::vector<Index> rt;
 	std::vector<SimHashSelect>::const_iterator ci = candidates.begin(), ce = candidates.end();
 	for (; ci != ce; ++ci)
 	{
-		Index elemid = m_idar[ ci->idx];
 		if (ci->shdiff < probSum)
 		{
-			SimHash shbuf;
-			const SimHash* val = m_reader->load( elemid, shbuf);
-			if (val)
+			rt.push_back( m_idar[ ci->idx]);
+		}
+	}
+	std::sort( rt.begin(), rt.end());
+	return rt;
+}
+
+void SimHashMap::selectNearCandidates( std::vector<SimHashRank>& res, LoadBuffer& buf, const std::vector<Index>& chunk, const SimHash& needle, int maxSimDist) const
+{
+	std::vector<const SimHash*>& valar = buf.valar;
+	m_reader->loadMultiple( valar, buf.valbuf, chunk);
+
+	std::vector<const SimHash*>::const_iterator vi = valar.begin(), ve = valar.end();
+	for (; vi != ve; ++vi)
+	{
+		const SimHash* val = *vi;
+		if (val && val->near( needle, maxSimDist))
+		{
+			res.push_back( SimHashRank( val->id(), val->dist( needle)));
+		}
+	}
+}
+
+template <class RankListType>
+int SimHashMap::rankCandidates( RankListType& ranklist, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist) const
+{
+	int rt = 0;
+	std::vector<Index> chunk;
+	LoadBuffer buf;
+	std::vector<SimHashRank> near;
+
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	while (fi != fe)
+	{
+		std::vector<Index>::const_iterator chunkend = (fe - fi) > (std::ptrdiff_t)LoadChunkSize ? (fi + LoadChunkSize) : fe;
+		chunk.assign( fi, chunkend);
+		fi = chunkend;
+
+		near.clear();
+		selectNearCandidates( near, buf, chunk, needle, maxSimDist);
+		std::vector<SimHashRank>::const_iterator ni = near.begin(), ne = near.end();
+		for (; ni != ne; ++ni)
+		{
+			(void)ranklist.insert( *ni);
+		}
+		rt += near.size();
+	}
+	return rt;
+}
+
+int SimHashMap::collectCandidates( std::vector<SimHashRank>& res, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist) const
+{
+	std::size_t startsize = res.size();
+	std::vector<Index> chunk;
+	LoadBuffer buf;
+
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	while (fi != fe)
+	{
+		std::vector<Index>::const_iterator chunkend = (fe - fi) > (std::ptrdiff_t)LoadChunkSize ? (fi + LoadChunkSize) : fe;
+		chunk.assign( fi, chunkend);
+		fi = chunkend;
+
+		selectNearCandidates( res, buf, chunk, needle, maxSimDist);
+	}
+	return res.size() - startsize;
+}
+
+int SimHashMap::selectBestCandidates( std::vector<SimHashRank>& res, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist, int maxNofElements) const
+{
+	int rt = 0;
+	switch (m_topKMethod)
+	{
+		case TopKSelectRankList:
+		{
+			if (maxNofElements > SimHashRankList::MaxSize)
 			{
-				if (val->near( needle, maxSimDist))
+				// ... too many results for a ranklist, select the best of all values within the radius
+				rt = collectCandidates( res, featnolist, needle, maxSimDist);
+				if (res.size() > (std::size_t)maxNofElements)
+				{
+					std::partial_sort( res.begin(), res.begin() + maxNofElements, res.end());
+					res.resize( maxNofElements);
+				}
+				else
 				{
-					int dist = val->dist( needle);
-					(void)ranklist.insert( SimHashRank( elemid, dist));
+					std::sort( res.begin(), res.end());
 				}
 			}
+			else
+			{
+				SimHashRankList ranklist( maxNofElements);
+				rt = rankCandidates( ranklist, featnolist, needle, maxSimDist);
+				ranklist.getResult( res);
+			}
+			return rt;
+		}
+		case TopKSelectHeap:
+		{
+			TopKHeap<SimHashRank> ranklist( maxNofElements);
+			rt = rankCandidates( ranklist, featnolist, needle, maxSimDist);
+			ranklist.getResult( res);
+			return rt;
+		}
+		case TopKSelectBuckets:
+		{
+			TopKDistanceBuckets<SimHashRank,SimHashRankDistance> ranklist( maxNofElements);
+			rt = rankCandidates( ranklist, featnolist, needle, maxSimDist);
+			ranklist.getResult( res);
+			return rt;
 		}
 	}
-	return ranklist.result( needle.size());
+	throw std::runtime_error( _TXT("unknown top-k selection method"));
 }
 
-std::vector<SimHashQueryResult> SimHashMap::findSimilarWithStats( Stats& stats, const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements) const
+std::vector<SimHashQueryResult> SimHashMap::resultFromRanks( const std::vector<SimHashRank>& ranks, int nofLshBits)
 {
-	stats.nofValues = m_idar.size();
-	if (m_idar.empty()) return std::vector<SimHashQueryResult>();
+	std::vector<SimHashQueryResult> rt;
+	rt.reserve( ranks.size());
+	std::vector<SimHashRank>::const_iterator ri = ranks.begin(), re = ranks.end();
+	for (; ri != re; ++ri)
+	{
+		rt.push_back( SimHashQueryResult( ri->index, ri->simdist, SimHashRankList::weightFromLshSimDist( nofLshBits, ri->simdist)));
+	}
+	return rt;
+}
 
-	SimHashRankList ranklist( maxNofElements);
+int SimHashMap::findWithinRadius( ResultConsumerInterface& consumer, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const
+{
+	int rt = 0;
+	if (m_idar.empty()) return 0;
 
 	std::vector<SimHashSelect> candidates;
-	m_filter.searchWithStats( stats, candidates, needle, maxSimDist, maxProbSimDist);
+	m_filter.search( candidates, needle, maxSimDist, maxProbSimDist, slotFilter);
+	int probSum = m_filter.maxProbSumDist( maxSimDist, maxProbSimDist);
+	std::vector<Index> featnolist = getCandidateFeatnoList( candidates, probSum);
 
-	int nofSampleReads = maxNofElements*2 + 10;
-	if (nofSampleReads > RankList<SimHashSelect>::MaxSize) nofSampleReads = RankList<SimHashSelect>::MaxSize;
+	std::vector<Index> chunk;
+	LoadBuffer buf;
+	std::vector<SimHashRank> near;
+	std::vector<SimHashQueryResult> results;
+
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	while (fi != fe)
+	{
+		std::vector<Index>::const_iterator chunkend = (fe - fi) > (std::ptrdiff_t)LoadChunkSize ? (fi + LoadChunkSize) : fe;
+		chunk.assign( fi, chunkend);
+		fi = chunkend;
+
+		near.clear();
+		selectNearCandidates( near, buf, chunk, needle, maxSimDist);
+		if (near.empty()) continue;
+
+		results.clear();
+		std::vector<SimHashRank>::const_iterator ni = near.begin(), ne = near.end();
+		for (; ni != ne; ++ni)
+		{
+			results.push_back( SimHashQueryResult( ni->index, ni->simdist, SimHashRankList::weightFromLshSimDist( needle.size(), ni->simdist)));
+		}
+		rt += results.size();
+		if (!consumer.consume( results)) break;
+	}
+	return rt;
+}
+
+std::vector<SimHashQueryResult> SimHashMap::findSimilarImpl( Stats* stats, const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const
+{
+	if (stats) stats->nofValues = m_idar.size();
+	if (m_idar.empty()) return std::vector<SimHashQueryResult>();
 
+	std::vector<SimHashSelect> candidates;
+	if (stats)
+	{
+		m_filter.searchWithStats( *stats, candidates, needle, maxSimDist, maxProbSimDist, slotFilter);
+	}
+	else
+	{
+		m_filter.search( candidates, needle, maxSimDist, maxProbSimDist, slotFilter);
+	}
+	// ... the number of samples is not bound by the size of a ranklist, the samples of more than its size are selected like the results
+	int nofSampleReads = maxNofElements*2 + 10;
 	int lastdist = getMaxSimDistFromBestFilterSamples( candidates, needle, maxNofElements, nofSampleReads);
 	if (lastdist == 0) lastdist = maxSimDist;
 	int probSum = m_filter.maxProbSumDist( maxSimDist, lastdist * ((float)maxProbSimDist / (float)maxSimDist) + 1);
 
-	stats.nofDatabaseReads += nofSampleReads;
-	stats.probSum = probSum;
-	stats.samplesMaxDist = lastdist;
-
-	std::vector<SimHashSelect>::const_iterator ci = candidates.begin(), ce = candidates.end();
-	for (; ci != ce; ++ci)
+	std::vector<Index> featnolist = getCandidateFeatnoList( candidates, probSum);
+	std::vector<SimHashRank> ranks;
+	int nofRanked = selectBestCandidates( ranks, featnolist, needle, maxSimDist, maxNofElements);
+	if (stats)
 	{
-		Index elemid = m_idar[ ci->idx];
-		if (ci->shdiff < probSum)
-		{
-			++stats.nofDatabaseReads;
-			SimHash shbuf;
-			const SimHash* val = m_reader->load( elemid, shbuf);
-			if (val)
-			{
-				if (val->near( needle, maxSimDist))
-				{
-					++stats.nofResults;
-					int dist = val->dist( needle);
-					(void) ranklist.insert( SimHashRank( elemid, dist));
-				}
-			}
-		}
+		stats->nofDatabaseReads += std::min( nofSampleReads, (int)candidates.size()) + featnolist.size();
+		stats->probSum = probSum;
+		stats->samplesMaxDist = lastdist;
+		stats->nofResults += nofRanked;
 	}
-	return ranklist.result( needle.size());
+	return resultFromRanks( ranks, needle.size());
+}
+
+std::vector<SimHashQueryResult> SimHashMap::findSimilar( const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const
+{
+	return findSimilarImpl( NULL, needle, maxSimDist, maxProbSimDist, maxNofElements, slotFilter);
+}
+
+std::vector<SimHashQueryResult> SimHashMap::findSimilarWithStats( Stats& stats, const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const
+{
+	return findSimilarImpl( &stats, needle, maxSimDist, maxProbSimDist, maxNofElements, slotFilter);
 }
 
 
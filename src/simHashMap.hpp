@@ -13,17 +13,22 @@
 #include "simHashFilter.hpp"
 #include "simHashReader.hpp"
 #include "simHashQueryResult.hpp"
-#include "simHashReader.hpp"
+#include "vectorMemoryStore.hpp"
+#include "productQuantizer.hpp"
+#include "topKSelect.hpp"
 #include <utility>
 #include <vector>
 
 namespace strus {
 
+/// \brief Forward declaration
+struct SimHashRank;
+
 /// \brief Structure for retrieval of the most similar LSH values
 class SimHashMap
 {
 public:
-	enum {MaxNofBenches=4};
+	enum {MaxNofBenches=4, LoadChunkSize=1024};
 	struct Stats
 		:public SimHashFilter::Stats
 	{
@@ -40,37 +45,147 @@ public:
 	};
 
 	SimHashMap( const strus::Reference<SimHashReaderInterface>& reader_, const strus::Index& typeno_)
-		:m_filter(),m_idar(),m_reader(reader_),m_typeno(typeno_){}
+		:m_filter(),m_idar(),m_reader(reader_),m_vectorStore(),m_productQuantizer(),m_topKMethod(TopKSelectRankList),m_typeno(typeno_),m_serialno(0){}
 	SimHashMap( const SimHashMap& o)
-		:m_filter(o.m_filter),m_idar(o.m_idar),m_reader(o.m_reader),m_typeno(o.m_typeno){}
+		:m_filter(o.m_filter),m_idar(o.m_idar),m_reader(o.m_reader),m_vectorStore(o.m_vectorStore),m_productQuantizer(o.m_productQuantizer),m_topKMethod(o.m_topKMethod),m_typeno(o.m_typeno),m_serialno(o.m_serialno){}
 	~SimHashMap(){}
 #if __cplusplus >= 201103L
 	SimHashMap( SimHashMap&& o)
-		:m_filter(std::move(o.m_filter)),m_idar(std::move(o.m_idar)),m_reader(std::move(o.m_reader)),m_typeno(o.m_typeno){}
+		:m_filter(std::move(o.m_filter)),m_idar(std::move(o.m_idar)),m_reader(std::move(o.m_reader)),m_vectorStore(std::move(o.m_vectorStore)),m_productQuantizer(std::move(o.m_productQuantizer)),m_topKMethod(o.m_topKMethod),m_typeno(o.m_typeno),m_serialno(o.m_serialno){}
 	SimHashMap& operator =( SimHashMap&& o)
-		{m_filter = std::move(o.m_filter); m_idar = std::move(o.m_idar); m_reader = std::move(o.m_reader); m_typeno = o.m_typeno; return *this;}
+		{m_filter = std::move(o.m_filter); m_idar = std::move(o.m_idar); m_reader = std::move(o.m_reader); m_vectorStore = std::move(o.m_vectorStore); m_productQuantizer = std::move(o.m_productQuantizer); m_topKMethod = o.m_topKMethod; m_typeno = o.m_typeno; m_serialno = o.m_serialno; return *this;}
 #endif
 	SimHashMap& operator =( const SimHashMap& o)
-		{m_filter = o.m_filter; m_idar = o.m_idar; m_reader = o.m_reader; m_typeno = o.m_typeno; return *this;}
+		{m_filter = o.m_filter; m_idar = o.m_idar; m_reader = o.m_reader; m_vectorStore = o.m_vectorStore; m_productQuantizer = o.m_productQuantizer; m_topKMethod = o.m_topKMethod; m_typeno = o.m_typeno; m_serialno = o.m_serialno; return *this;}
+
+	/// \brief Interface for consuming the results of a radius search chunk by chunk
+	class ResultConsumerInterface
+	{
+	public:
+		virtual ~ResultConsumerInterface(){}
+		/// \brief Consume a chunk of results
+		/// \param[in,out] chunk results in ascending order of feature numbers
+		/// \return false, if the search should be stopped
+		virtual bool consume( std::vector<SimHashQueryResult>& chunk)=0;
+	};
 
 	void load();
 
-	std::vector<SimHashQueryResult> findSimilar( const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements) const;
-	std::vector<SimHashQueryResult> findSimilarWithStats( Stats& stats,const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements) const;
+	/// \brief Find the most similar LSH values
+	/// \note With the ranklist as top-k selection method and maxNofElements bigger than its maximum size, all values within the radius are collected and the best selected with a partial sort
+	/// \param[in] slotFilter set of slots allowed as results or NULL if all are allowed (see createSlotSet)
+	std::vector<SimHashQueryResult> findSimilar( const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const;
+	std::vector<SimHashQueryResult> findSimilarWithStats( Stats& stats,const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const;
+
+	/// \brief Find all LSH values within a radius without a limit of the number of results
+	/// \param[in] consumer receiver of the results in chunks with ascending feature numbers
+	/// \param[in] needle LSH value to search for
+	/// \param[in] maxSimDist maximum edit distance of the results
+	/// \param[in] maxProbSimDist maximum edit distance in the filter (speed/recall tradeoff)
+	/// \param[in] slotFilter set of slots allowed as results or NULL if all are allowed (see createSlotSet)
+	/// \return the number of results passed to the consumer
+	int findWithinRadius( ResultConsumerInterface& consumer, const SimHash& needle, int maxSimDist, int maxProbSimDist, const SimHashSlotSet* slotFilter) const;
+
+	/// \brief Create the set of slots of a list of features for restricting a search to these features
+	/// \param[in] featnolist list of feature numbers allowed, features without an LSH value of this type are ignored
+	/// \return the set of slots to pass to a search
+	SimHashSlotSet createSlotSet( const std::vector<Index>& featnolist) const;
 
 	const strus::Index& typeno() const
 	{
 		return m_typeno;
 	}
 
+	/// \brief Set the serial number of this searcher, unique among the searchers created by a storage client
+	void setSerialNumber( int serialno_)
+	{
+		m_serialno = serialno_;
+	}
+	/// \brief Get the serial number of this searcher, identifies it without keeping it referenced
+	int serialNumber() const
+	{
+		return m_serialno;
+	}
+
+	/// \brief Attach an in memory store of the vectors of this type for reranking results with real vector weights
+	void setVectorStore( const strus::Reference<VectorMemoryStore>& vectorStore_)
+	{
+		m_vectorStore = vectorStore_;
+	}
+	/// \brief Get the in memory store of the vectors of this type if defined
+	/// \return the vector store or NULL if not defined
+	const VectorMemoryStore* vectorStore() const
+	{
+		return m_vectorStore.get();
+	}
+
+	/// \brief Attach a product quantization of the vectors of this type for approximate reranking of results
+	void setProductQuantizer( const strus::Reference<ProductQuantizer>& productQuantizer_)
+	{
+		m_productQuantizer = productQuantizer_;
+	}
+	/// \brief Get the product quantization of the vectors of this type if defined
+	/// \return the product quantization or NULL if not defined
+	const ProductQuantizer* productQuantizer() const
+	{
+		return m_productQuantizer.get();
+	}
+
+	/// \brief Define the method used for selecting the best k elements in the sampling and the ranking of a search
+	void setTopKMethod( TopKSelectMethod topKMethod_)
+	{
+		m_topKMethod = topKMethod_;
+	}
+	/// \brief Get the method used for selecting the best k elements
+	TopKSelectMethod topKMethod() const
+	{
+		return m_topKMethod;
+	}
+
 private:
+	/// \brief Search implementation of findSimilar and findSimilarWithStats
+	/// \param[out] stats statistics to fill or NULL if not wanted
+	std::vector<SimHashQueryResult> findSimilarImpl( Stats* stats, const SimHash& needle, int maxSimDist, int maxProbSimDist, int maxNofElements, const SimHashSlotSet* slotFilter) const;
+	/// \brief Select the best candidates of the filter for sampling with the top-k selection method configured
+	void getBestFilterSamples( std::vector<SimHashSelect>& res, const std::vector<SimHashSelect>& candidates, int nofSampleReads) const;
 	int getMaxSimDistFromBestFilterSamples( const std::vector<SimHashSelect>& candidates, const SimHash& needle, int maxNofElements, int nofSampleReads) const;
+	/// \brief Load the LSH values of a list of features in chunks and insert the ones near to the needle into a ranklist
+	/// \param[in] featnolist feature numbers sorted in ascending order
+	/// \return the number of values inserted
+	template <class RankListType>
+	int rankCandidates( RankListType& ranklist, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist) const;
+	/// \brief Load the LSH values of a list of features in chunks and collect the ones near to the needle
+	/// \return the number of values collected
+	int collectCandidates( std::vector<SimHashRank>& res, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist) const;
+	/// \brief Buffers for loading the LSH values of the chunks of one query, reused from chunk to chunk
+	struct LoadBuffer
+	{
+		std::vector<const SimHash*> valar;
+		std::vector<SimHash> valbuf;
+
+		LoadBuffer()
+			:valar(),valbuf(){}
+	};
+	/// \brief Load the LSH values of one chunk of features and append the ones near to the needle
+	void selectNearCandidates( std::vector<SimHashRank>& res, LoadBuffer& buf, const std::vector<Index>& chunk, const SimHash& needle, int maxSimDist) const;
+	/// \brief Select the best candidates near to the needle with the top-k selection method configured
+	/// \param[out] res the best candidates sorted by ascending distance
+	/// \return the number of values near to the needle
+	int selectBestCandidates( std::vector<SimHashRank>& res, const std::vector<Index>& featnolist, const SimHash& needle, int maxSimDist, int maxNofElements) const;
+	/// \brief Map a list of ranks to query results
+	static std::vector<SimHashQueryResult> resultFromRanks( const std::vector<SimHashRank>& ranks, int nofLshBits);
+	/// \brief Get the sorted list of feature numbers of the candidates passing the filter
+	std::vector<Index> getCandidateFeatnoList( const std::vector<SimHashSelect>& candidates, int probSum) const;
 
 private:
 	SimHashFilter m_filter;
 	std::vector<Index> m_idar;
 	strus::Reference<SimHashReaderInterface> m_reader;
+	strus::Reference<VectorMemoryStore> m_vectorStore;
+	strus::Reference<ProductQuantizer> m_productQuantizer;
+	TopKSelectMethod m_topKMethod;
 	strus::Index m_typeno;
+	int m_serialno;			///< serial number of the searcher in the order of creation by the storage client, 0 if not assigned
 };
 
 }//namespace
@@ -12,16 +12,34 @@
 using namespace strus;
 
 SimHashReaderDatabase::SimHashReaderDatabase( const DatabaseAdapter* database_, const std::string& type_)
-	:m_database(database_),m_type(type_),m_typeno(database_->readTypeno( type_)),m_aridx(0),m_ar(),m_value()
+	:m_database(database_),m_type(type_),m_typeno(database_->readTypeno( type_))
+	,m_cursor(),m_aridx(0),m_ar()
 {
 	if (!m_typeno) throw strus::runtime_error( _TXT("error instantiating similarity hash reader: unknown type %s"), m_type.c_str());
 }
 
+bool SimHashReaderDatabase::loadFirstChunk()
+{
+	// ... the cursor (with the database snapshot it holds) lives only during a pass, not as long as the searcher using this reader
+	m_cursor.reset( new DatabaseAdapter::SimHashCursor( m_database, m_database->simHashLayout(), m_typeno));
+	m_ar.reserve( ReadChunkSize);
+	return loadChunk( true);
+}
+
+bool SimHashReaderDatabase::loadChunk( bool first)
+{
+	if (!m_cursor.get()) return false;
+	if (first ? m_cursor->loadFirst( m_ar, ReadChunkSize) : m_cursor->loadNext( m_ar, ReadChunkSize)) return true;
+	// ... end of the pass
+	m_cursor.reset();
+	std::vector<SimHash>().swap( m_ar);
+	return false;
+}
+
 const SimHash* SimHashReaderDatabase::loadFirst()
 {
 	m_aridx = 0;
-	m_ar = m_database->readSimHashVector( m_typeno, 1/*featnostart*/, ReadChunkSize);
-	if (m_ar.empty()) return NULL;
+	if (!loadFirstChunk()) return NULL;
 	return &m_ar[ m_aridx++];
 }
 
@@ -29,19 +47,45 @@ const SimHash* SimHashReaderDatabase::loadNext()
 {
 	if (m_aridx >= m_ar.size())
 	{
-		if (m_ar.empty()) return loadFirst();
-		Index featnostart = m_ar.back().id()+1;
-		m_ar = m_database->readSimHashVector( m_typeno, featnostart, ReadChunkSize);
-		if (m_ar.empty()) return NULL;
 		m_aridx = 0;
+		if (!loadChunk( false)) return NULL;
 	}
 	return &m_ar[ m_aridx++];
 }
 
-const SimHash* SimHashReaderDatabase::load( const Index& featno, SimHash& buf) const
+const SimHash* SimHashReaderDatabase::loadFirstBlock( std::size_t& size)
+{
+	m_aridx = 0;
+	size = 0;
+	if (!loadFirstChunk()) return NULL;
+	m_aridx = size = m_ar.size();
+	return &m_ar[0];
+}
+
+const SimHash* SimHashReaderDatabase::loadNextBlock( std::size_t& size)
+{
+	m_aridx = 0;
+	size = 0;
+	if (!loadChunk( false)) return NULL;
+	m_aridx = size = m_ar.size();
+	return &m_ar[0];
+}
+
+const SimHash* SimHashReaderDatabase::load( const Index& featno, SimHash& buf, std::string& blobbuf) const
+{
+	return m_database->readSimHash( buf, blobbuf, m_typeno, featno) ? &buf : NULL;
+}
+
+void SimHashReaderDatabase::loadMultiple( std::vector<const SimHash*>& res, std::vector<SimHash>& buf, const std::vector<Index>& featnolist) const
 {
-	buf = m_database->readSimHash( m_typeno, featno);
-	return buf.defined() ? &buf : NULL;
+	m_database->readSimHashes( buf, m_typeno, featnolist);
+	res.clear();
+	res.reserve( buf.size());
+	std::vector<SimHash>::const_iterator bi = buf.begin(), be = buf.end();
+	for (; bi != be; ++bi)
+	{
+		res.push_back( bi->defined() ? &*bi : NULL);
+	}
 }
 
 
@@ -70,11 +114,38 @@ const SimHash* SimHashReaderMemory::loadNext()
 	return &m_ar[ m_aridx++];
 }
 
-const SimHash* SimHashReaderMemory::load( const Index& featno, SimHash&) const
+const SimHash* SimHashReaderMemory::loadFirstBlock( std::size_t& size)
+{
+	m_aridx = 0;
+	return loadNextBlock( size);
+}
+
+const SimHash* SimHashReaderMemory::loadNextBlock( std::size_t& size)
+{
+	size = m_ar.size() - m_aridx;
+	if (size == 0) return NULL;
+	if (size > BlockSize) size = BlockSize;
+	const SimHash* rt = &m_ar[ m_aridx];
+	m_aridx += size;
+	return rt;
+}
+
+const SimHash* SimHashReaderMemory::load( const Index& featno, SimHash&, std::string&) const
 {
 	std::map<Index,std::size_t>::const_iterator fi = m_indexmap.find( featno);
 	if (fi == m_indexmap.end()) return NULL;
 	return &m_ar[ fi->second];
 }
 
+void SimHashReaderMemory::loadMultiple( std::vector<const SimHash*>& res, std::vector<SimHash>&, const std::vector<Index>& featnolist) const
+{
+	res.clear();
+	res.reserve( featnolist.size());
+	std::vector<Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+	for (; fi != fe; ++fi)
+	{
+		std::map<Index,std::size_t>::const_iterator mi = m_indexmap.find( *fi);
+		res.push_back( mi == m_indexmap.end() ? NULL : &m_ar[ mi->second]);
+	}
+}
 
@@ -12,6 +12,7 @@
 #include "databaseAdapter.hpp"
 #include "simHash.hpp"
 #include <string>
+#include <vector>
 #include <map>
 
 namespace strus {
@@ -28,12 +29,31 @@ public:
 	/// \note not thead-safe
 	virtual const SimHash* loadNext()=0;
 
+	/// \brief Loads the first block of LSH values (for iteration in blocks)
+	/// \param[out] size number of values in the block loaded
+	/// \return pointer to the values of the block, valid until the next call of a load method, or NULL if there are no values
+	/// \note not thead-safe
+	virtual const SimHash* loadFirstBlock( std::size_t& size)=0;
+	/// \brief Loads the next block of LSH values (for iteration in blocks)
+	/// \param[out] size number of values in the block loaded
+	/// \return pointer to the values of the block, valid until the next call of a load method, or NULL if there are no values left
+	/// \note not thead-safe
+	virtual const SimHash* loadNextBlock( std::size_t& size)=0;
+
 	/// \brief Loads a specific LSH value
 	/// \param[in] id feature number of LSH value to retrieve
 	/// \param[out] buf buffer to use for value read if needed, not necessarily used
+	/// \param[out] blobbuf buffer of the caller for the serialization read if needed, reused for consecutive calls
 	/// \return pointer to value loaded (value not necessarily in buf, depends on implementation)
 	/// \note thead-safe
-	virtual const SimHash* load( const Index& id, SimHash& buf) const=0;
+	virtual const SimHash* load( const Index& id, SimHash& buf, std::string& blobbuf) const=0;
+
+	/// \brief Loads the LSH values of a list of features
+	/// \param[out] res pointers to the values loaded in the order of featnolist, NULL for a value not found
+	/// \param[out] buf buffer to use for the values read if needed, not necessarily used
+	/// \param[in] featnolist feature numbers of the LSH values to retrieve, sorted in ascending order
+	/// \note thead-safe
+	virtual void loadMultiple( std::vector<const SimHash*>& res, std::vector<SimHash>& buf, const std::vector<Index>& featnolist) const=0;
 };
 
 
@@ -46,16 +66,25 @@ public:
 
 	virtual const SimHash* loadFirst();
 	virtual const SimHash* loadNext();
-	virtual const SimHash* load( const Index& featno, SimHash& buf) const;
+	virtual const SimHash* loadFirstBlock( std::size_t& size);
+	virtual const SimHash* loadNextBlock( std::size_t& size);
+	virtual const SimHash* load( const Index& featno, SimHash& buf, std::string& blobbuf) const;
+	virtual void loadMultiple( std::vector<const SimHash*>& res, std::vector<SimHash>& buf, const std::vector<Index>& featnolist) const;
+
+private:
+	/// \brief Create the cursor of a new pass and load the first chunk of values
+	bool loadFirstChunk();
+	/// \brief Load the first or the next chunk of values of the current pass, release the cursor at the end of the pass
+	bool loadChunk( bool first);
 
 private:
 	enum {ReadChunkSize=1024};
 	const DatabaseAdapter* m_database;
 	std::string m_type;
 	Index m_typeno;
+	strus::Reference<DatabaseAdapter::SimHashCursor> m_cursor;	///< cursor of the current linear pass over all values, created by loadFirst and released at the end of the pass
 	std::size_t m_aridx;
-	std::vector<SimHash> m_ar;
-	SimHash m_value;
+	std::vector<SimHash> m_ar;			///< buffer for the values of the current block of the iteration
 };
 
 class SimHashReaderMemory
@@ -67,9 +96,13 @@ public:
 
 	virtual const SimHash* loadFirst();
 	virtual const SimHash* loadNext();
-	virtual const SimHash* load( const Index& featno, SimHash& buf) const;
+	virtual const SimHash* loadFirstBlock( std::size_t& size);
+	virtual const SimHash* loadNextBlock( std::size_t& size);
+	virtual const SimHash* load( const Index& featno, SimHash& buf, std::string& blobbuf) const;
+	virtual void loadMultiple( std::vector<const SimHash*>& res, std::vector<SimHash>& buf, const std::vector<Index>& featnolist) const;
 
 private:
+	enum {BlockSize=1024};
 	const DatabaseAdapter* m_database;
 	std::string m_type;
 	Index m_typeno;
@@ -0,0 +1,246 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Structures for the selection of the best k elements of a search as alternatives to the ranklist
+#ifndef _STRUS_VECTOR_TOPK_SELECT_HPP_INCLUDED
+#define _STRUS_VECTOR_TOPK_SELECT_HPP_INCLUDED
+#include "internationalization.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace strus {
+
+/// \brief Method used for selecting the best k elements of a search
+enum TopKSelectMethod
+{
+	TopKSelectRankList,		///< fixed size array with insertion by shuffling an index array (k <= 256)
+	TopKSelectHeap,			///< bounded 4-ary heap with a final sort
+	TopKSelectBuckets		///< buckets indexed by the small integer distance of the elements
+};
+
+/// \brief Get the name of a top-k selection method as used in the configuration
+static inline const char* topKSelectMethodName( TopKSelectMethod method)
+{
+	static const char* ar[] = {"list","heap","bucket"};
+	return ar[ method];
+}
+
+/// \brief Get the top-k selection method from its name in the configuration
+/// \return true on success, false if the name is unknown
+static inline bool topKSelectMethodFromName( TopKSelectMethod& res, const std::string& name)
+{
+	if (0==std::strcmp( name.c_str(), "list")) {res = TopKSelectRankList; return true;}
+	if (0==std::strcmp( name.c_str(), "heap")) {res = TopKSelectHeap; return true;}
+	if (0==std::strcmp( name.c_str(), "bucket")) {res = TopKSelectBuckets; return true;}
+	return false;
+}
+
+/// \brief Bounded 4-ary max heap keeping the k smallest elements (according to operator <) inserted
+/// \note The worst element kept is at the root of the heap, a rejected insert costs one comparison
+template <typename Element>
+class TopKHeap
+{
+public:
+	enum {Arity=4, MaxReserve=1024};
+
+public:
+	explicit TopKHeap( int maxNofRanks_)
+		:m_ar(),m_nofRanks(0),m_maxNofRanks(maxNofRanks_)
+	{
+		if (maxNofRanks_ <= 0) throw std::runtime_error( _TXT( "illegal value for maximum number of ranks"));
+		m_ar.reserve( maxNofRanks_ > MaxReserve ? (int)MaxReserve : maxNofRanks_);
+	}
+
+	std::size_t size() const
+	{
+		return m_ar.size();
+	}
+
+	bool empty() const
+	{
+		return m_ar.empty();
+	}
+
+	bool complete() const
+	{
+		return m_nofRanks > m_maxNofRanks;
+	}
+
+	/// \brief Get the worst element kept
+	const Element& back() const
+	{
+		if (m_ar.empty()) throw std::runtime_error(_TXT("array bound read in top-k heap"));
+		return m_ar[0];
+	}
+
+	bool insert( const Element& elem)
+	{
+		if (m_ar.size() < (std::size_t)m_maxNofRanks)
+		{
+			m_ar.push_back( elem);
+			siftUp( m_ar.size()-1);
+		}
+		else if (elem < m_ar[0])
+		{
+			m_ar[0] = elem;
+			siftDown( 0);
+		}
+		else
+		{
+			return false;
+		}
+		++m_nofRanks;
+		return true;
+	}
+
+	/// \brief Get the elements kept sorted in ascending order
+	void getResult( std::vector<Element>& res) const
+	{
+		res.assign( m_ar.begin(), m_ar.end());
+		std::sort( res.begin(), res.end());
+	}
+
+private:
+	void siftUp( std::size_t idx)
+	{
+		Element elem = m_ar[ idx];
+		while (idx > 0)
+		{
+			std::size_t parent = (idx-1) / Arity;
+			if (!(m_ar[ parent] < elem)) break;
+			m_ar[ idx] = m_ar[ parent];
+			idx = parent;
+		}
+		m_ar[ idx] = elem;
+	}
+
+	void siftDown( std::size_t idx)
+	{
+		Element elem = m_ar[ idx];
+		std::size_t nn = m_ar.size();
+		for (;;)
+		{
+			std::size_t first = idx * Arity + 1;
+			if (first >= nn) break;
+			std::size_t last = first + Arity > nn ? nn : first + Arity;
+			std::size_t maxchild = first;
+			for (std::size_t ci = first+1; ci < last; ++ci)
+			{
+				if (m_ar[ maxchild] < m_ar[ ci]) maxchild = ci;
+			}
+			if (!(elem < m_ar[ maxchild])) break;
+			m_ar[ idx] = m_ar[ maxchild];
+			idx = maxchild;
+		}
+		m_ar[ idx] = elem;
+	}
+
+private:
+	std::vector<Element> m_ar;
+	int m_nofRanks;
+	int m_maxNofRanks;
+};
+
+/// \brief Selection of the k elements with the smallest distance with the distances as bucket index
+/// \note Suitable for elements with a small integer distance like the edit distance of LSH values
+/// \note The order of elements with the same distance is defined by operator < of the element
+/// \note Elements with the distance of the worst element kept are rejected once enough elements are kept, ties at the cutoff distance are therefore decided by the order of insertion
+/// \param Element type of the elements selected
+/// \param DistanceOf class with a static method 'int get( const Element&)' returning the distance of an element
+template <typename Element, class DistanceOf>
+class TopKDistanceBuckets
+{
+public:
+	enum {MaxDistance=0xFFFF};
+
+public:
+	explicit TopKDistanceBuckets( int maxNofRanks_)
+		:m_buckets(),m_size(0),m_top(-1),m_cutoff(MaxDistance),m_nofRanks(0),m_maxNofRanks(maxNofRanks_)
+	{
+		if (maxNofRanks_ <= 0) throw std::runtime_error( _TXT( "illegal value for maximum number of ranks"));
+	}
+
+	std::size_t size() const
+	{
+		return m_size > (std::size_t)m_maxNofRanks ? (std::size_t)m_maxNofRanks : m_size;
+	}
+
+	bool empty() const
+	{
+		return m_size == 0;
+	}
+
+	bool complete() const
+	{
+		return m_nofRanks > m_maxNofRanks;
+	}
+
+	bool insert( const Element& elem)
+	{
+		int dist = DistanceOf::get( elem);
+		if (dist < 0 || dist > MaxDistance) throw std::runtime_error( _TXT( "distance out of range in top-k buckets"));
+		if (m_size >= (std::size_t)m_maxNofRanks ? dist >= m_cutoff : dist > m_cutoff)
+		{
+			// ... once the buckets hold enough elements, elements with the cutoff distance would only grow its bucket without changing the result
+			return false;
+		}
+		if (dist >= (int)m_buckets.size()) m_buckets.resize( dist+1);
+
+		m_buckets[ dist].push_back( elem);
+		++m_size;
+		++m_nofRanks;
+		if (dist > m_top) m_top = dist;
+
+		if (m_size >= (std::size_t)m_maxNofRanks)
+		{
+			// ... drop the buckets with the biggest distance as long as the others hold enough elements
+			while (m_size - m_buckets[ m_top].size() >= (std::size_t)m_maxNofRanks)
+			{
+				m_size -= m_buckets[ m_top].size();
+				m_buckets[ m_top].clear();
+				for (--m_top; m_top > 0 && m_buckets[ m_top].empty(); --m_top){}
+			}
+			m_cutoff = m_top;
+		}
+		return true;
+	}
+
+	/// \brief Get the best elements sorted in ascending order
+	void getResult( std::vector<Element>& res) const
+	{
+		res.clear();
+		std::size_t bi = 0, be = m_buckets.size();
+		for (; bi != be && res.size() < (std::size_t)m_maxNofRanks; ++bi)
+		{
+			const std::vector<Element>& bucket = m_buckets[ bi];
+			if (bucket.empty()) continue;
+
+			std::size_t startidx = res.size();
+			res.insert( res.end(), bucket.begin(), bucket.end());
+			std::sort( res.begin() + startidx, res.end());
+		}
+		if (res.size() > (std::size_t)m_maxNofRanks)
+		{
+			res.resize( m_maxNofRanks);
+		}
+	}
+
+private:
+	std::vector<std::vector<Element> > m_buckets;
+	std::size_t m_size;
+	int m_top;
+	int m_cutoff;
+	int m_nofRanks;
+	int m_maxNofRanks;
+};
+
+}//namespace
+#endif
+
@@ -21,6 +21,8 @@ class VectorDef
 public:
 	explicit VectorDef( const Index& id_)
 		:m_vec(),m_lsh(),m_id(id_){}
+	VectorDef( const WordVector& vec_, const Index& id_)
+		:m_vec(vec_),m_lsh(),m_id(id_){}
 	VectorDef( const WordVector& vec_, const SimHash& lsh_, const Index& id_)
 		:m_vec(vec_),m_lsh(lsh_),m_id(id_){}
 	VectorDef( const VectorDef& o)
@@ -30,6 +32,12 @@ public:
 	const SimHash& lsh() const	{return m_lsh;}
 	const Index& id() const		{return m_id;}
 
+	void setLsh( const SimHash& lsh_)
+	{
+		m_lsh = lsh_;
+		m_lsh.setId( m_id);
+	}
+
 	void setId( const Index& id_)
 	{
 		m_id = id_;
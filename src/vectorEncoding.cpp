@@ -0,0 +1,207 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Encoding of the vectors stored
+#include "vectorEncoding.hpp"
+#include "vectorKernels.hpp"
+#include "internationalization.hpp"
+#include "strus/base/hton.hpp"
+#include <cmath>
+#include <cctype>
+#include <cstring>
+
+using namespace strus;
+
+const char* strus::vectorEncodingName( VectorEncoding encoding)
+{
+	switch (encoding)
+	{
+		case VectorEncodingFloat32: return "fp32";
+		case VectorEncodingFloat16: return "fp16";
+		case VectorEncodingBFloat16: return "bf16";
+		case VectorEncodingInt8: return "int8";
+	}
+	return 0;
+}
+
+VectorEncoding strus::vectorEncodingFromName( const std::string& name)
+{
+	std::string nam;
+	std::string::const_iterator ni = name.begin(), ne = name.end();
+	for (; ni != ne; ++ni) nam.push_back( std::tolower( *ni));
+	if (nam == "fp32" || nam == "float32" || nam == "float") return VectorEncodingFloat32;
+	if (nam == "fp16" || nam == "float16" || nam == "half") return VectorEncodingFloat16;
+	if (nam == "bf16" || nam == "bfloat16") return VectorEncodingBFloat16;
+	if (nam == "int8") return VectorEncodingInt8;
+	throw strus::runtime_error( _TXT("unknown vector encoding '%s' (expected one of fp32,fp16,bf16,int8)"), name.c_str());
+}
+
+std::size_t strus::vectorEncodingElementSize( VectorEncoding encoding)
+{
+	switch (encoding)
+	{
+		case VectorEncodingFloat32: return sizeof(float);
+		case VectorEncodingFloat16: return sizeof(uint16_t);
+		case VectorEncodingBFloat16: return sizeof(uint16_t);
+		case VectorEncodingInt8: return sizeof(int8_t);
+	}
+	return 0;
+}
+
+static float getInt8Scale( const float* vec, std::size_t vecsize)
+{
+	float maxabs = 0.0;
+	std::size_t vi = 0;
+	for (; vi != vecsize; ++vi)
+	{
+		float aval = std::fabs( vec[ vi]);
+		if (aval > maxabs) maxabs = aval;
+	}
+	return maxabs > 0.0 ? (maxabs / 127) : 1.0;
+}
+
+static int8_t floatToInt8( float val, float scale)
+{
+	float qval = val / scale;
+	if (qval >= 127.0) return 127;
+	if (qval <= -127.0) return -127;
+	return (int8_t)(qval < 0.0 ? (qval - 0.5) : (qval + 0.5));
+}
+
+template <typename ElementType>
+static void appendNetValue( std::string& blob, const ElementType& val)
+{
+	typename ByteOrder<ElementType>::net_value_type buf = ByteOrder<ElementType>::hton( val);
+	blob.append( (const char*)&buf, sizeof(buf));
+}
+
+template <typename ElementType>
+static ElementType getNetValue( const char* ptr)
+{
+	typename ByteOrder<ElementType>::net_value_type buf;
+	std::memcpy( &buf, ptr, sizeof(buf));
+	return ByteOrder<ElementType>::ntoh( buf);
+}
+
+std::string strus::vectorEncodedSerialization( const WordVector& vec, VectorEncoding encoding)
+{
+	std::string rt;
+	WordVector::const_iterator vi = vec.begin(), ve = vec.end();
+	switch (encoding)
+	{
+		case VectorEncodingFloat32:
+			rt.reserve( vec.size() * sizeof(float));
+			for (; vi != ve; ++vi) appendNetValue<float>( rt, *vi);
+			break;
+		case VectorEncodingFloat16:
+			rt.reserve( vec.size() * sizeof(uint16_t));
+			for (; vi != ve; ++vi) appendNetValue<uint16_t>( rt, floatToFloat16( *vi));
+			break;
+		case VectorEncodingBFloat16:
+			rt.reserve( vec.size() * sizeof(uint16_t));
+			for (; vi != ve; ++vi) appendNetValue<uint16_t>( rt, floatToBFloat16( *vi));
+			break;
+		case VectorEncodingInt8:
+		{
+			rt.reserve( sizeof(float) + vec.size());
+			float scale = vec.empty() ? 1.0 : getInt8Scale( &vec[0], vec.size());
+			appendNetValue<float>( rt, scale);
+			for (; vi != ve; ++vi) rt.push_back( (char)floatToInt8( *vi, scale));
+			break;
+		}
+	}
+	return rt;
+}
+
+WordVector strus::vectorFromEncodedSerialization( const char* blob, std::size_t blobsize, VectorEncoding encoding)
+{
+	WordVector rt;
+	vectorFromEncodedSerialization( rt, blob, blobsize, encoding);
+	return rt;
+}
+
+void strus::vectorFromEncodedSerialization( WordVector& rt, const char* blob, std::size_t blobsize, VectorEncoding encoding)
+{
+	rt.clear();
+	switch (encoding)
+	{
+		case VectorEncodingFloat32:
+		{
+			if (blobsize % sizeof(float) != 0) break;
+			rt.reserve( blobsize / sizeof(float));
+			char const* bi = blob;
+			const char* be = blob + blobsize;
+			for (; bi != be; bi += sizeof(float)) rt.push_back( getNetValue<float>( bi));
+			return;
+		}
+		case VectorEncodingFloat16:
+		case VectorEncodingBFloat16:
+		{
+			if (blobsize % sizeof(uint16_t) != 0) break;
+			rt.reserve( blobsize / sizeof(uint16_t));
+			char const* bi = blob;
+			const char* be = blob + blobsize;
+			if (encoding == VectorEncodingFloat16)
+			{
+				for (; bi != be; bi += sizeof(uint16_t)) rt.push_back( float16ToFloat( getNetValue<uint16_t>( bi)));
+			}
+			else
+			{
+				for (; bi != be; bi += sizeof(uint16_t)) rt.push_back( bfloat16ToFloat( getNetValue<uint16_t>( bi)));
+			}
+			return;
+		}
+		case VectorEncodingInt8:
+		{
+			if (blobsize < sizeof(float)) break;
+			float scale = getNetValue<float>( blob);
+			rt.reserve( blobsize - sizeof(float));
+			char const* bi = blob + sizeof(float);
+			const char* be = blob + blobsize;
+			for (; bi != be; ++bi) rt.push_back( scale * (float)(int8_t)*bi);
+			return;
+		}
+	}
+	throw std::runtime_error( _TXT("corrupt data in vector serialization"));
+}
+
+float strus::vectorEncodeElements( void* dest, const float* vec, std::size_t vecsize, VectorEncoding encoding)
+{
+	std::size_t vi = 0;
+	switch (encoding)
+	{
+		case VectorEncodingFloat32:
+			std::memcpy( dest, vec, vecsize * sizeof(float));
+			return 1.0;
+		case VectorEncodingFloat16:
+			for (; vi != vecsize; ++vi) ((uint16_t*)dest)[ vi] = floatToFloat16( vec[ vi]);
+			return 1.0;
+		case VectorEncodingBFloat16:
+			for (; vi != vecsize; ++vi) ((uint16_t*)dest)[ vi] = floatToBFloat16( vec[ vi]);
+			return 1.0;
+		case VectorEncodingInt8:
+		{
+			float scale = getInt8Scale( vec, vecsize);
+			for (; vi != vecsize; ++vi) ((int8_t*)dest)[ vi] = floatToInt8( vec[ vi], scale);
+			return scale;
+		}
+	}
+	return 1.0;
+}
+
+float strus::vectorEncodedDotProduct( const float* vec, const void* elements, std::size_t vecsize, VectorEncoding encoding)
+{
+	switch (encoding)
+	{
+		case VectorEncodingFloat32: return strus::dotProduct( vec, (const float*)elements, vecsize);
+		case VectorEncodingFloat16: return strus::dotProductFloat16( vec, (const uint16_t*)elements, vecsize);
+		case VectorEncodingBFloat16: return strus::dotProductBFloat16( vec, (const uint16_t*)elements, vecsize);
+		case VectorEncodingInt8: return strus::dotProductInt8( vec, (const int8_t*)elements, vecsize);
+	}
+	return 0.0;
+}
+
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Encoding of the vectors stored
+#ifndef _STRUS_VECTOR_ENCODING_HPP_INCLUDED
+#define _STRUS_VECTOR_ENCODING_HPP_INCLUDED
+#include "strus/storage/wordVector.hpp"
+#include "strus/base/stdint.h"
+#include <string>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Encoding of the elements of vectors stored, defined on storage creation
+enum VectorEncoding
+{
+	VectorEncodingFloat32,		///< 32 bit float (default)
+	VectorEncodingFloat16,		///< 16 bit IEEE half precision float
+	VectorEncodingBFloat16,		///< 16 bit brain float (upper half of a 32 bit float)
+	VectorEncodingInt8		///< 8 bit integer with a 32 bit float scale per vector
+};
+
+/// \brief Get the name of a vector encoding as used in the configuration
+const char* vectorEncodingName( VectorEncoding encoding);
+/// \brief Get the vector encoding from its name as used in the configuration
+/// \note throws if the name is not known
+VectorEncoding vectorEncodingFromName( const std::string& name);
+
+/// \brief Get the size of one element of a vector in a given encoding in bytes (without a scale factor)
+std::size_t vectorEncodingElementSize( VectorEncoding encoding);
+
+/// \brief Serialize a vector in a given encoding (elements in network byte order)
+std::string vectorEncodedSerialization( const WordVector& vec, VectorEncoding encoding);
+/// \brief Deserialize a vector from a given encoding
+WordVector vectorFromEncodedSerialization( const char* blob, std::size_t blobsize, VectorEncoding encoding);
+/// \brief Deserialize a vector from a given encoding into an existing vector, reusing its memory
+void vectorFromEncodedSerialization( WordVector& res, const char* blob, std::size_t blobsize, VectorEncoding encoding);
+
+/// \brief Encode a vector as array of elements in host byte order for in memory storage
+/// \param[out] dest where to write the elements to (vec.size() elements of the size given by the encoding)
+/// \param[in] vec vector to encode
+/// \param[in] encoding encoding of the elements
+/// \return the scale factor to multiply the elements with (1.0 if the encoding does not use a scale factor)
+float vectorEncodeElements( void* dest, const float* vec, std::size_t vecsize, VectorEncoding encoding);
+
+/// \brief Dot product of a float array with an array of elements in host byte order encoded with vectorEncodeElements
+float vectorEncodedDotProduct( const float* vec, const void* elements, std::size_t vecsize, VectorEncoding encoding);
+
+}//namespace
+#endif
+
@@ -0,0 +1,196 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Kernels for vector arithmetics on raw arrays used for reranking search results
+#ifndef _STRUS_VECTOR_KERNELS_HPP_INCLUDED
+#define _STRUS_VECTOR_KERNELS_HPP_INCLUDED
+#include "strus/base/stdint.h"
+#include <cstddef>
+#include <cstring>
+
+namespace strus {
+
+/// \brief Dot product of two float arrays
+/// \note Written with independent partial sums without dependencies between the iterations, so that the compiler can vectorize the loop
+static inline float dotProduct( const float* v1, const float* v2, std::size_t size)
+{
+	float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0, s5 = 0.0, s6 = 0.0, s7 = 0.0;
+	std::size_t vi = 0, ve = size & ~(std::size_t)7;
+	for (; vi != ve; vi += 8)
+	{
+		s0 += v1[ vi+0] * v2[ vi+0];
+		s1 += v1[ vi+1] * v2[ vi+1];
+		s2 += v1[ vi+2] * v2[ vi+2];
+		s3 += v1[ vi+3] * v2[ vi+3];
+		s4 += v1[ vi+4] * v2[ vi+4];
+		s5 += v1[ vi+5] * v2[ vi+5];
+		s6 += v1[ vi+6] * v2[ vi+6];
+		s7 += v1[ vi+7] * v2[ vi+7];
+	}
+	for (; vi != size; ++vi)
+	{
+		s0 += v1[ vi] * v2[ vi];
+	}
+	return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+}
+
+/// \brief Convert a 16 bit IEEE half precision float to a float
+/// \note Branch free for normalized numbers, algorithm by Fabian Giesen
+static inline float float16ToFloat( uint16_t val)
+{
+	static const uint32_t shifted_exp = 0x7c00 << 13;
+	static const uint32_t magic_u = 113 << 23;
+	float magic;
+	std::memcpy( &magic, &magic_u, sizeof(magic));
+
+	uint32_t ou = (uint32_t)(val & 0x7fff) << 13;	//... exponent and mantissa bits
+	uint32_t exp = shifted_exp & ou;
+	ou += (127 - 15) << 23;				//... exponent adjust
+	if (exp == shifted_exp)
+	{
+		ou += (128 - 16) << 23;			//... Inf or NaN
+	}
+	else if (exp == 0)
+	{
+		//... zero or denormalized
+		ou += 1 << 23;
+		float of;
+		std::memcpy( &of, &ou, sizeof(of));
+		of -= magic;
+		std::memcpy( &ou, &of, sizeof(ou));
+	}
+	ou |= (uint32_t)(val & 0x8000) << 16;		//... sign bit
+	float rt;
+	std::memcpy( &rt, &ou, sizeof(rt));
+	return rt;
+}
+
+/// \brief Convert a float to a 16 bit IEEE half precision float, rounding to nearest even
+/// \note Algorithm by Fabian Giesen
+static inline uint16_t floatToFloat16( float val)
+{
+	static const uint32_t f32infty = 255 << 23;
+	static const uint32_t f16max = (127 + 16) << 23;
+	static const uint32_t denorm_magic_u = ((127 - 15) + (23 - 10) + 1) << 23;
+
+	uint32_t fu;
+	std::memcpy( &fu, &val, sizeof(fu));
+	uint32_t sign = fu & 0x80000000U;
+	fu ^= sign;
+
+	uint16_t rt;
+	if (fu >= f16max)
+	{
+		rt = (fu > f32infty) ? 0x7e00 : 0x7c00;	//... NaN or Inf
+	}
+	else if (fu < (113 << 23))
+	{
+		//... subnormal or zero, align the mantissa bits with a magic addition rounding to nearest even
+		float ff, denorm_magic;
+		std::memcpy( &ff, &fu, sizeof(ff));
+		std::memcpy( &denorm_magic, &denorm_magic_u, sizeof(denorm_magic));
+		ff += denorm_magic;
+		std::memcpy( &fu, &ff, sizeof(fu));
+		rt = (uint16_t)(fu - denorm_magic_u);
+	}
+	else
+	{
+		uint32_t mant_odd = (fu >> 13) & 1;
+		fu += ((uint32_t)(15 - 127) << 23) + 0xfff;
+		fu += mant_odd;
+		rt = (uint16_t)(fu >> 13);
+	}
+	return rt | (uint16_t)(sign >> 16);
+}
+
+/// \brief Convert a 16 bit brain float (upper half of a float) to a float
+static inline float bfloat16ToFloat( uint16_t val)
+{
+	uint32_t ou = (uint32_t)val << 16;
+	float rt;
+	std::memcpy( &rt, &ou, sizeof(rt));
+	return rt;
+}
+
+/// \brief Convert a float to a 16 bit brain float (upper half of a float), rounding to nearest even
+static inline uint16_t floatToBFloat16( float val)
+{
+	uint32_t fu;
+	std::memcpy( &fu, &val, sizeof(fu));
+	if ((fu & 0x7fffffffU) > 0x7f800000U) return 0x7fc0;	//... NaN
+	fu += 0x7fff + ((fu >> 16) & 1);
+	return (uint16_t)(fu >> 16);
+}
+
+/// \brief Dot product of a float array with an array of 16 bit IEEE half precision floats
+static inline float dotProductFloat16( const float* v1, const uint16_t* v2, std::size_t size)
+{
+	float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+	std::size_t vi = 0, ve = size & ~(std::size_t)3;
+	for (; vi != ve; vi += 4)
+	{
+		s0 += v1[ vi+0] * float16ToFloat( v2[ vi+0]);
+		s1 += v1[ vi+1] * float16ToFloat( v2[ vi+1]);
+		s2 += v1[ vi+2] * float16ToFloat( v2[ vi+2]);
+		s3 += v1[ vi+3] * float16ToFloat( v2[ vi+3]);
+	}
+	for (; vi != size; ++vi)
+	{
+		s0 += v1[ vi] * float16ToFloat( v2[ vi]);
+	}
+	return (s0 + s1) + (s2 + s3);
+}
+
+/// \brief Dot product of a float array with an array of 16 bit brain floats
+static inline float dotProductBFloat16( const float* v1, const uint16_t* v2, std::size_t size)
+{
+	float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0, s5 = 0.0, s6 = 0.0, s7 = 0.0;
+	std::size_t vi = 0, ve = size & ~(std::size_t)7;
+	for (; vi != ve; vi += 8)
+	{
+		s0 += v1[ vi+0] * bfloat16ToFloat( v2[ vi+0]);
+		s1 += v1[ vi+1] * bfloat16ToFloat( v2[ vi+1]);
+		s2 += v1[ vi+2] * bfloat16ToFloat( v2[ vi+2]);
+		s3 += v1[ vi+3] * bfloat16ToFloat( v2[ vi+3]);
+		s4 += v1[ vi+4] * bfloat16ToFloat( v2[ vi+4]);
+		s5 += v1[ vi+5] * bfloat16ToFloat( v2[ vi+5]);
+		s6 += v1[ vi+6] * bfloat16ToFloat( v2[ vi+6]);
+		s7 += v1[ vi+7] * bfloat16ToFloat( v2[ vi+7]);
+	}
+	for (; vi != size; ++vi)
+	{
+		s0 += v1[ vi] * bfloat16ToFloat( v2[ vi]);
+	}
+	return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+}
+
+/// \brief Dot product of a float array with an array of 8 bit integers (to multiply with the scale of the integer array)
+static inline float dotProductInt8( const float* v1, const int8_t* v2, std::size_t size)
+{
+	float s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0, s4 = 0.0, s5 = 0.0, s6 = 0.0, s7 = 0.0;
+	std::size_t vi = 0, ve = size & ~(std::size_t)7;
+	for (; vi != ve; vi += 8)
+	{
+		s0 += v1[ vi+0] * (float)v2[ vi+0];
+		s1 += v1[ vi+1] * (float)v2[ vi+1];
+		s2 += v1[ vi+2] * (float)v2[ vi+2];
+		s3 += v1[ vi+3] * (float)v2[ vi+3];
+		s4 += v1[ vi+4] * (float)v2[ vi+4];
+		s5 += v1[ vi+5] * (float)v2[ vi+5];
+		s6 += v1[ vi+6] * (float)v2[ vi+6];
+		s7 += v1[ vi+7] * (float)v2[ vi+7];
+	}
+	for (; vi != size; ++vi)
+	{
+		s0 += v1[ vi] * (float)v2[ vi];
+	}
+	return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+}
+
+}//namespace
+#endif
+
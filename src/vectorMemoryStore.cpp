@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief In memory store of the normalized vectors of a type for reranking search results
+#include "vectorMemoryStore.hpp"
+#include "armautils.hpp"
+#include "internationalization.hpp"
+#include "strus/base/malloc.hpp"
+#include "strus/base/platform.hpp"
+#include <algorithm>
+#include <cstring>
+#include <new>
+
+using namespace strus;
+
+VectorMemoryStore::VectorMemoryStore( const DatabaseAdapter* database_, const Index& typeno_, int vecdim_)
+	:m_vecdim(vecdim_),m_vecenc(database_->vectorEncoding()),m_rowsize(0),m_ar(0),m_arsize(0),m_featnoar(),m_scalear()
+{
+	enum {RowAlign = strus::platform::CacheLineSize};
+	std::size_t rowdatasize = m_vecdim * vectorEncodingElementSize( m_vecenc);
+	m_rowsize = ((rowdatasize + RowAlign - 1) / RowAlign) * RowAlign;
+
+	int nofVectors = database_->readNofVectors( typeno_);
+	reserve( nofVectors > 0 ? nofVectors : 1);
+
+	Index featno;
+	WordVector vec;
+	DatabaseAdapter::VectorCursor cursor( database_, database_->vectorEncoding(), typeno_);
+	bool more = cursor.loadFirst( featno, vec);
+	for (; more; more = cursor.loadNext( featno, vec))
+	{
+		append( featno, vec);
+	}
+}
+
+VectorMemoryStore::~VectorMemoryStore()
+{
+	if (m_ar) strus::aligned_free( m_ar);
+}
+
+void VectorMemoryStore::reserve( std::size_t nofRows)
+{
+	if (nofRows <= m_arsize) return;
+	char* newar = (char*)strus::aligned_malloc( nofRows * m_rowsize, strus::platform::CacheLineSize);
+	if (!newar) throw std::bad_alloc();
+	if (m_ar)
+	{
+		std::memcpy( newar, m_ar, m_featnoar.size() * m_rowsize);
+		strus::aligned_free( m_ar);
+	}
+	m_ar = newar;
+	m_arsize = nofRows;
+}
+
+void VectorMemoryStore::append( const Index& featno, const WordVector& vec)
+{
+	if ((int)vec.size() != m_vecdim)
+	{
+		throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), m_vecdim, (int)vec.size());
+	}
+	if (!m_featnoar.empty() && m_featnoar.back() >= featno)
+	{
+		throw strus::runtime_error( _TXT("vectors not loaded in ascending order of feature numbers"));
+	}
+	if (m_featnoar.size() >= m_arsize)
+	{
+		reserve( m_arsize * 2);
+	}
+	char* row = m_ar + m_featnoar.size() * m_rowsize;
+	std::memset( row, 0, m_rowsize);
+	arma::fvec normvec = strus::normalizeVector( vec);
+	float scale = vectorEncodeElements( row, normvec.memptr(), m_vecdim, m_vecenc);
+	if (m_vecenc == VectorEncodingInt8)
+	{
+		m_scalear.push_back( scale);
+	}
+	m_featnoar.push_back( featno);
+}
+
+bool VectorMemoryStore::similarity( const Index& featno, const float* normvec, double& res) const
+{
+	std::vector<Index>::const_iterator fi = std::lower_bound( m_featnoar.begin(), m_featnoar.end(), featno);
+	if (fi == m_featnoar.end() || *fi != featno) return false;
+	std::size_t rowidx = fi - m_featnoar.begin();
+	res = vectorEncodedDotProduct( normvec, m_ar + rowidx * m_rowsize, m_vecdim, m_vecenc);
+	if (!m_scalear.empty())
+	{
+		res *= m_scalear[ rowidx];
+	}
+	return true;
+}
+
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief In memory store of the normalized vectors of a type for reranking search results
+#ifndef _STRUS_VECTOR_MEMORY_STORE_HPP_INCLUDED
+#define _STRUS_VECTOR_MEMORY_STORE_HPP_INCLUDED
+#include "strus/storage/index.hpp"
+#include "databaseAdapter.hpp"
+#include "vectorEncoding.hpp"
+#include <vector>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief In memory store of the normalized vectors of a type for reranking search results
+/// \note The vectors are stored in the encoding of the storage as rows of a contiguous array, each row aligned to the cache line size
+class VectorMemoryStore
+{
+public:
+	VectorMemoryStore( const DatabaseAdapter* database_, const Index& typeno_, int vecdim_);
+	~VectorMemoryStore();
+
+	/// \brief Get the similarity (cosine) of a normalized vector to the vector of a feature
+	/// \param[in] featno feature number of the vector to compare with
+	/// \param[in] normvec normalized vector with the dimension of the vectors stored
+	/// \param[out] res the similarity calculated
+	/// \return true if the vector of the feature was found, false else
+	bool similarity( const Index& featno, const float* normvec, double& res) const;
+
+	/// \brief Get the dimension of the vectors
+	int vecdim() const
+	{
+		return m_vecdim;
+	}
+	/// \brief Get the number of vectors
+	std::size_t size() const
+	{
+		return m_featnoar.size();
+	}
+
+private:
+	VectorMemoryStore( const VectorMemoryStore&){}	//... non copyable
+	void operator=( const VectorMemoryStore&){}	//... non copyable
+
+	void append( const Index& featno, const WordVector& vec);
+	void reserve( std::size_t nofRows);
+
+private:
+	int m_vecdim;
+	VectorEncoding m_vecenc;		///< encoding of the elements of a row
+	std::size_t m_rowsize;			///< size of a row in bytes including the padding for the alignment
+	char* m_ar;				///< rows of normalized vectors
+	std::size_t m_arsize;			///< number of rows allocated
+	std::vector<Index> m_featnoar;		///< feature numbers of the rows in ascending order
+	std::vector<float> m_scalear;		///< scale factors of the rows for encodings with a scale, empty else
+};
+
+}//namespace
+#endif
+
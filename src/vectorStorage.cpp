@@ -55,8 +55,21 @@ bool VectorStorage::createStorage( const std::string& configsource, const Databa
 		std::string configstring( configsource);
 		Config config;
 		unsigned int value;
+		std::string stringvalue;
 
 		(void)strus::removeKeyFromConfigString( configstring, "memtypes", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "memvectypes", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "pqtypes", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "pqsub", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "topk", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "threads", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "searchthreads", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "txmem", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "namecache", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "compactmb", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "compactint", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "resultcache", m_errorhnd); //.. vector storage client
+		(void)strus::removeKeyFromConfigString( configstring, "frozen", m_errorhnd); //.. vector storage client
 		(void)strus::removeKeyFromConfigString( configstring, "lextypes", m_errorhnd); //... sentence lexer
 		(void)strus::removeKeyFromConfigString( configstring, "coversim", m_errorhnd); //... sentence lexer
 		(void)strus::removeKeyFromConfigString( configstring, "recall", m_errorhnd); //... sentence lexer
@@ -78,6 +91,25 @@ bool VectorStorage::createStorage( const std::string& configsource, const Databa
 			if (m_debugtrace) m_debugtrace->event( "param", "variations %d", value);
 			config.variations = value;
 		}
+		if (strus::extractStringFromConfigString( stringvalue, configstring, "vecenc", m_errorhnd))
+		{
+			if (m_debugtrace) m_debugtrace->event( "param", "vecenc %s", stringvalue.c_str());
+			config.vecenc = vectorEncodingFromName( stringvalue);
+		}
+		if (strus::extractStringFromConfigString( stringvalue, configstring, "lshlayout", m_errorhnd))
+		{
+			if (m_debugtrace) m_debugtrace->event( "param", "lshlayout %s", stringvalue.c_str());
+			config.lshlayout = simHashLayoutFromName( stringvalue);
+		}
+		if (strus::extractUIntFromConfigString( value, configstring, "sampleint", m_errorhnd))
+		{
+			if (m_debugtrace) m_debugtrace->event( "param", "sampleint %d", value);
+			if (value == 0 || value > (unsigned int)std::numeric_limits<int>::max())
+			{
+				throw strus::runtime_error(_TXT("configuration parameter '%s' out of range"), "sampleint");
+			}
+			config.sampleint = value;
+		}
 		if (m_debugtrace) m_debugtrace->close();
 		if (m_errorhnd->hasError())
 		{
@@ -91,6 +123,9 @@ bool VectorStorage::createStorage( const std::string& configsource, const Databa
 			transaction->writeVersion();
 			transaction->writeVariable( "config", configsource);
 			transaction->writeLshModel( lshmodel);
+			transaction->writeVariable( "vecenc", vectorEncodingName( config.vecenc));
+			transaction->writeVariable( "lshlayout", simHashLayoutName( config.lshlayout));
+			transaction->writeVariable( "sampleint", strus::string_format( "%d", config.sampleint));
 
 			strus::Index typeno = database.readNofTypeno();
 			SentenceLexerConfig lexerConfig( configsource);
@@ -133,6 +168,18 @@ static std::string extractConfigParamsOpenStorage( const std::string& configsour
 	{
 		if (debugtrace) debugtrace->event( "warning", "param '%s' only allowed on storage creation and has no effect", "variations");
 	}
+	if (strus::extractStringFromConfigString( value, configstring, "vecenc", errorhnd))
+	{
+		if (debugtrace) debugtrace->event( "warning", "param '%s' only allowed on storage creation and has no effect", "vecenc");
+	}
+	if (strus::extractStringFromConfigString( value, configstring, "lshlayout", errorhnd))
+	{
+		if (debugtrace) debugtrace->event( "warning", "param '%s' only allowed on storage creation and has no effect", "lshlayout");
+	}
+	if (strus::extractStringFromConfigString( value, configstring, "sampleint", errorhnd))
+	{
+		if (debugtrace) debugtrace->event( "warning", "param '%s' only allowed on storage creation and has no effect", "sampleint");
+	}
 	if (debugtrace) debugtrace->close();
 	if (errorhnd->hasError())
 	{
@@ -167,18 +214,18 @@ const char* VectorStorage::getConfigDescription( const ConfigType& type) const
 	switch (type)
 	{
 		case CmdCreateClient:
-			return "lexprun=<parameter for the creation of a lexer, number of candidates with same position not better than the best candidate followed (default 3)>\nmemtypes=<comma separated list of type names where the LSH values should be loaded entirely into memory for speeding up retrieval>";
+			return "lexprun=<parameter for the creation of a lexer, number of candidates with same position not better than the best candidate followed (default 3)>\nmemtypes=<comma separated list of type names where the LSH values should be loaded entirely into memory for speeding up retrieval>\nmemvectypes=<comma separated list of type names where the normalized vectors should be loaded entirely into memory for speeding up the reranking with real vector weights>\npqtypes=<comma separated list of type names where product quantization codes of the vectors are kept in memory for reranking results with approximated vector weights without database reads>\npqsub=<number of subspaces of product quantization, bytes per vector (default vector dimension divided by 4)>\ntopk=<method for selecting the best results of a search, one of list (array with insertion, default),heap (bounded heap),bucket (buckets indexed by the LSH distance)>\nthreads=<number of threads used for calculating the LSH values of the vectors in a transaction commit (default 0, no threads)>\nsearchthreads=<number of threads of the pool started with the client for searching the types of a search over multiple types in parallel with the calling thread (default 0, the types are searched in the calling thread)>\ntxmem=<memory budget in megabytes of a transaction, when exceeded the vectors defined are written as partial batch to the database transaction (default 0, no limit). The budget bounds the vectors and names defined, the bookkeeping of the features written (numbers, relations and allocated names) still grows with the size of the transaction>\nnamecache=<maximum number of entries of the cache for the resolution of type and feature names and numbers (default 100000, 0 for no cache)>\ncompactmb=<number of megabytes committed triggering a compaction of the database in the background (default 0, compaction only on explicit request)>\ncompactint=<minimum number of seconds between two compactions in the background (default 600)>\nresultcache=<maximum number of entries of the cache for the results of searches, invalidated per type on commit (default 0, no cache)>\nfrozen=<path of a frozen storage file (written with strusVectorDump -Z) the storage is served from read only without accessing the database. The file is mapped into memory and shared between processes, the LSH values and vectors loaded for searching are still copied into the memory of each process>";
 
 		case CmdCreate:
-			return "vecdim=<dimension of vectors>\nbits=<number of bits calculated by separating hyperplanes (optional)>\nvariations=<number of random images used (optional - bits*variations = number of bits in LSH values>";
+			return "vecdim=<dimension of vectors>\nbits=<number of bits calculated by separating hyperplanes (optional)>\nvariations=<number of random images used (optional - bits*variations = number of bits in LSH values>\nvecenc=<encoding of the vectors stored, one of fp32,fp16,bf16,int8 (optional, default fp32)>\nlshlayout=<layout of the LSH values stored, key (one key per value) or block (values packed in blocks for fast sequential loading) (optional, default key)>\nsampleint=<distance in ordinals of the position markers for the access of the features of a type by their ordinal (optional, default 65536)>";
 	}
 	return 0;
 }
 
 const char** VectorStorage::getConfigParameters( const ConfigType& type) const
 {
-	static const char* keys_CreateStorageClient[]	= {"memtypes", "lexprun", 0};
-	static const char* keys_CreateStorage[]		= {"vecdim", "bits", "variations", 0};
+	static const char* keys_CreateStorageClient[]	= {"memtypes", "memvectypes", "pqtypes", "pqsub", "topk", "threads", "searchthreads", "txmem", "namecache", "compactmb", "compactint", "resultcache", "frozen", "lexprun", 0};
+	static const char* keys_CreateStorage[]		= {"vecdim", "bits", "variations", "vecenc", "lshlayout", "sampleint", 0};
 	switch (type)
 	{
 		case CmdCreateClient:	return keys_CreateStorageClient;
@@ -10,6 +10,8 @@
 #define _STRUS_VECTOR_STORAGE_IMPLEMENTATION_HPP_INCLUDED
 #include "strus/vectorStorageInterface.hpp"
 #include "strus/debugTraceInterface.hpp"
+#include "vectorEncoding.hpp"
+#include "databaseAdapter.hpp"
 #include <string>
 
 namespace strus {
@@ -43,15 +45,21 @@ public:
 		int vecdim;
 		int bits;
 		int variations;
+		VectorEncoding vecenc;
+		SimHashLayout lshlayout;
+		int sampleint;
 
 		Config( const Config& o)
-			:vecdim(o.vecdim),bits(o.bits),variations(o.variations){}
+			:vecdim(o.vecdim),bits(o.bits),variations(o.variations),vecenc(o.vecenc),lshlayout(o.lshlayout),sampleint(o.sampleint){}
 		Config()
-			:vecdim(DefaultDim),bits(DefaultBits),variations(DefaultVariations){}
+			:vecdim(DefaultDim),bits(DefaultBits),variations(DefaultVariations),vecenc(VectorEncodingFloat32),lshlayout(SimHashLayoutKey),sampleint(DatabaseAdapter::FeatnoSampleInterval){}
 		explicit Config( int vecdim_)
 			:vecdim(vecdim_)
 			,bits(bitsFromVecdim(vecdim_))
 			,variations(variationsFromVecdim(vecdim_))
+			,vecenc(VectorEncodingFloat32)
+			,lshlayout(SimHashLayoutKey)
+			,sampleint(DatabaseAdapter::FeatnoSampleInterval)
 		{
 			while (vecdim/2 < bits && bits > 1)
 			{
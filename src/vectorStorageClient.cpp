@@ -17,6 +17,8 @@
 #include "strus/base/string_conv.hpp"
 #include "simHashReader.hpp"
 #include "simHashRankList.hpp"
+#include "vectorMemoryStore.hpp"
+#include "productQuantizer.hpp"
 #include "sentenceLexerInstance.hpp"
 #include "armautils.hpp"
 #include "errorUtils.hpp"
@@ -31,8 +33,9 @@
 using namespace strus;
 
 VectorStorageClient::VectorStorageClient( const DatabaseInterface* database_, const std::string& configstring_, ErrorBufferInterface* errorhnd_)
-	:m_errorhnd(errorhnd_),m_debugtrace(0),m_database(),m_model(),m_simHashMapMap()
-	,m_inMemoryTypes(),m_lexerConfig(),m_transaction_mutex()
+	:m_errorhnd(errorhnd_),m_debugtrace(0),m_database(),m_model(),m_simHashMapMap(),m_simHashMapBuilds(),m_simHashMap_mutex(),m_simHashMap_cond(),m_nofSimHashMapsCreated(0),m_queryResultCache(),m_searchWorkerPool()
+	,m_inMemoryTypes(),m_inMemoryVectorTypes(),m_productQuantizedTypes(),m_nofProductQuantizerSubspaces(0),m_topKMethod(TopKSelectRankList),m_nofThreads(0),m_transactionMemoryBudget(0),m_lexerConfig(),m_transaction_mutex()
+	,m_allocation_mutex(),m_nofTypenoAllocated(0),m_nofFeatnoAllocated(0),m_allocatedTypenoMap(),m_allocatedFeatnoMap()
 {
 	DebugTraceInterface* dbgi = m_errorhnd->debugTrace();
 	if (dbgi) m_debugtrace = dbgi->createTraceContext( STRUS_DBGTRACE_COMPONENT_NAME);
@@ -54,7 +57,99 @@ VectorStorageClient::VectorStorageClient( const DatabaseInterface* database_, co
 			for (; mi != me; ++mi) m_debugtrace->event( "param", "in memory lsh for feature %s", mi->c_str());
 		}
 	}
-	m_database.reset( new DatabaseAdapter( database_,configstring,m_errorhnd));
+	if (strus::extractStringArrayFromConfigString( m_inMemoryVectorTypes, configstring, "memvectypes", ',', m_errorhnd))
+	{
+		if (m_debugtrace)
+		{
+			std::vector<std::string>::const_iterator mi = m_inMemoryVectorTypes.begin(), me = m_inMemoryVectorTypes.end();
+			for (; mi != me; ++mi) m_debugtrace->event( "param", "in memory vectors for feature %s", mi->c_str());
+		}
+	}
+	if (strus::extractStringArrayFromConfigString( m_productQuantizedTypes, configstring, "pqtypes", ',', m_errorhnd))
+	{
+		if (m_debugtrace)
+		{
+			std::vector<std::string>::const_iterator mi = m_productQuantizedTypes.begin(), me = m_productQuantizedTypes.end();
+			for (; mi != me; ++mi) m_debugtrace->event( "param", "product quantized vectors for feature %s", mi->c_str());
+		}
+	}
+	unsigned int nofSubspaces = 0;
+	if (strus::extractUIntFromConfigString( nofSubspaces, configstring, "pqsub", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "product quantization subspaces %u", nofSubspaces);
+		m_nofProductQuantizerSubspaces = nofSubspaces;
+	}
+	unsigned int nofThreads = 0;
+	if (strus::extractUIntFromConfigString( nofThreads, configstring, "threads", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "threads %u", nofThreads);
+		m_nofThreads = nofThreads;
+	}
+	unsigned int nofSearchThreads = 0;
+	if (strus::extractUIntFromConfigString( nofSearchThreads, configstring, "searchthreads", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "search threads %u", nofSearchThreads);
+	}
+	unsigned int transactionMemoryMB = 0;
+	if (strus::extractUIntFromConfigString( transactionMemoryMB, configstring, "txmem", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "transaction memory budget %u MB", transactionMemoryMB);
+		m_transactionMemoryBudget = (std::size_t)transactionMemoryMB << 20;
+	}
+	unsigned int nameCacheSize = DefaultNameCacheSize;
+	if (strus::extractUIntFromConfigString( nameCacheSize, configstring, "namecache", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "name cache size %u", nameCacheSize);
+	}
+	unsigned int compactionMB = 0;
+	if (strus::extractUIntFromConfigString( compactionMB, configstring, "compactmb", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "compaction after %u MB committed", compactionMB);
+	}
+	unsigned int compactionInterval = DefaultCompactionMinInterval;
+	if (strus::extractUIntFromConfigString( compactionInterval, configstring, "compactint", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "minimum interval between compactions %u seconds", compactionInterval);
+	}
+	unsigned int resultCacheSize = 0;
+	if (strus::extractUIntFromConfigString( resultCacheSize, configstring, "resultcache", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "search result cache size %u", resultCacheSize);
+	}
+	std::string frozenPath;
+	if (strus::extractStringFromConfigString( frozenPath, configstring, "frozen", m_errorhnd))
+	{
+		if (m_debugtrace) m_debugtrace->event( "param", "frozen storage file %s", frozenPath.c_str());
+	}
+	if (strus::extractStringFromConfigString( stringvalue, configstring, "topk", m_errorhnd))
+	{
+		if (!strus::topKSelectMethodFromName( m_topKMethod, stringvalue))
+		{
+			throw strus::runtime_error(_TXT("unknown top-k selection method '%s' (expected one of 'list','heap','bucket')"), stringvalue.c_str());
+		}
+		if (m_debugtrace) m_debugtrace->event( "param", "top-k selection method %s", strus::topKSelectMethodName( m_topKMethod));
+	}
+	if (m_errorhnd->hasError())
+	{
+		throw strus::runtime_error(_TXT("error reading vector storage client configuration: %s"), m_errorhnd->fetchError());
+	}
+	if (frozenPath.empty())
+	{
+		m_database.reset( new DatabaseAdapter( database_,configstring,m_errorhnd,nameCacheSize,(std::size_t)compactionMB << 20,compactionInterval));
+	}
+	else
+	{
+		// ... the storage is served read only from the frozen storage file, the database is not accessed
+		m_database.reset( new DatabaseAdapter( Reference<FrozenStorage>( new FrozenStorage( frozenPath)),m_errorhnd,nameCacheSize));
+	}
+	if (resultCacheSize)
+	{
+		m_queryResultCache.reset( new QueryResultCache( resultCacheSize));
+	}
+	if (nofSearchThreads)
+	{
+		m_searchWorkerPool.reset( new SearchWorkerPool( nofSearchThreads, m_errorhnd));
+	}
 	m_database->checkVersion();
 	m_model = m_database->readLshModel();
 
@@ -90,112 +185,629 @@ void VectorStorageClient::prepareSearch( const std::string& type) const
 std::vector<VectorQueryResult> VectorStorageClient::simHashToVectorQueryResults( const std::vector<SimHashQueryResult>& res, int maxNofResults, double minSimilarity) const
 {
 	std::vector<VectorQueryResult> rt;
+	std::vector<Index> featnolist;
 	std::vector<SimHashQueryResult>::const_iterator ri = res.begin(), re = res.end();
-	for (int ridx=0; ri != re && ridx < maxNofResults && ri->weight() > minSimilarity; ++ri,++ridx)
+	for (int ridx=0; ri != re && ridx < maxNofResults && ri->weight() >= minSimilarity; ++ri,++ridx)
 	{
-		rt.push_back( VectorQueryResult( m_database->readFeatName( ri->featno()), ri->weight()));
+		featnolist.push_back( ri->featno());
+	}
+	std::vector<std::string> names = m_database->readFeatNames( featnolist);
+	rt.reserve( names.size());
+	std::vector<std::string>::const_iterator ni = names.begin(), ne = names.end();
+	for (ri = res.begin(); ni != ne; ++ni,++ri)
+	{
+		rt.push_back( VectorQueryResult( *ni, ri->weight()));
 	}
 	return rt;
 }
 
-std::vector<VectorQueryResult> VectorStorageClient::findSimilar( const std::string& type, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+void VectorStorageClient::rerankWithRealWeights( std::vector<SimHashQueryResult>& res, const SimHashMap& simHashMap, const WordVector& vec, RerankBuffer& buf) const
 {
-	try
+	const VectorMemoryStore* vectorStore = simHashMap.vectorStore();
+	if (vectorStore)
 	{
-		std::vector<SimHashQueryResult> res;
-		strus::Reference<SimHashMap> simHashMap = getOrCreateTypeSimHashMap( type);
-		SimHashMap::Stats stats;
-
-		int simdist = SimHashRankList::lshSimDistFromWeight( m_model.vectorBits(), minSimilarity);
-		if (simdist > m_model.vectorBits()) simdist = m_model.vectorBits();
-		int probsimdist = (1.0 + speedRecallFactor) * simdist;
-		if (probsimdist > m_model.vectorBits()) probsimdist = m_model.vectorBits();
-
-		if (realVecWeights)
+		// ... rerank with the normalized vectors kept in memory
+		arma::fvec normvec = strus::normalizeVector( vec);
+		if ((int)normvec.size() != vectorStore->vecdim())
+		{
+			throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), vectorStore->vecdim(), (int)normvec.size());
+		}
+		std::vector<SimHashQueryResult>::iterator ri = res.begin(), re = res.end();
+		for (; ri != re; ++ri)
 		{
-			if (minSimilarity < 0.0 || minSimilarity > 1.0)
+			double weight;
+			if (!vectorStore->similarity( ri->featno(), normvec.memptr(), weight))
 			{
-				throw std::runtime_error( _TXT( "min similarity parameter out of range"));
+				throw strus::runtime_error( _TXT("inconsistency in vector storage: vector of feature %d not found"), (int)ri->featno());
 			}
-			int maxNofSimResults = maxNofResults * 2 + 10;
-			if (maxNofSimResults > SimHashRankList::MaxSize)
+			ri->setWeight( weight);
+		}
+	}
+	else
+	{
+		// ... read the vectors of the results with one sweep in ascending order of the feature numbers into the buffers of the caller
+		arma::fvec vv = arma::fvec( vec);
+		std::vector<SimHashQueryResult>::iterator ri = res.begin(), re = res.end();
+		buf.featnolist.clear();
+		for (; ri != re; ++ri)
+		{
+			buf.featnolist.push_back( ri->featno());
+		}
+		std::sort( buf.featnolist.begin(), buf.featnolist.end());
+		m_database->readVectors( buf.vecar, simHashMap.typeno(), buf.featnolist);
+		for (ri = res.begin(); ri != re; ++ri)
+		{
+			std::size_t vidx = std::lower_bound( buf.featnolist.begin(), buf.featnolist.end(), ri->featno()) - buf.featnolist.begin();
+			WordVector& resvec = buf.vecar[ vidx];
+			if (resvec.empty())
 			{
-				if (maxNofResults > SimHashRankList::MaxSize)
-				{
-					throw strus::runtime_error( "%s",  _TXT( "maximum number of ranks is out of range"));
-				}
-				maxNofSimResults = SimHashRankList::MaxSize;
+				throw strus::runtime_error( _TXT("inconsistency in vector storage: vector of feature %d not found"), (int)ri->featno());
 			}
-			res.reserve( maxNofSimResults);
-
-			arma::fvec vv = arma::fvec( vec);
-			SimHash needle( m_model.simHash( strus::normalizeVector( vec), 0));
-			if (m_debugtrace)
+			if (resvec.size() != vv.size())
 			{
-				res = simHashMap->findSimilarWithStats( stats, needle, simdist, probsimdist, maxNofSimResults);
+				throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), (int)resvec.size(), (int)vv.size());
 			}
-			else
+			// ... the vector read is used by armadillo without copying it
+			arma::fvec resvv( &resvec[0], resvec.size(), false/*copy_aux_mem*/, true/*strict*/);
+			ri->setWeight( arma::norm_dot( vv, resvv));
+		}
+	}
+}
+
+void VectorStorageClient::rerankWithProductQuantizer( std::vector<SimHashQueryResult>& res, const ProductQuantizer& productQuantizer, const WordVector& vec) const
+{
+	arma::fvec normvec = strus::normalizeVector( vec);
+	if ((int)normvec.size() != productQuantizer.vecdim())
+	{
+		throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), productQuantizer.vecdim(), (int)normvec.size());
+	}
+	std::vector<float> lut;
+	productQuantizer.createLookupTable( lut, normvec.memptr());
+	std::vector<SimHashQueryResult>::iterator ri = res.begin(), re = res.end();
+	for (; ri != re; ++ri)
+	{
+		double weight;
+		if (!productQuantizer.similarity( ri->featno(), lut, weight))
+		{
+			throw strus::runtime_error( _TXT("inconsistency in vector storage: vector of feature %d not found"), (int)ri->featno());
+		}
+		ri->setWeight( weight);
+	}
+}
+
+void VectorStorageClient::getSearchDistances( int& simdist, int& probsimdist, double minSimilarity, double speedRecallFactor) const
+{
+	simdist = SimHashRankList::lshSimDistFromWeight( m_model.vectorBits(), minSimilarity);
+	if (simdist > m_model.vectorBits()) simdist = m_model.vectorBits();
+	probsimdist = (1.0 + speedRecallFactor) * simdist;
+	if (probsimdist > m_model.vectorBits()) probsimdist = m_model.vectorBits();
+}
+
+std::vector<SimHashQueryResult> VectorStorageClient::searchSimHashMap( const SimHashMap& simHashMap, const SimHash& needle, const WordVector& vec, const SimHashSlotSet* slotFilter, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights, SimHashMap::Stats* stats) const
+{
+	std::vector<SimHashQueryResult> res;
+	int simdist;
+	int probsimdist;
+	getSearchDistances( simdist, probsimdist, minSimilarity, speedRecallFactor);
+
+	const ProductQuantizer* productQuantizer = realVecWeights ? NULL : simHashMap.productQuantizer();
+	if (realVecWeights || productQuantizer)
+	{
+		if (minSimilarity < 0.0 || minSimilarity > 1.0)
+		{
+			throw std::runtime_error( _TXT( "min similarity parameter out of range"));
+		}
+		int maxNofSimResults = maxNofResults * 2 + 10;
+		if (maxNofSimResults > SimHashRankList::MaxSize && maxNofResults <= SimHashRankList::MaxSize)
+		{
+			maxNofSimResults = SimHashRankList::MaxSize;
+		}
+		if (stats)
+		{
+			res = simHashMap.findSimilarWithStats( *stats, needle, simdist, probsimdist, maxNofSimResults, slotFilter);
+		}
+		else
+		{
+			res = simHashMap.findSimilar( needle, simdist, probsimdist, maxNofSimResults, slotFilter);
+		}
+		if (realVecWeights)
+		{
+			RerankBuffer rerankBuffer;
+			rerankWithRealWeights( res, simHashMap, vec, rerankBuffer);
+		}
+		else
+		{
+			rerankWithProductQuantizer( res, *productQuantizer, vec);
+		}
+		std::sort( res.begin(), res.end(), std::greater<SimHashQueryResult>());
+	}
+	else
+	{
+		if (stats)
+		{
+			res = simHashMap.findSimilarWithStats( *stats, needle, simdist, probsimdist, maxNofResults, slotFilter);
+		}
+		else
+		{
+			res = simHashMap.findSimilar( needle, simdist, probsimdist, maxNofResults, slotFilter);
+		}
+	}
+	return res;
+}
+
+std::vector<VectorQueryResult> VectorStorageClient::findSimilarImpl( const std::string& type, const WordVector& vec, const VectorSearchRestriction* restriction, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	SimHash needle( m_model.simHash( strus::normalizeVector( vec), 0));
+	std::string cacheKey;
+	unsigned int cacheTicket = 0;
+	if (m_queryResultCache.get() && !restriction)
+	{
+		std::vector<VectorQueryResult> cachedResults;
+		cacheKey = QueryResultCache::queryKey( type, needle, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+		if (m_queryResultCache->get( cacheKey, cachedResults, cacheTicket))
+		{
+			if (m_debugtrace) m_debugtrace->event( "findsim", "%s cached results %d", type.c_str(), (int)cachedResults.size());
+			return cachedResults;
+		}
+	}
+	strus::Reference<SimHashMap> simHashMap = getOrCreateTypeSimHashMap( type);
+	SimHashMap::Stats stats;
+
+	strus::Reference<SimHashSlotSet> slotFilter;
+	if (restriction)
+	{
+		slotFilter = restriction->slotSet( simHashMap);
+		if (slotFilter->empty()) return std::vector<VectorQueryResult>();
+	}
+	std::vector<SimHashQueryResult> res = searchSimHashMap( *simHashMap, needle, vec, slotFilter.get(), maxNofResults, minSimilarity, speedRecallFactor, realVecWeights, m_debugtrace ? &stats : NULL);
+
+	if (m_debugtrace)
+	{
+		int simdist;
+		int probsimdist;
+		getSearchDistances( simdist, probsimdist, minSimilarity, speedRecallFactor);
+
+		std::string vecstr = vec.tostring(", ", 10);
+		m_debugtrace->event( "findsim", "%s {%s,...}", type.c_str(), vecstr.c_str());
+		m_debugtrace->open( "search");
+		m_debugtrace->event( "param", _TXT("LSH simdist %d"), simdist);
+		m_debugtrace->event( "param", _TXT("LSH prob simdist %d"), probsimdist);
+		m_debugtrace->event( "param", _TXT("feature type %s"), type.c_str());
+		m_debugtrace->event( "param", _TXT("max results %d"), maxNofResults);
+		m_debugtrace->event( "param", _TXT("min similarity %.5f"), minSimilarity);
+		m_debugtrace->event( "param", _TXT("use real weights %s"), realVecWeights ? "yes":"no");
+
+		m_debugtrace->event( "stats", _TXT("benches %d"), stats.nofBenches);
+		m_debugtrace->event( "stats", _TXT("values %d"), stats.nofValues);
+		m_debugtrace->event( "stats", _TXT("database reads %d"), stats.nofDatabaseReads);
+		m_debugtrace->event( "stats", _TXT("partial prob sum %d"), stats.probSum);
+		m_debugtrace->event( "stats", _TXT("best filter samples max dist %d"), stats.samplesMaxDist);
+		m_debugtrace->event( "stats", _TXT("results %d"), stats.nofResults);
+		for (int bi=0; bi<stats.nofBenches; ++bi)
+		{
+			m_debugtrace->event( "stats", "candidates[%d] %d", bi, stats.nofCandidates[bi]);
+		}
+		std::vector<SimHashQueryResult>::const_iterator ri = res.begin(), re = res.end();
+		for (; ri != re; ++ri)
+		{
+			m_debugtrace->event( "result", _TXT("featno %d, simdist %d, weight %.5f"), ri->featno(), ri->simdist(), ri->weight());
+		}
+		m_debugtrace->close();
+	}
+	std::vector<VectorQueryResult> rt = simHashToVectorQueryResults( res, maxNofResults, minSimilarity);
+	if (!cacheKey.empty())
+	{
+		m_queryResultCache->put( cacheKey, type, rt, cacheTicket);
+	}
+	return rt;
+}
+
+std::vector<VectorQueryResult> VectorStorageClient::findSimilar( const std::string& type, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	try
+	{
+		std::vector<VectorQueryResult> rt = findSimilarImpl( type, vec, NULL/*restriction*/, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("vector search failed: %s"), m_errorhnd->fetchError());
+		}
+		return rt;
+	}
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar: %s"), MODULENAME, *m_errorhnd, std::vector<VectorQueryResult>());
+}
+
+strus::Reference<SimHashSlotSet> VectorSearchRestriction::slotSet( const strus::Reference<SimHashMap>& simHashMap) const
+{
+	strus::scoped_lock lock( m_mutex);
+	SlotSetDef& def = m_slotSetMap[ simHashMap->typeno()];
+	if (!def.slotSet.get() || def.serialno != simHashMap->serialNumber())
+	{
+		// ... first search of the type or the searcher has been replaced by a commit, the slots of the old one are not valid anymore
+		def.slotSet.reset( new SimHashSlotSet( simHashMap->createSlotSet( m_featnolist)));
+		def.serialno = simHashMap->serialNumber();
+	}
+	return def.slotSet;
+}
+
+VectorSearchRestrictionInterface* VectorStorageClient::createSearchRestriction( const std::vector<std::string>& features) const
+{
+	try
+	{
+		std::vector<Index> featnolist;
+		featnolist.reserve( features.size());
+		std::vector<std::string>::const_iterator fi = features.begin(), fe = features.end();
+		for (; fi != fe; ++fi)
+		{
+			Index featno = m_database->readFeatno( *fi);
+			if (featno) featnolist.push_back( featno);
+		}
+		std::sort( featnolist.begin(), featnolist.end());
+		featnolist.erase( std::unique( featnolist.begin(), featnolist.end()), featnolist.end());
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("failed to resolve the features of a search restriction: %s"), m_errorhnd->fetchError());
+		}
+		return new VectorSearchRestriction( this, featnolist);
+	}
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' creating a search restriction: %s"), MODULENAME, *m_errorhnd, NULL);
+}
+
+std::vector<VectorQueryResult> VectorStorageClient::findSimilarRestricted( const std::string& type, const WordVector& vec, const VectorSearchRestrictionInterface& restriction, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	try
+	{
+		const VectorSearchRestriction* restrictionImpl = dynamic_cast<const VectorSearchRestriction*>( &restriction);
+		if (!restrictionImpl || restrictionImpl->client() != this)
+		{
+			throw std::runtime_error( _TXT("search restriction not created by this vector storage client"));
+		}
+		std::vector<VectorQueryResult> rt = findSimilarImpl( type, vec, restrictionImpl, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("restricted vector search failed: %s"), m_errorhnd->fetchError());
+		}
+		return rt;
+	}
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar restricted: %s"), MODULENAME, *m_errorhnd, std::vector<VectorQueryResult>());
+}
+
+namespace strus {
+/// \brief Search of the LSH values of different types for the same needle, one type is a unit of work of the calling thread or a thread of the search pool
+class MultiTypeSearchContext
+	:public SearchWorkerPool::Task
+{
+public:
+	MultiTypeSearchContext( const VectorStorageClient* client_, const std::vector<VectorStorageClient::SimHashMapRef>* maps_, const SimHash* needle_, const WordVector* vec_, int maxNofResults_, double minSimilarity_, double speedRecallFactor_, bool realVecWeights_, ErrorBufferInterface* errorhnd_)
+		:m_client(client_),m_maps(maps_),m_needle(needle_),m_vec(vec_)
+		,m_maxNofResults(maxNofResults_),m_minSimilarity(minSimilarity_),m_speedRecallFactor(speedRecallFactor_),m_realVecWeights(realVecWeights_)
+		,m_errorhnd(errorhnd_),m_results(maps_->size()),m_nextidx(0),m_mutex(),m_error(){}
+	virtual ~MultiTypeSearchContext(){}
+
+	/// \brief Search the next type not taken yet
+	/// \return false if all types are taken or an error occurred
+	virtual bool runNext()
+	{
+		std::size_t idx;
+		{
+			strus::scoped_lock lock( m_mutex);
+			if (m_nextidx >= m_maps->size() || !m_error.empty()) return false;
+			idx = m_nextidx++;
+		}
+		try
+		{
+			m_results[ idx] = m_client->searchSimHashMap( *(*m_maps)[ idx], *m_needle, *m_vec, NULL/*slotFilter*/, m_maxNofResults, m_minSimilarity, m_speedRecallFactor, m_realVecWeights, NULL/*stats*/);
+			if (m_errorhnd->hasError())
 			{
-				res = simHashMap->findSimilar( needle, simdist, probsimdist, maxNofSimResults);
+				// ... an error reported to the error buffer of this thread is moved to the task, the threads of the pool are reused by other searches
+				reportError( m_errorhnd->fetchError());
 			}
-			std::vector<SimHashQueryResult>::iterator ri = res.begin(), re = res.end();
-			for (; ri != re; ++ri)
+		}
+		catch (const std::runtime_error& err)
+		{
+			reportError( err.what());
+		}
+		catch (const std::bad_alloc&)
+		{
+			reportError( _TXT("out of memory"));
+		}
+		catch (...)
+		{
+			reportError( _TXT("uncaught exception"));
+		}
+		return true;
+	}
+
+	bool hasError() const
+	{
+		return !m_error.empty();
+	}
+	const std::string& error() const
+	{
+		return m_error;
+	}
+	std::vector<std::vector<SimHashQueryResult> >& results()
+	{
+		return m_results;
+	}
+
+private:
+	void reportError( const char* msg)
+	{
+		strus::scoped_lock lock( m_mutex);
+		if (m_error.empty()) m_error = msg;
+	}
+
+private:
+	const VectorStorageClient* m_client;
+	const std::vector<VectorStorageClient::SimHashMapRef>* m_maps;
+	const SimHash* m_needle;
+	const WordVector* m_vec;
+	int m_maxNofResults;
+	double m_minSimilarity;
+	double m_speedRecallFactor;
+	bool m_realVecWeights;
+	ErrorBufferInterface* m_errorhnd;
+	std::vector<std::vector<SimHashQueryResult> > m_results;
+	std::size_t m_nextidx;
+	strus::mutex m_mutex;
+	std::string m_error;
+};
+}//namespace
+
+std::vector<std::vector<SimHashQueryResult> > VectorStorageClient::searchMultiTypes( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	std::vector<SimHashMapRef> maps;
+	maps.reserve( types.size());
+	std::vector<std::string>::const_iterator ti = types.begin(), te = types.end();
+	for (; ti != te; ++ti)
+	{
+		maps.push_back( getOrCreateTypeSimHashMap( *ti));
+	}
+	// ... the LSH value of the needle is calculated only once for all types
+	SimHash needle( m_model.simHash( strus::normalizeVector( vec), 0));
+
+	MultiTypeSearchContext context( this, &maps, &needle, &vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights, m_errorhnd);
+	if (m_searchWorkerPool.get() && maps.size() > 1)
+	{
+		m_searchWorkerPool->run( context);
+	}
+	else
+	{
+		while (context.runNext()){}
+	}
+	if (context.hasError())
+	{
+		throw strus::runtime_error(_TXT("failed to search multiple types: %s"), context.error().c_str());
+	}
+	return context.results();
+}
+
+std::vector<std::vector<VectorQueryResult> > VectorStorageClient::findSimilarMulti( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	try
+	{
+		std::vector<std::vector<VectorQueryResult> > rt;
+		std::vector<std::vector<SimHashQueryResult> > res = searchMultiTypes( types, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+		std::vector<std::vector<SimHashQueryResult> >::const_iterator ri = res.begin(), re = res.end();
+		for (; ri != re; ++ri)
+		{
+			rt.push_back( simHashToVectorQueryResults( *ri, maxNofResults, minSimilarity));
+		}
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("vector search failed: %s"), m_errorhnd->fetchError());
+		}
+		return rt;
+	}
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar of multiple types: %s"), MODULENAME, *m_errorhnd, std::vector<std::vector<VectorQueryResult> >());
+}
+
+namespace {
+/// \brief Reference to a result of a search over multiple types
+struct TypedSimHashQueryResult
+{
+	int typeidx;
+	SimHashQueryResult result;
+
+	TypedSimHashQueryResult()
+		:typeidx(0),result(){}
+	TypedSimHashQueryResult( int typeidx_, const SimHashQueryResult& result_)
+		:typeidx(typeidx_),result(result_){}
+	TypedSimHashQueryResult( const TypedSimHashQueryResult& o)
+		:typeidx(o.typeidx),result(o.result){}
+
+	/// \brief Order with descending weight
+	bool operator < ( const TypedSimHashQueryResult& o) const
+	{
+		if (result.weight() > o.result.weight()) return true;
+		if (result.weight() < o.result.weight()) return false;
+		return typeidx == o.typeidx ? result.featno() < o.result.featno() : typeidx < o.typeidx;
+	}
+};
+}//anonymous namespace
+
+std::vector<VectorQueryTypedResult> VectorStorageClient::findSimilarMultiMerged( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const
+{
+	try
+	{
+		std::vector<VectorQueryTypedResult> rt;
+		std::vector<std::vector<SimHashQueryResult> > res = searchMultiTypes( types, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+
+		std::vector<TypedSimHashQueryResult> merged;
+		std::vector<std::vector<SimHashQueryResult> >::const_iterator ri = res.begin(), re = res.end();
+		for (int ridx=0; ri != re; ++ri,++ridx)
+		{
+			std::vector<SimHashQueryResult>::const_iterator ti = ri->begin(), te = ri->end();
+			for (; ti != te; ++ti)
 			{
-				arma::fvec resvv( m_database->readVector( simHashMap->typeno(), ri->featno()));
-				ri->setWeight( arma::norm_dot( vv, resvv));
+				merged.push_back( TypedSimHashQueryResult( ridx, *ti));
 			}
-			std::sort( res.begin(), res.end(), std::greater<SimHashQueryResult>());
+		}
+		if (merged.size() > (std::size_t)maxNofResults)
+		{
+			std::partial_sort( merged.begin(), merged.begin() + maxNofResults, merged.end());
+			merged.resize( maxNofResults);
 		}
 		else
 		{
-			SimHash needle( m_model.simHash( strus::normalizeVector( vec), 0));
-			if (m_debugtrace)
+			std::sort( merged.begin(), merged.end());
+		}
+		std::vector<Index> featnolist;
+		std::vector<TypedSimHashQueryResult>::const_iterator mi = merged.begin(), me = merged.end();
+		for (; mi != me && mi->result.weight() >= minSimilarity; ++mi)
+		{
+			featnolist.push_back( mi->result.featno());
+		}
+		std::vector<std::string> names = m_database->readFeatNames( featnolist);
+		std::vector<std::string>::const_iterator ni = names.begin(), ne = names.end();
+		for (mi = merged.begin(); ni != ne; ++ni,++mi)
+		{
+			rt.push_back( VectorQueryTypedResult( types[ mi->typeidx], VectorQueryResult( *ni, mi->result.weight())));
+		}
+		if (m_errorhnd->hasError())
+		{
+			throw strus::runtime_error(_TXT("vector search failed: %s"), m_errorhnd->fetchError());
+		}
+		return rt;
+	}
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar of multiple types merged: %s"), MODULENAME, *m_errorhnd, std::vector<VectorQueryTypedResult>());
+}
+
+namespace strus {
+/// \brief Consumer of the results of a radius search of a SimHashMap doing the reranking and passing the results to the client consumer
+class RadiusSearchResultConsumer
+	:public SimHashMap::ResultConsumerInterface
+{
+public:
+	RadiusSearchResultConsumer( VectorQueryResultConsumerInterface* consumer_, std::vector<SimHashQueryResult>* collected_, const SimHashMap* simHashMap_, const ProductQuantizer* productQuantizer_, const VectorStorageClient* client_, const WordVector* vec_, double minSimilarity_, bool realVecWeights_)
+		:m_consumer(consumer_),m_collected(collected_),m_simHashMap(simHashMap_),m_productQuantizer(productQuantizer_),m_client(client_),m_vec(vec_),m_minSimilarity(minSimilarity_),m_realVecWeights(realVecWeights_),m_nofResults(0),m_rerankBuffer(),m_featnolist(){}
+	virtual ~RadiusSearchResultConsumer(){}
+
+	virtual bool consume( std::vector<SimHashQueryResult>& chunk)
+	{
+		if (m_realVecWeights)
+		{
+			m_client->rerankWithRealWeights( chunk, *m_simHashMap, *m_vec, m_rerankBuffer);
+		}
+		else if (m_productQuantizer)
+		{
+			m_client->rerankWithProductQuantizer( chunk, *m_productQuantizer, *m_vec);
+		}
+		std::vector<SimHashQueryResult>::const_iterator ci = chunk.begin(), ce = chunk.end();
+		if (m_collected)
+		{
+			for (; ci != ce; ++ci)
 			{
-				res = simHashMap->findSimilarWithStats( stats, needle, simdist, probsimdist, maxNofResults);
+				if (ci->weight() >= m_minSimilarity) m_collected->push_back( *ci);
 			}
-			else
+			return true;
+		}
+		// ... the names of the results of a chunk are read with one cursor sweep
+		m_featnolist.clear();
+		for (; ci != ce; ++ci)
+		{
+			if (ci->weight() >= m_minSimilarity) m_featnolist.push_back( ci->featno());
+		}
+		if (m_featnolist.empty()) return true;
+		std::vector<std::string> names = m_client->getFeatNamesFromIndex( m_featnolist);
+		std::vector<std::string>::const_iterator ni = names.begin(), ne = names.end();
+		for (ci = chunk.begin(); ni != ne; ++ci)
+		{
+			if (ci->weight() < m_minSimilarity) continue;
+			++m_nofResults;
+			if (!m_consumer->consume( VectorQueryResult( *ni, ci->weight()))) return false;
+			++ni;
+		}
+		return true;
+	}
+
+	int nofResults() const
+	{
+		return m_nofResults;
+	}
+
+private:
+	VectorQueryResultConsumerInterface* m_consumer;
+	std::vector<SimHashQueryResult>* m_collected;
+	const SimHashMap* m_simHashMap;
+	const ProductQuantizer* m_productQuantizer;
+	const VectorStorageClient* m_client;
+	const WordVector* m_vec;
+	double m_minSimilarity;
+	bool m_realVecWeights;
+	int m_nofResults;
+	VectorStorageClient::RerankBuffer m_rerankBuffer;	///< buffers for the reranking reused for all chunks
+	std::vector<Index> m_featnolist;			///< buffer for the feature numbers of the results of a chunk
+};
+}//namespace
+
+int VectorStorageClient::findSimilarWithinRadius( VectorQueryResultConsumerInterface& consumer, const std::string& type, const WordVector& vec, double minSimilarity, double speedRecallFactor, bool realVecWeights, bool sorted) const
+{
+	try
+	{
+		if (minSimilarity < 0.0 || minSimilarity > 1.0)
+		{
+			throw std::runtime_error( _TXT( "min similarity parameter out of range"));
+		}
+		strus::Reference<SimHashMap> simHashMap = getOrCreateTypeSimHashMap( type);
+
+		int simdist;
+		int probsimdist;
+		getSearchDistances( simdist, probsimdist, minSimilarity, speedRecallFactor);
+
+		const ProductQuantizer* productQuantizer = realVecWeights ? NULL : simHashMap->productQuantizer();
+		SimHash needle( m_model.simHash( strus::normalizeVector( vec), 0));
+
+		int rt = 0;
+		if (sorted)
+		{
+			std::vector<SimHashQueryResult> res;
+			RadiusSearchResultConsumer collector( &consumer, &res, simHashMap.get(), productQuantizer, this, &vec, minSimilarity, realVecWeights);
+			(void)simHashMap->findWithinRadius( collector, needle, simdist, probsimdist, NULL/*slotFilter*/);
+			std::sort( res.begin(), res.end(), std::greater<SimHashQueryResult>());
+
+			// ... the names are read in batches with one cursor sweep each, a consumer stopping early does not cause the names of all results to be read
+			std::vector<Index> featnolist;
+			std::vector<SimHashQueryResult>::const_iterator ri = res.begin(), re = res.end();
+			bool stopped = false;
+			while (ri != re && !stopped)
 			{
-				res = simHashMap->findSimilar( needle, simdist, probsimdist, maxNofResults);
+				std::size_t batchSize = std::min( (std::size_t)RadiusResultNameBatchSize, (std::size_t)(re - ri));
+				featnolist.clear();
+				std::vector<SimHashQueryResult>::const_iterator bi = ri, be = ri + batchSize;
+				for (; bi != be; ++bi) featnolist.push_back( bi->featno());
+
+				std::vector<std::string> names = m_database->readFeatNames( featnolist);
+				std::vector<std::string>::const_iterator ni = names.begin(), ne = names.end();
+				for (; ni != ne; ++ni,++ri)
+				{
+					++rt;
+					if (!consumer.consume( VectorQueryResult( *ni, ri->weight())))
+					{
+						stopped = true;
+						break;
+					}
+				}
 			}
 		}
+		else
+		{
+			RadiusSearchResultConsumer streamer( &consumer, NULL, simHashMap.get(), productQuantizer, this, &vec, minSimilarity, realVecWeights);
+			(void)simHashMap->findWithinRadius( streamer, needle, simdist, probsimdist, NULL/*slotFilter*/);
+			rt = streamer.nofResults();
+		}
 		if (m_debugtrace)
 		{
 			std::string vecstr = vec.tostring(", ", 10);
-			m_debugtrace->event( "findsim", "%s {%s,...}", type.c_str(), vecstr.c_str());
-			m_debugtrace->open( "search");
-			m_debugtrace->event( "param", _TXT("LSH simdist %d"), simdist);
-			m_debugtrace->event( "param", _TXT("LSH prob simdist %d"), probsimdist);
-			m_debugtrace->event( "param", _TXT("feature type %s"), type.c_str());
-			m_debugtrace->event( "param", _TXT("max results %d"), maxNofResults);
-			m_debugtrace->event( "param", _TXT("min similarity %.5f"), minSimilarity);
-			m_debugtrace->event( "param", _TXT("use real weights %s"), realVecWeights ? "yes":"no");
-
-			m_debugtrace->event( "stats", _TXT("benches %d"), stats.nofBenches);
-			m_debugtrace->event( "stats", _TXT("values %d"), stats.nofValues);
-			m_debugtrace->event( "stats", _TXT("database reads %d"), stats.nofDatabaseReads);
-			m_debugtrace->event( "stats", _TXT("partial prob sum %d"), stats.probSum);
-			m_debugtrace->event( "stats", _TXT("best filter samples max dist %d"), stats.samplesMaxDist);
-			m_debugtrace->event( "stats", _TXT("results %d"), stats.nofResults);
-			for (int bi=0; bi<stats.nofBenches; ++bi)
-			{
-				m_debugtrace->event( "stats", "candidates[%d] %d", bi, stats.nofCandidates[bi]);
-			}
-			std::vector<SimHashQueryResult>::const_iterator ri = res.begin(), re = res.end();
-			for (; ri != re; ++ri)
-			{
-				m_debugtrace->event( "result", _TXT("featno %d, simdist %d, weight %.5f"), ri->featno(), ri->simdist(), ri->weight());
-			}
-			m_debugtrace->close();
+			m_debugtrace->event( "findradius", "%s {%s,...} simdist %d prob simdist %d results %d", type.c_str(), vecstr.c_str(), simdist, probsimdist, rt);
 		}
-		std::vector<VectorQueryResult> rt = simHashToVectorQueryResults( res, maxNofResults, minSimilarity);
-
 		if (m_errorhnd->hasError())
 		{
-			throw strus::runtime_error(_TXT("vector search failed: %s"), m_errorhnd->fetchError());
+			throw strus::runtime_error(_TXT("vector radius search failed: %s"), m_errorhnd->fetchError());
 		}
 		return rt;
 	}
-	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar: %s"), MODULENAME, *m_errorhnd, std::vector<VectorQueryResult>());
+	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' in find similar within radius: %s"), MODULENAME, *m_errorhnd, 0);
 }
 
 VectorStorageTransactionInterface* VectorStorageClient::createTransaction()
@@ -220,7 +832,7 @@ class FeatureValueIterator
 	:public ValueIteratorInterface
 {
 public:
-	FeatureValueIterator( const DatabaseClientInterface* database_, ErrorBufferInterface* errorhnd_)
+	FeatureValueIterator( const DatabaseAdapter* database_, ErrorBufferInterface* errorhnd_)
 		:m_errorhnd(errorhnd_),m_dbcursor( database_),m_value(),m_keyprefix(),m_hasValue(false),m_hasInit(false){}
 	~FeatureValueIterator(){}
 
@@ -298,7 +910,7 @@ ValueIteratorInterface* VectorStorageClient::createFeatureValueIterator() const
 {
 	try
 	{
-		return new FeatureValueIterator( m_database->database(), m_errorhnd);
+		return new FeatureValueIterator( m_database.get(), m_errorhnd);
 	}
 	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' creating a feature value iterator: %s"), MODULENAME, *m_errorhnd, NULL);
 }
@@ -424,7 +1036,7 @@ SentenceLexerInstanceInterface* VectorStorageClient::createSentenceLexer() const
 		{
 			prepareSearch( ti->first);
 		}
-		return new SentenceLexerInstance( this, m_database->database(), m_lexerConfig, m_errorhnd);
+		return new SentenceLexerInstance( this, m_database.get(), m_lexerConfig, m_errorhnd);
 	}
 	CATCH_ERROR_ARG1_MAP_RETURN( _TXT("error in client interface of '%s' getting the configuration string this storage was built with: %s"), MODULENAME, *m_errorhnd, NULL);
 }
@@ -442,6 +1054,15 @@ void VectorStorageClient::close()
 {
 	try
 	{
+		if (m_debugtrace)
+		{
+			KeyValueCache::Statistics stats = m_database->nameCacheStatistics();
+			m_debugtrace->event( "namecache", "hits %u misses %u entries %u", (unsigned int)stats.hits, (unsigned int)stats.misses, (unsigned int)stats.entries);
+			CompactionScheduler::Statistics compactionStats = m_database->compactionStatistics();
+			m_debugtrace->event( "compaction", "compactions %u bytes written since last %u", (unsigned int)compactionStats.nofCompactions, (unsigned int)compactionStats.bytesWritten);
+			VectorQueryResultCacheStatistics resultCacheStats = queryResultCacheStatistics();
+			m_debugtrace->event( "resultcache", "hits %u misses %u entries %u", (unsigned int)resultCacheStats.hits, (unsigned int)resultCacheStats.misses, (unsigned int)resultCacheStats.entries);
+		}
 		m_database->close();
 	}
 	CATCH_ERROR_ARG1_MAP( _TXT("error in client interface of '%s' closing this storage client: %s"), MODULENAME, *m_errorhnd);
@@ -453,16 +1074,130 @@ void VectorStorageClient::compaction()
 	{
 		m_database->compaction();
 	}
-	CATCH_ERROR_ARG1_MAP( _TXT("error in client interface of '%s' closing this storage client: %s"), MODULENAME, *m_errorhnd);
+	CATCH_ERROR_ARG1_MAP( _TXT("error in client interface of '%s' compacting the database of this storage client: %s"), MODULENAME, *m_errorhnd);
 }
 
-void VectorStorageClient::resetSimHashMapTypes( const std::vector<std::string>& types_)
+int VectorStorageClient::nofSearchersCreated() const
 {
-	if (!m_simHashMapMap.get()) return;
+	strus::scoped_lock lock( m_simHashMap_mutex);
+	return m_nofSimHashMapsCreated;
+}
 
-	SimHashMapMapRef simHashMapMapRef = m_simHashMapMap;
+VectorQueryResultCacheStatistics VectorStorageClient::queryResultCacheStatistics() const
+{
+	if (!m_queryResultCache.get()) return VectorQueryResultCacheStatistics();
+	QueryResultCache::Statistics stats = m_queryResultCache->statistics();
+	return VectorQueryResultCacheStatistics( stats.hits, stats.misses, stats.entries);
+}
+
+void VectorStorageClient::syncAllocationCounters()
+{
+	// ... another client on the same database may have committed new types or features since the last allocation
+	Index nofTypeno = m_database->readNofTypeno();
+	Index nofFeatno = m_database->readNofFeatno();
+	if (nofTypeno > m_nofTypenoAllocated) m_nofTypenoAllocated = nofTypeno;
+	if (nofFeatno > m_nofFeatnoAllocated) m_nofFeatnoAllocated = nofFeatno;
+}
+
+Index VectorStorageClient::getOrAllocateTypeno( const std::string& type, bool& isAllocated, bool acquire)
+{
+	PendingAllocationMap::iterator ai = m_allocatedTypenoMap.find( type);
+	if (ai != m_allocatedTypenoMap.end())
+	{
+		// ... the type is pending, allocated by a transaction not committed yet, all transactions defining it share the number
+		isAllocated = true;
+		if (acquire) ++ai->second.refcnt;
+		return ai->second.no;
+	}
+	Index rt = m_database->readTypeno( type);
+	isAllocated = !rt;
+	if (!rt)
+	{
+		rt = ++m_nofTypenoAllocated;
+		m_allocatedTypenoMap[ type] = PendingAllocation( rt, 1);
+	}
+	return rt;
+}
+
+Index VectorStorageClient::getOrAllocateFeatno( const std::string& feature, bool& isAllocated, bool acquire)
+{
+	PendingAllocationMap::iterator ai = m_allocatedFeatnoMap.find( feature);
+	if (ai != m_allocatedFeatnoMap.end())
+	{
+		// ... the feature is pending, allocated by a transaction not committed yet, all transactions defining it share the number
+		isAllocated = true;
+		if (acquire) ++ai->second.refcnt;
+		return ai->second.no;
+	}
+	Index rt = m_database->readFeatno( feature);
+	isAllocated = !rt;
+	if (!rt)
+	{
+		rt = ++m_nofFeatnoAllocated;
+		m_allocatedFeatnoMap[ feature] = PendingAllocation( rt, 1);
+	}
+	return rt;
+}
+
+void VectorStorageClient::releasePendingAllocations( PendingAllocationMap& map, const std::set<std::string>& names)
+{
+	std::set<std::string>::const_iterator ni = names.begin(), ne = names.end();
+	for (; ni != ne; ++ni)
+	{
+		// ... a name not found has been dropped by a reset of the allocation after clearing the storage
+		PendingAllocationMap::iterator ai = map.find( *ni);
+		if (ai != map.end() && --ai->second.refcnt <= 0)
+		{
+			map.erase( ai);
+		}
+	}
+}
+
+void VectorStorageClient::releaseAllocatedNames( const std::set<std::string>& types_, const std::set<std::string>& features_)
+{
+	AllocationLock lock( this);
+	releasePendingAllocations( m_allocatedTypenoMap, types_);
+	releasePendingAllocations( m_allocatedFeatnoMap, features_);
+}
+
+void VectorStorageClient::resetAllocation()
+{
+	AllocationLock lock( this);
+	m_nofTypenoAllocated = 0;
+	m_nofFeatnoAllocated = 0;
+	m_allocatedTypenoMap.clear();
+	m_allocatedFeatnoMap.clear();
+}
+
+void VectorStorageClient::resetSimHashMapTypes( const std::vector<std::string>& types_, bool cleared)
+{
+	strus::scoped_lock lock( m_simHashMap_mutex);
+	if (cleared)
+	{
+		SimHashMapBuildMap::iterator bi = m_simHashMapBuilds.begin(), be = m_simHashMapBuilds.end();
+		for (; bi != be; ++bi)
+		{
+			bi->second->invalidated = true;
+		}
+		m_simHashMapBuilds.clear();
+		m_simHashMapMap.reset();
+		return;
+	}
 	std::vector<std::string>::const_iterator ti = types_.begin(), te = types_.end();
 	for (; ti != te; ++ti)
+	{
+		// ... a searcher created concurrently may have loaded the values before the commit, it is not published
+		SimHashMapBuildMap::iterator bi = m_simHashMapBuilds.find( *ti);
+		if (bi != m_simHashMapBuilds.end())
+		{
+			bi->second->invalidated = true;
+			m_simHashMapBuilds.erase( bi);
+		}
+	}
+	if (!m_simHashMapMap.get()) return;
+
+	SimHashMapMapRef simHashMapMapRef = m_simHashMapMap;
+	for (ti = types_.begin(); ti != te; ++ti)
 	{
 		SimHashMapMap::const_iterator mi = simHashMapMapRef->find( *ti);
 		if (mi != simHashMapMapRef->end()) break;
@@ -478,11 +1213,27 @@ void VectorStorageClient::resetSimHashMapTypes( const std::vector<std::string>&
 	}
 }
 
-strus::Reference<SimHashMap> VectorStorageClient::getSimHashMap( const std::string& type) const
+void VectorStorageClient::resetQueryResultCacheTypes( const std::vector<std::string>& types_, bool cleared)
 {
-	if (!m_simHashMapMap.get()) return strus::Reference<SimHashMap>();
+	if (!m_queryResultCache.get()) return;
+	if (cleared)
+	{
+		m_queryResultCache->clear();
+	}
+	else
+	{
+		m_queryResultCache->invalidateTypes( types_);
+	}
+}
 
-	SimHashMapMapRef simHashMapMapRef = m_simHashMapMap;
+strus::Reference<SimHashMap> VectorStorageClient::getSimHashMap( const std::string& type) const
+{
+	SimHashMapMapRef simHashMapMapRef;
+	{
+		strus::scoped_lock lock( m_simHashMap_mutex);
+		simHashMapMapRef = m_simHashMapMap;
+	}
+	if (!simHashMapMapRef.get()) return strus::Reference<SimHashMap>();
 	SimHashMapMap::const_iterator mi = simHashMapMapRef->find( type);
 
 	if (mi == simHashMapMapRef->end())
@@ -499,6 +1250,80 @@ strus::Reference<SimHashMap> VectorStorageClient::getOrCreateTypeSimHashMap( con
 {
 	strus::Reference<SimHashMap> rt = getSimHashMap( type);
 	if (rt.get()) return rt;
+
+	SimHashMapBuildRef build;
+	{
+		strus::unique_lock lock( m_simHashMap_mutex);
+		if (m_simHashMapMap.get())
+		{
+			// ... the searcher may have been published since the lookup without lock
+			SimHashMapMap::const_iterator mi = m_simHashMapMap->find( type);
+			if (mi != m_simHashMapMap->end()) return mi->second;
+		}
+		SimHashMapBuildMap::const_iterator bi = m_simHashMapBuilds.find( type);
+		if (bi != m_simHashMapBuilds.end())
+		{
+			// ... another thread is creating the searcher, wait for its result instead of loading the values again
+			build = bi->second;
+			while (!build->finished) m_simHashMap_cond.wait( lock);
+			if (!build->error.empty())
+			{
+				throw strus::runtime_error(_TXT("failed to create searcher for vectors of the feature type %s: %s"), type.c_str(), build->error.c_str());
+			}
+			return build->result;
+		}
+		build.reset( new SimHashMapBuild());
+		m_simHashMapBuilds[ type] = build;
+	}
+	try
+	{
+		rt = createTypeSimHashMap( type);
+	}
+	catch (const std::bad_alloc&)
+	{
+		finishSimHashMapBuild( type, build, rt, _TXT("out of memory"));
+		throw;
+	}
+	catch (const std::runtime_error& err)
+	{
+		finishSimHashMapBuild( type, build, rt, err.what());
+		throw;
+	}
+	catch (...)
+	{
+		finishSimHashMapBuild( type, build, rt, _TXT("uncaught exception"));
+		throw;
+	}
+	finishSimHashMapBuild( type, build, rt, std::string());
+	return rt;
+}
+
+void VectorStorageClient::finishSimHashMapBuild( const std::string& type, SimHashMapBuildRef& build, const SimHashMapRef& result, const std::string& error) const
+{
+	strus::scoped_lock lock( m_simHashMap_mutex);
+	if (error.empty())
+	{
+		// ... the serial number identifies the searcher for the sets of slots of restrictions, it is assigned before the searcher is published
+		result->setSerialNumber( ++m_nofSimHashMapsCreated);
+	}
+	build->result = result;
+	build->error = error;
+	build->finished = true;
+	if (!build->invalidated)
+	{
+		m_simHashMapBuilds.erase( type);
+		if (build->error.empty())
+		{
+			SimHashMapMapRef simHashMapMapCopy( m_simHashMapMap.get() ? new SimHashMapMap( *m_simHashMapMap) : new SimHashMapMap());
+			simHashMapMapCopy->insert( SimHashMapMap::value_type( type, result));
+			m_simHashMapMap = simHashMapMapCopy;
+		}
+	}
+	m_simHashMap_cond.notify_all();
+}
+
+strus::Reference<SimHashMap> VectorStorageClient::createTypeSimHashMap( const std::string& type) const
+{
 	strus::Index typeno = m_database->readTypeno( type);
 	if (!typeno) throw strus::runtime_error(_TXT("queried type is not defined: %s"), type.c_str());
 
@@ -514,21 +1339,21 @@ strus::Reference<SimHashMap> VectorStorageClient::getOrCreateTypeSimHashMap( con
 		reader.reset( new SimHashReaderMemory( m_database.get(), type));
 	}
 	strus::Reference<SimHashMap> simHashMapRef( new SimHashMap( reader, typeno));
+	simHashMapRef->setTopKMethod( m_topKMethod);
 	simHashMapRef->load();
-
-	if (!m_simHashMapMap.get())
+	if (std::find( m_inMemoryVectorTypes.begin(), m_inMemoryVectorTypes.end(), type) != m_inMemoryVectorTypes.end())
 	{
-		SimHashMapMapRef simHashMapMapCopy( new SimHashMapMap());
-		simHashMapMapCopy->insert( SimHashMapMap::value_type( type, simHashMapRef));
-		m_simHashMapMap = simHashMapMapCopy;
+		strus::Reference<VectorMemoryStore> vectorStore( new VectorMemoryStore( m_database.get(), typeno, m_model.vecdim()));
+		simHashMapRef->setVectorStore( vectorStore);
 	}
-	else
+	if (std::find( m_productQuantizedTypes.begin(), m_productQuantizedTypes.end(), type) != m_productQuantizedTypes.end())
 	{
-		SimHashMapMapRef simHashMapMapRef = m_simHashMapMap;
-		SimHashMapMapRef simHashMapMapCopy( new SimHashMapMap( *simHashMapMapRef));
-		simHashMapMapCopy->insert( SimHashMapMap::value_type( type, simHashMapRef));
-		m_simHashMapMap = simHashMapMapCopy;
+		int nofSubspaces = m_nofProductQuantizerSubspaces;
+		if (nofSubspaces <= 0) nofSubspaces = (m_model.vecdim() + DefaultProductQuantizerSubspaceDim - 1) / DefaultProductQuantizerSubspaceDim;
+		strus::Reference<ProductQuantizer> productQuantizer( new ProductQuantizer( m_database.get(), typeno, m_model.vecdim(), nofSubspaces));
+		simHashMapRef->setProductQuantizer( productQuantizer);
 	}
+
 	if (m_debugtrace) m_debugtrace->event( "simhash", _TXT("created searcher (%s) for vectors of the feature type %s"), readerClass, type.c_str());
 	return simHashMapRef;
 }
@@ -576,5 +1401,10 @@ std::string VectorStorageClient::getFeatNameFromIndex( const Index& featno) cons
 	return m_database->readFeatName( featno);
 }
 
+std::vector<std::string> VectorStorageClient::getFeatNamesFromIndex( const std::vector<Index>& featnolist) const
+{
+	return m_database->readFeatNames( featnolist);
+}
+
 
 
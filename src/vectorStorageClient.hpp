@@ -9,6 +9,7 @@
 #ifndef _STRUS_VECTOR_STORAGE_CLIENT_IMPLEMENTATION_HPP_INCLUDED
 #define _STRUS_VECTOR_STORAGE_CLIENT_IMPLEMENTATION_HPP_INCLUDED
 #include "strus/vectorStorageClientInterface.hpp"
+#include "strus/vectorStorageSearchInterface.hpp"
 #include "strus/storage/wordVector.hpp"
 #include "strus/reference.hpp"
 #include "databaseAdapter.hpp"
@@ -16,10 +17,13 @@
 #include "sentenceLexerConfig.hpp"
 #include "lshModel.hpp"
 #include "simHashMap.hpp"
+#include "queryResultCache.hpp"
+#include "searchWorkerPool.hpp"
 #include "strus/base/thread.hpp"
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 
 namespace strus {
 
@@ -31,11 +35,68 @@ class DebugTraceContextInterface;
 class DatabaseInterface;
 /// \brief Forward declaration
 class VectorStorage;
+/// \brief Forward declaration
+class RadiusSearchResultConsumer;
+
+/// \brief Forward declaration
+class MultiTypeSearchContext;
+
+/// \brief Forward declaration
+class VectorStorageClient;
+
+/// \brief Restriction of searches to a set of features with the sets of slots built for the searchers of the types searched
+/// \note A set of slots is identified with the searcher it has been built for by the serial number of the searcher, the searcher is not kept referenced
+class VectorSearchRestriction
+	:public VectorSearchRestrictionInterface
+{
+public:
+	/// \brief Constructor
+	/// \param[in] featnolist_ feature numbers of the restriction, sorted in ascending order without duplicates
+	VectorSearchRestriction( const VectorStorageClient* client_, const std::vector<Index>& featnolist_)
+		:m_client(client_),m_featnolist(featnolist_),m_mutex(),m_slotSetMap(){}
+	virtual ~VectorSearchRestriction(){}
+
+	virtual int nofFeatures() const
+	{
+		return m_featnolist.size();
+	}
+
+	/// \brief Get the client that created the restriction
+	const VectorStorageClient* client() const
+	{
+		return m_client;
+	}
+	/// \brief Get the set of slots of the features of the restriction in a searcher, build it if it does not exist for this searcher yet
+	strus::Reference<SimHashSlotSet> slotSet( const strus::Reference<SimHashMap>& simHashMap) const;
+
+private:
+	/// \brief Set of slots with the serial number of the searcher it has been built for
+	struct SlotSetDef
+	{
+		int serialno;
+		strus::Reference<SimHashSlotSet> slotSet;
+
+		SlotSetDef()
+			:serialno(0),slotSet(){}
+		SlotSetDef( const SlotSetDef& o)
+			:serialno(o.serialno),slotSet(o.slotSet){}
+	};
+
+	const VectorStorageClient* m_client;
+	std::vector<Index> m_featnolist;
+	mutable strus::mutex m_mutex;				///< mutual exclusion in the access of the sets of slots by concurrent searches
+	mutable std::map<Index,SlotSetDef> m_slotSetMap;	///< sets of slots per type number
+};
 
 class VectorStorageClient
 	:public VectorStorageClientInterface
+	,public VectorStorageSearchInterface
 {
 public:
+	enum {DefaultNameCacheSize=100000};	///< default maximum number of entries of the cache for the name resolution
+	enum {DefaultCompactionMinInterval=600};	///< default minimum number of seconds between two compactions in the background
+	enum {RadiusResultNameBatchSize=256};	///< number of results of a sorted radius search whose names are read with one cursor sweep
+
 	VectorStorageClient( const DatabaseInterface* database_, const std::string& configstring_, ErrorBufferInterface* errorhnd_);
 
 	virtual ~VectorStorageClient();
@@ -71,6 +132,15 @@ public:
 	virtual void close();
 
 	virtual void compaction();
+
+public:/*VectorStorageSearchInterface*/
+	virtual int nofSearchersCreated() const;
+	virtual VectorQueryResultCacheStatistics queryResultCacheStatistics() const;
+	virtual int findSimilarWithinRadius( VectorQueryResultConsumerInterface& consumer, const std::string& type, const WordVector& vec, double minSimilarity, double speedRecallFactor, bool realVecWeights, bool sorted) const;
+	virtual VectorSearchRestrictionInterface* createSearchRestriction( const std::vector<std::string>& features) const;
+	virtual std::vector<VectorQueryResult> findSimilarRestricted( const std::string& type, const WordVector& vec, const VectorSearchRestrictionInterface& restriction, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const;
+	virtual std::vector<std::vector<VectorQueryResult> > findSimilarMulti( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const;
+	virtual std::vector<VectorQueryTypedResult> findSimilarMultiMerged( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const;
 	
 public:/*VectorStorageTransaction*/
 	friend class TransactionLock;
@@ -94,8 +164,60 @@ public:/*VectorStorageTransaction*/
 	{
 		return m_model;
 	}
+	/// \brief Get the number of threads to use for calculating the LSH values of the vectors of a transaction
+	unsigned int nofThreads() const
+	{
+		return m_nofThreads;
+	}
+	/// \brief Get the memory budget in bytes of a transaction before it writes its defined vectors as partial batch to the database transaction (0 for no limit)
+	std::size_t transactionMemoryBudget() const
+	{
+		return m_transactionMemoryBudget;
+	}
 
-	void resetSimHashMapTypes( const std::vector<std::string>& types_);
+	/// \brief Remove the searchers of types changed by a commit, called before and after the commit of the database transaction
+	/// \param[in] cleared true if the storage has been cleared by the commit and all searchers are removed
+	void resetSimHashMapTypes( const std::vector<std::string>& types_, bool cleared);
+	/// \brief Remove the cached search results of types changed by a commit
+	/// \param[in] cleared true if the storage has been cleared by the commit and all cached results are removed
+	void resetQueryResultCacheTypes( const std::vector<std::string>& types_, bool cleared);
+
+	friend class AllocationLock;
+	/// \brief Lock for the critical section of the lookup and allocation of type and feature numbers
+	class AllocationLock
+	{
+	public:
+		AllocationLock( VectorStorageClient* storage_)
+			:m_mutex(&storage_->m_allocation_mutex)
+		{
+			m_mutex->lock();
+		}
+		~AllocationLock()
+		{
+			m_mutex->unlock();
+		}
+
+	private:
+		strus::mutex* m_mutex;
+	};
+	/// \brief Raise the allocation counters to the counters committed in the database, to be called at the start of every allocation round
+	/// \note Call only with an AllocationLock held
+	void syncAllocationCounters();
+	/// \brief Get the number of a type or allocate a new one
+	/// \note Call only with an AllocationLock held
+	/// \param[out] isAllocated true if the type is not in the database yet and the transaction has to write its keys
+	/// \param[in] acquire true if the calling transaction does not hold a reference on the pending allocation of the type yet and takes one if isAllocated is returned as true
+	Index getOrAllocateTypeno( const std::string& type, bool& isAllocated, bool acquire);
+	/// \brief Get the number of a feature or allocate a new one
+	/// \note Call only with an AllocationLock held
+	/// \param[out] isAllocated true if the feature is not in the database yet and the transaction has to write its keys
+	/// \param[in] acquire true if the calling transaction does not hold a reference on the pending allocation of the feature yet and takes one if isAllocated is returned as true
+	Index getOrAllocateFeatno( const std::string& feature, bool& isAllocated, bool acquire);
+	/// \brief Release the references of a transaction on pending allocations of types and features after its commit made them visible in the database or after it failed or was rolled back
+	/// \note A pending allocation is forgotten when no transaction holds a reference on it anymore
+	void releaseAllocatedNames( const std::set<std::string>& types_, const std::set<std::string>& features_);
+	/// \brief Reset the allocation of type and feature numbers after the storage has been cleared
+	void resetAllocation();
 
 public:/*SentenceLexerContext*/
 	std::vector<std::string> getTypeNames( const strus::Index& featno) const;
@@ -105,24 +227,97 @@ public:/*SentenceLexerContext*/
 	WordVector getVector( const strus::Index& typeno, const strus::Index& featno) const;
 	std::string getTypeNameFromIndex( const Index& typeno) const;
 	std::string getFeatNameFromIndex( const Index& featno) const;
+	/// \brief Get the names of a list of features with one ordered scan, in the order of the list
+	std::vector<std::string> getFeatNamesFromIndex( const std::vector<Index>& featnolist) const;
 
 private:
+	friend class RadiusSearchResultConsumer;
+	friend class MultiTypeSearchContext;
+	/// \brief Get the searcher of a type, create it if it does not exist yet
+	/// \note Concurrent calls for the same type not created yet are coalesced, only the first one creates the searcher, the others wait for it
 	strus::Reference<SimHashMap> getOrCreateTypeSimHashMap( const std::string& type) const;
 	strus::Reference<SimHashMap> getSimHashMap( const std::string& type) const;
+	/// \brief Create the searcher of a type, loading its LSH values
+	strus::Reference<SimHashMap> createTypeSimHashMap( const std::string& type) const;
+	typedef strus::Reference<SimHashMap> SimHashMapRef;
+	/// \brief State of the creation of a searcher, shared by the thread creating it and the threads waiting for it
+	struct SimHashMapBuild
+	{
+		bool finished;			///< true if the creation is finished and result or error is set
+		bool invalidated;		///< true if the type has been reset by a commit during the creation, the result is not published then
+		SimHashMapRef result;		///< the searcher created
+		std::string error;		///< error message if the creation failed
+
+		SimHashMapBuild()
+			:finished(false),invalidated(false),result(),error(){}
+	};
+	typedef strus::Reference<SimHashMapBuild> SimHashMapBuildRef;
+	/// \brief Publish the result of the creation of a searcher and wake up the threads waiting for it
+	void finishSimHashMapBuild( const std::string& type, SimHashMapBuildRef& build, const SimHashMapRef& result, const std::string& error) const;
+	void getSearchDistances( int& simdist, int& probsimdist, double minSimilarity, double speedRecallFactor) const;
+	std::vector<SimHashQueryResult> searchSimHashMap( const SimHashMap& simHashMap, const SimHash& needle, const WordVector& vec, const SimHashSlotSet* slotFilter, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights, SimHashMap::Stats* stats) const;
+	/// \brief Search multiple types with the calling thread and the threads of the search pool
+	std::vector<std::vector<SimHashQueryResult> > searchMultiTypes( const std::vector<std::string>& types, const WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const;
+	std::vector<VectorQueryResult> findSimilarImpl( const std::string& type, const WordVector& vec, const VectorSearchRestriction* restriction, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights) const;
 	std::vector<VectorQueryResult> simHashToVectorQueryResults( const std::vector<SimHashQueryResult>& res, int maxNofResults, double minSimilarity) const;
+	/// \brief Buffers of the reranking with the vectors read from the database, owned by the caller and reused for all chunks of results of a search
+	struct RerankBuffer
+	{
+		std::vector<Index> featnolist;		///< feature numbers of the results sorted
+		std::vector<WordVector> vecar;		///< vectors read in the order of featnolist
+
+		RerankBuffer()
+			:featnolist(),vecar(){}
+	};
+	void rerankWithRealWeights( std::vector<SimHashQueryResult>& res, const SimHashMap& simHashMap, const WordVector& vec, RerankBuffer& buf) const;
+	void rerankWithProductQuantizer( std::vector<SimHashQueryResult>& res, const ProductQuantizer& productQuantizer, const WordVector& vec) const;
 
 private:
+	enum {DefaultProductQuantizerSubspaceDim=4};			///< default dimension of a subspace of product quantization
+
 	ErrorBufferInterface* m_errorhnd;
 	DebugTraceContextInterface* m_debugtrace;
 	Reference<DatabaseAdapter> m_database;
 	LshModel m_model;
-	typedef strus::Reference<SimHashMap> SimHashMapRef;
 	typedef std::map<std::string,SimHashMapRef> SimHashMapMap;
 	typedef strus::Reference<SimHashMapMap> SimHashMapMapRef;
-	mutable strus::Reference<SimHashMapMap> m_simHashMapMap;
+	mutable strus::Reference<SimHashMapMap> m_simHashMapMap;	///< snapshot of the searchers created, replaced (copy on write) with m_simHashMap_mutex held
+	typedef std::map<std::string,SimHashMapBuildRef> SimHashMapBuildMap;
+	mutable SimHashMapBuildMap m_simHashMapBuilds;			///< creations of searchers in progress
+	mutable strus::mutex m_simHashMap_mutex;			///< mutual exclusion in the access of the searchers created and in progress
+	mutable strus::condition_variable m_simHashMap_cond;		///< signals the end of the creation of a searcher
+	mutable int m_nofSimHashMapsCreated;				///< number of searchers created, incremented with m_simHashMap_mutex held
+	Reference<QueryResultCache> m_queryResultCache;			///< cache of the results of searches or NULL
+	Reference<SearchWorkerPool> m_searchWorkerPool;			///< threads searching the types of a search over multiple types in parallel or NULL
 	std::vector<std::string> m_inMemoryTypes;			///< cached types
+	std::vector<std::string> m_inMemoryVectorTypes;			///< types with vectors cached for reranking
+	std::vector<std::string> m_productQuantizedTypes;		///< types with product quantized vectors cached for approximate reranking
+	int m_nofProductQuantizerSubspaces;				///< number of subspaces (bytes per vector) of product quantization
+	TopKSelectMethod m_topKMethod;					///< method used for selecting the best k elements in a search
+	unsigned int m_nofThreads;					///< number of threads used for calculating LSH values in a commit (0 for none)
+	std::size_t m_transactionMemoryBudget;				///< memory budget in bytes of a transaction before writing a partial batch (0 for no limit)
 	SentenceLexerConfig m_lexerConfig;				///< sentence lexer configuration
 	strus::mutex m_transaction_mutex;				///< mutual exclusion in the critical part of a transaction
+	strus::mutex m_allocation_mutex;				///< mutual exclusion in the allocation of type and feature numbers
+	Index m_nofTypenoAllocated;					///< biggest type number allocated
+	Index m_nofFeatnoAllocated;					///< biggest feature number allocated
+	/// \brief Number allocated for a type or feature with the number of transactions referencing it
+	struct PendingAllocation
+	{
+		Index no;
+		int refcnt;
+
+		PendingAllocation()
+			:no(0),refcnt(0){}
+		PendingAllocation( const Index& no_, int refcnt_)
+			:no(no_),refcnt(refcnt_){}
+	};
+	typedef std::map<std::string,PendingAllocation> PendingAllocationMap;
+	/// \brief Release the references on pending allocations of names
+	static void releasePendingAllocations( PendingAllocationMap& map, const std::set<std::string>& names);
+
+	PendingAllocationMap m_allocatedTypenoMap;			///< types allocated, but not yet known to be committed
+	PendingAllocationMap m_allocatedFeatnoMap;			///< features allocated, but not yet known to be committed
 };
 
 }//namespace
@@ -14,6 +14,7 @@
 #include "strus/errorBufferInterface.hpp"
 #include "strus/base/string_conv.hpp"
 #include <algorithm>
+#include <iterator>
 
 #define MODULENAME   "vector storage"
 #define STRUS_DBGTRACE_COMPONENT_NAME "vector"
@@ -26,7 +27,9 @@ VectorStorageTransaction::VectorStorageTransaction(
 		ErrorBufferInterface* errorhnd_)
 	:m_errorhnd(errorhnd_),m_debugtrace(0),m_storage(storage_)
 	,m_database(database_),m_transaction(database_->createTransaction())
-	,m_vecar(),m_typetab(errorhnd_),m_nametab(errorhnd_),m_featTypeRelations()
+	,m_vecar(),m_typetab(errorhnd_),m_nametab(errorhnd_),m_featTypeRelations(),m_vecdim(storage_->model().vecdim()),m_cleared(false)
+	,m_memUsage(0),m_memBudget(storage_->transactionMemoryBudget())
+	,m_typeFeatnoMap(),m_typeSimHashMap(),m_relations(),m_typeNames(),m_newTypes(),m_newFeatures(),m_maxTypeno(0),m_maxFeatno(0)
 {
 	if (errorhnd_->hasError())
 	{
@@ -38,9 +41,25 @@ VectorStorageTransaction::VectorStorageTransaction(
 
 VectorStorageTransaction::~VectorStorageTransaction()
 {
+	try
+	{
+		// ... the names allocated by a transaction neither committed nor rolled back are released
+		releaseAllocatedNames();
+	}
+	catch (...){}
 	if (m_debugtrace) delete m_debugtrace;
 }
 
+void VectorStorageTransaction::releaseAllocatedNames()
+{
+	if (!m_newTypes.empty() || !m_newFeatures.empty())
+	{
+		m_storage->releaseAllocatedNames( m_newTypes, m_newFeatures);
+		m_newTypes.clear();
+		m_newFeatures.clear();
+	}
+}
+
 int VectorStorageTransaction::defineType( const std::string& type)
 {
 	StringConvError err = StringConvOk;
@@ -64,16 +83,24 @@ void VectorStorageTransaction::defineElement( const std::string& type, const std
 	int fid = m_nametab.getOrCreate(strus::utf8clean( name, err));
 	if (err != StringConvOk) throw strus::stringconv_exception( err);
 	if (fid <= 0) throw strus::runtime_error( _TXT("failed to get or create feature identifier: %s"), m_errorhnd->fetchError());
-	if (vec.empty())
+	if (!vec.empty())
 	{
-		m_vecar[ tidx].push_back( VectorDef( fid));
+		if ((int)vec.size() != m_vecdim)
+		{
+			throw strus::runtime_error( _TXT("vector must have dimension of model: dim=%d != vector=%d"), m_vecdim, (int)vec.size());
+		}
+		// ... the LSH value is calculated for all vectors together in the commit or when a batch is written
+		m_vecar[ tidx].push_back( VectorDef( vec, fid));
+		m_memUsage += vec.size() * sizeof(float);
 	}
-	else
+	m_featTypeRelations.push_back( FeatureTypeRelation( fid, tid));
+	m_memUsage += name.size() + ElementMemOverhead;
+	if (m_errorhnd->hasError()) throw std::runtime_error( m_errorhnd->fetchError());
+
+	if (m_memBudget && m_memUsage > m_memBudget)
 	{
-		m_vecar[ tidx].push_back( VectorDef( vec, m_storage->model().simHash( vec, fid), fid));
+		writeBatch();
 	}
-	m_featTypeRelations.insert( FeatureTypeRelation( fid, tid));
-	if (m_errorhnd->hasError()) throw std::runtime_error( m_errorhnd->fetchError());
 }
 
 void VectorStorageTransaction::defineFeatureType( const std::string& type)
@@ -120,7 +147,13 @@ void VectorStorageTransaction::clear()
 {
 	try
 	{
+		// ... the definitions made before are dropped, no matter if they have already been written in a batch or not
+		m_transaction->rollback();
+		m_transaction.reset( m_database->createTransaction());
+		releaseAllocatedNames();
+		reset();
 		m_transaction->clear();
+		m_cleared = true;
 	}
 	CATCH_ERROR_ARG1_MAP( _TXT("error clearing data to '%s': %s"), MODULENAME, *m_errorhnd);
 }
@@ -131,91 +164,263 @@ void VectorStorageTransaction::reset()
 	m_nametab.clear();
 	m_typetab.clear();
 	m_featTypeRelations.clear();
+	m_cleared = false;
+	m_memUsage = 0;
+	m_typeFeatnoMap.clear();
+	m_typeSimHashMap.clear();
+	m_relations.clear();
+	m_typeNames.clear();
+	m_newTypes.clear();
+	m_newFeatures.clear();
+	m_maxTypeno = 0;
+	m_maxFeatno = 0;
 }
 
-bool VectorStorageTransaction::commit()
+void VectorStorageTransaction::calculateSimHashValues()
 {
-	try
+	LshModel model = m_storage->model();
+	unsigned int threads = m_storage->nofThreads();
+
+	std::vector<std::vector<VectorDef> >::iterator vvi = m_vecar.begin(), vve = m_vecar.end();
+	for (; vvi != vve; ++vvi)
 	{
-		VectorStorageClient::TransactionLock lock( m_storage);
-		//... we need a lock because transactions need to be sequentialized
+		std::vector<VectorDef>& var = *vvi;
+		if (var.empty()) continue;
 
-		Index noftypeno = m_database->readNofTypeno();
-		Index noffeatno = m_database->readNofFeatno();
-		std::set<Index> newtypes;
-		std::vector<std::string> typestrings;
-		std::vector<int> types;
+		std::vector<SimHash> lshar = strus::getSimhashValues( model, var, var.size() < MinNofVectorsThreaded ? 0 : threads, m_errorhnd);
+		if (lshar.size() != var.size()) throw std::runtime_error(_TXT("logic error in vector transaction: array sizes do not match"));
+
+		std::vector<VectorDef>::iterator vi = var.begin(), ve = var.end();
+		std::vector<SimHash>::const_iterator li = lshar.begin();
+		for (; vi != ve; ++vi,++li)
 		{
-			int ti=1, te=m_typetab.size();
-			for (; ti <= te; ++ti)
+			vi->setLsh( *li);
+		}
+	}
+}
+
+void VectorStorageTransaction::writeBatch()
+{
+	// ... the LSH values are calculated outside the critical section
+	calculateSimHashValues();
+
+	std::vector<int> types;
+	std::vector<int> features;
+	{
+		VectorStorageClient::AllocationLock lock( m_storage);
+		//... only the lookup and allocation of type and feature numbers has to be sequentialized here
+
+		m_storage->syncAllocationCounters();
+		int ti=1, te=m_typetab.size();
+		for (; ti <= te; ++ti)
+		{
+			const char* typestr = m_typetab.key( ti);
+			bool isAllocated = false;
+			bool isHeld = (m_newTypes.find( typestr) != m_newTypes.end());
+			Index typeno = m_storage->getOrAllocateTypeno( typestr, isAllocated, !isHeld);
+			if (isAllocated && m_typeNames.find( typestr) == m_typeNames.end())
 			{
-				const char* typestr = m_typetab.key( ti);
-				Index typeno = m_database->readTypeno( typestr);
-				if (!typeno)
-				{
-					typeno = ++noftypeno;
-					m_transaction->writeType( typestr, typeno);
-					newtypes.insert( typeno);
-				}
-				types.push_back( typeno);
-				typestrings.push_back( typestr);
+				m_transaction->writeType( typestr, typeno);
+			}
+			if (isAllocated && !isHeld)
+			{
+				m_newTypes.insert( typestr);
+			}
+			if (typeno > m_maxTypeno) m_maxTypeno = typeno;
+			types.push_back( typeno);
+			m_typeNames.insert( typestr);
+		}
+		int ni=1, ne=m_nametab.size();
+		for (; ni <= ne; ++ni)
+		{
+			const char* featstr = m_nametab.key( ni);
+			bool isAllocated = false;
+			bool isHeld = (m_newFeatures.find( featstr) != m_newFeatures.end());
+			Index featno = m_storage->getOrAllocateFeatno( featstr, isAllocated, !isHeld);
+			if (isAllocated)
+			{
+				// ... a feature allocated by a previous batch of this transaction is written again, the write is idempotent
+				m_transaction->writeFeature( featstr, featno);
+				if (!isHeld) m_newFeatures.insert( featstr);
 			}
+			if (featno > m_maxFeatno) m_maxFeatno = featno;
+			features.push_back( featno);
 		}
-		if (types.size() != m_vecar.size()) throw std::runtime_error(_TXT("logic error in vector transaction: array sizes do not match"));
+	}
+	if (m_errorhnd->hasError()) throw std::runtime_error( m_errorhnd->fetchError());
+	if (types.size() != m_vecar.size()) throw std::runtime_error(_TXT("logic error in vector transaction: array sizes do not match"));
 
-		std::vector<int> features;
+	// ... the vectors and LSH values are written and sorted outside the critical section
+	bool simHashLayoutBlock = (m_database->simHashLayout() == SimHashLayoutBlock);
+	std::vector<int>::const_iterator ti = types.begin(), te = types.end();
+	std::vector<std::vector<VectorDef> >::iterator vvi = m_vecar.begin(), vve = m_vecar.end();
+	for (; ti != te && vvi != vve; ++vvi,++ti)
+	{
+		const Index typeno = *ti;
+		std::vector<Index>& featnolist = m_typeFeatnoMap[ typeno];
+		std::vector<SimHash>* lshlist = simHashLayoutBlock ? &m_typeSimHashMap[ typeno] : 0;
+		std::vector<VectorDef>& var = *vvi;
+		featnolist.reserve( featnolist.size() + var.size());
+		std::vector<VectorDef>::iterator vi = var.begin(), ve = var.end();
+		for (; vi != ve; ++vi)
 		{
-			int ni=1, ne=m_nametab.size();
-			for (; ni <= ne; ++ni)
+			// ... only features defined with a vector have a vector definition (see defineElement)
+			Index featno = features[ vi->id()-1];
+			vi->setId( featno);
+			featnolist.push_back( featno);
+			m_transaction->writeVector( typeno, featno, vi->vec());
+			if (lshlist)
+			{
+				lshlist->push_back( vi->lsh());
+				lshlist->back().setId( featno);
+			}
+			else
 			{
-				const char* featstr = m_nametab.key( ni);
-				Index featno = m_database->readFeatno( featstr);
-				if (!featno)
+				m_transaction->writeSimHash( typeno, featno, vi->lsh());
+			}
+		}
+	}
+	// ... the relations of the batch are appended as sorted run with the type and feature numbers
+	std::sort( m_featTypeRelations.begin(), m_featTypeRelations.end());
+	std::size_t runstart = m_relations.size();
+	std::vector<FeatureTypeRelation>::const_iterator ri = m_featTypeRelations.begin(), re = m_featTypeRelations.end();
+	for (; ri != re; ++ri)
+	{
+		if (ri != m_featTypeRelations.begin() && ri->featno == (ri-1)->featno && ri->typeno == (ri-1)->typeno) continue;
+		m_relations.push_back( FeatureTypeRelation( features[ ri->featno-1], types[ ri->typeno-1]));
+	}
+	std::sort( m_relations.begin() + runstart, m_relations.end());
+	m_transaction->flushWrites();
+
+	m_vecar.clear();
+	m_nametab.clear();
+	m_typetab.clear();
+	m_featTypeRelations.clear();
+	m_memUsage = 0;
+	if (m_debugtrace) m_debugtrace->event( "batch", "types %d features %d", (int)types.size(), (int)features.size());
+}
+
+struct SimHashIdOrder
+{
+	bool operator()( const SimHash& a, const SimHash& b) const
+	{
+		return a.id() < b.id();
+	}
+};
+
+void VectorStorageTransaction::writeSimHashBlocks()
+{
+	std::map<Index,std::vector<SimHash> >::iterator si = m_typeSimHashMap.begin(), se = m_typeSimHashMap.end();
+	for (; si != se; ++si)
+	{
+		const Index typeno = si->first;
+		std::vector<SimHash>& lshlist = si->second;
+		// ... the stable sort keeps the order of definition, the last definition of a feature wins
+		std::stable_sort( lshlist.begin(), lshlist.end(), SimHashIdOrder());
+
+		std::vector<SimHash>::const_iterator li = lshlist.begin(), le = lshlist.end();
+		while (li != le)
+		{
+			const Index blockno = DatabaseAdapter::simHashBlockno( li->id());
+			std::vector<SimHash> existing;
+			if (!m_cleared)
+			{
+				existing = m_database->readSimHashBlock( typeno, blockno);
+			}
+			std::vector<SimHash> block;
+			block.reserve( existing.size() + DatabaseAdapter::SimHashBlockSize);
+			std::vector<SimHash>::const_iterator ei = existing.begin(), ee = existing.end();
+			for (; li != le && DatabaseAdapter::simHashBlockno( li->id()) == blockno; ++li)
+			{
+				if ((li+1) != le && (li+1)->id() == li->id()) continue;
+				for (; ei != ee && ei->id() < li->id(); ++ei)
 				{
-					featno = ++noffeatno;
-					m_transaction->writeFeature( featstr, featno);
+					block.push_back( *ei);
 				}
-				features.push_back( featno);
+				if (ei != ee && ei->id() == li->id()) ++ei;
+				block.push_back( *li);
 			}
+			block.insert( block.end(), ei, ee);
+			m_transaction->writeSimHashBlock( typeno, blockno, block);
+		}
+	}
+}
+
+void VectorStorageTransaction::calculateTypeVectorUpdate( TypeVectorUpdate& update, const Index& typeno, const std::vector<Index>& featnolist) const
+{
+	// ... count the new vectors by probing the keys of the existing ones in one sorted sweep
+	// ... a type allocated by this transaction may already have vectors committed by a concurrent one
+	// ... a transaction clearing the storage counts from zero, the vectors stored are deleted by it
+	update.nofVectors = m_cleared ? 0 : m_database->readNofVectors( typeno);
+	std::vector<Index> existing;
+	if (update.nofVectors) existing = m_database->readFeatnosWithVector( typeno, featnolist);
+
+	// ... the position markers of the type are calculated with the features inserted
+	update.inserted.clear();
+	update.inserted.reserve( featnolist.size() - existing.size());
+	std::set_difference( featnolist.begin(), featnolist.end(), existing.begin(), existing.end(), std::back_inserter( update.inserted));
+	update.samples = m_database->calculateFeatnoSamples( typeno, update.inserted, m_cleared);
+}
+
+bool VectorStorageTransaction::commit()
+{
+	try
+	{
+		writeBatch();
+
+		// ... the vector counts and the position markers are calculated outside the critical section from the vectors committed,
+		// ... the walk over the features of a type for the markers may visit most of the type
+		std::map<Index,TypeVectorUpdate> typeVectorUpdates;
+		std::map<Index,std::vector<Index> >::iterator fi = m_typeFeatnoMap.begin(), fe = m_typeFeatnoMap.end();
+		for (; fi != fe; ++fi)
+		{
+			std::vector<Index>& featnolist = fi->second;
+			std::sort( featnolist.begin(), featnolist.end());
+			featnolist.erase( std::unique( featnolist.begin(), featnolist.end()), featnolist.end());
+			calculateTypeVectorUpdate( typeVectorUpdates[ fi->first], fi->first, featnolist);
 		}
+
+		VectorStorageClient::TransactionLock lock( m_storage);
+		//... we need a lock for the counters and relations because their updates are read-modify-write operations
+
+		Index noftypeno = m_database->readNofTypeno();
+		Index noffeatno = m_database->readNofFeatno();
+		if (noftypeno < m_maxTypeno) noftypeno = m_maxTypeno;
+		if (noffeatno < m_maxFeatno) noffeatno = m_maxFeatno;
 		m_transaction->writeNofTypeno( noftypeno);
 		m_transaction->writeNofFeatno( noffeatno);
 
-		std::vector<int>::const_iterator ti = types.begin(), te = types.end();
-		std::vector<std::vector<VectorDef> >::iterator vvi = m_vecar.begin(), vve = m_vecar.end();
-		for (; ti != te && vvi != vve; ++vvi,++ti)
+		for (fi = m_typeFeatnoMap.begin(); fi != fe; ++fi)
 		{
-			const Index typeno = *ti;
-			Index nofvec = newtypes.find( typeno) == newtypes.end() ? m_database->readNofVectors( typeno) : 0;
-			std::set<Index> featset;
-			std::vector<VectorDef>& var = *vvi;
-			std::vector<VectorDef>::iterator vi = var.begin(), ve = var.end();
-			for (; vi != ve; ++vi)
+			// ... every commit inserting vectors of a type changes its vector count, the update is recalculated
+			// ... in the critical section only for the types with vectors committed concurrently since its calculation
+			const Index typeno = fi->first;
+			TypeVectorUpdate& update = typeVectorUpdates[ typeno];
+			if (!m_cleared && m_database->readNofVectors( typeno) != update.nofVectors)
 			{
-				Index featno = features[ vi->id()-1];
-				vi->setId( featno);
-				if (!vi->vec().empty())
-				{
-					if (m_database->readVector( typeno, featno).empty())
-					{
-						// ... is new vector
-						featset.insert( featno);
-					}
-					m_transaction->writeVector( typeno, featno, vi->vec());
-					m_transaction->writeSimHash( typeno, featno, vi->lsh());
-				}
+				calculateTypeVectorUpdate( update, typeno, fi->second);
 			}
-			m_transaction->writeNofVectors( typeno, nofvec + featset.size());
+			m_transaction->writeNofVectors( typeno, update.nofVectors + update.inserted.size());
+			std::vector<DatabaseAdapter::FeatnoSample>::const_iterator si = update.samples.begin(), se = update.samples.end();
+			for (; si != se; ++si)
+			{
+				m_transaction->writeFeatnoSample( typeno, si->sampleidx, si->featno);
+			}
+		}
+		if (!m_typeSimHashMap.empty())
+		{
+			writeSimHashBlocks();
 		}
-		std::set<FeatureTypeRelation>::const_iterator ri = m_featTypeRelations.begin(), re = m_featTypeRelations.end();
+		// ... merge the sorted runs of relations of all batches
+		std::sort( m_relations.begin(), m_relations.end());
+		std::vector<FeatureTypeRelation>::const_iterator ri = m_relations.begin(), re = m_relations.end();
 		while (ri != re)
 		{
-			Index featnoidx = ri->featno;
-			Index featno = features[ featnoidx-1];
+			Index featno = ri->featno;
 			std::vector<Index> typenoar = m_database->readFeatureTypeRelations( featno);
-			for (; ri != re && ri->featno == featnoidx; ++ri)
+			for (; ri != re && ri->featno == featno; ++ri)
 			{
-				Index typeno = types[ ri->typeno-1];
+				Index typeno = ri->typeno;
 				if (std::find( typenoar.begin(), typenoar.end(), typeno) == typenoar.end())
 				{
 					typenoar.push_back( typeno);
@@ -223,15 +428,29 @@ bool VectorStorageTransaction::commit()
 			}
 			m_transaction->writeFeatureTypeRelations( featno, typenoar);
 		}
-		m_storage->resetSimHashMapTypes( typestrings);
+		std::vector<std::string> typestrings( m_typeNames.begin(), m_typeNames.end());
+		m_storage->resetSimHashMapTypes( typestrings, m_cleared);
 		if (m_transaction->commit())
 		{
 			if (m_debugtrace) m_debugtrace->event( "commit", "types %d features %d", noftypeno, noffeatno);
+			// ... a searcher created between the reset above and the commit has loaded the values before the commit, it is reset again
+			m_storage->resetSimHashMapTypes( typestrings, m_cleared);
+			m_storage->resetQueryResultCacheTypes( typestrings, m_cleared);
+			if (m_cleared)
+			{
+				m_storage->resetAllocation();
+			}
+			else
+			{
+				releaseAllocatedNames();
+			}
 			reset();
 			return true;
 		}
 		else
 		{
+			releaseAllocatedNames();
+			reset();
 			return false;
 		}
 	}
@@ -244,6 +463,7 @@ void VectorStorageTransaction::rollback()
 	{
 		m_transaction->rollback();
 		if (m_debugtrace) m_debugtrace->event( "rollback", "%s", "");
+		releaseAllocatedNames();
 		reset();
 	}
 	CATCH_ERROR_ARG1_MAP( _TXT("error in rollback of '%s' transaction: %s"), MODULENAME, *m_errorhnd);
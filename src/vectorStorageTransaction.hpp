@@ -40,6 +40,8 @@ public:
 
 	virtual void defineFeature( const std::string& type, const std::string& name);
 
+	/// \brief Clear the storage with the commit of this transaction
+	/// \note All definitions made in this transaction before the call are dropped, the same with or without a memory budget (txmem)
 	virtual void clear();
 
 	virtual bool commit();
@@ -49,7 +51,38 @@ public:
 private:
 	int defineType( const std::string& type);
 	void defineElement( const std::string& type, const std::string& name, const WordVector& vec);
+	/// \brief Calculate the LSH values of all vectors defined, with multiple threads if configured
+	void calculateSimHashValues();
+	/// \brief Write the vectors defined since the last batch to the database transaction and release their memory
+	/// \note The counters, the vector counts and the relations are written by the commit, so the transaction stays atomic
+	/// \note The memory budget bounds only the vectors and names defined since the last batch. The bookkeeping needed by the commit
+	///		is kept for the whole transaction and grows linearly with the number of features written: about 8 bytes per relation
+	///		and 4 bytes per vector, the LSH values of the layout SimHashLayoutBlock and the names of the features allocated
+	///		(also kept in the storage client until the commit). The relation runs are sorted as a whole in the commit.
+	void writeBatch();
+	/// \brief Merge the LSH values written into the blocks of the layout SimHashLayoutBlock, called in the critical section of the commit
+	void writeSimHashBlocks();
 	void reset();
+	/// \brief Forget the types and features allocated by this transaction in the storage client, after its commit, failure or rollback
+	void releaseAllocatedNames();
+
+	/// \brief Update of the vector count and the position markers of a type by a commit
+	struct TypeVectorUpdate
+	{
+		Index nofVectors;					///< number of vectors committed the update is calculated for
+		std::vector<Index> inserted;				///< features with a vector not committed yet, sorted
+		std::vector<DatabaseAdapter::FeatnoSample> samples;	///< position markers to write
+
+		TypeVectorUpdate()
+			:nofVectors(0),inserted(),samples(){}
+	};
+	/// \brief Calculate the update of the vector count and the position markers of a type from the vectors committed
+	/// \param[in] featnolist features with a vector written by this transaction, sorted and unique
+	void calculateTypeVectorUpdate( TypeVectorUpdate& update, const Index& typeno, const std::vector<Index>& featnolist) const;
+
+private:
+	enum {MinNofVectorsThreaded=256};		///< minimum number of vectors of a type for using threads in the LSH value calculation
+	enum {ElementMemOverhead=64};			///< estimated memory in bytes used by a defined element besides its vector and name
 
 private:
 	ErrorBufferInterface* m_errorhnd;
@@ -78,7 +111,20 @@ private:
 		}
 	};
 
-	std::set<FeatureTypeRelation> m_featTypeRelations;
+	std::vector<FeatureTypeRelation> m_featTypeRelations;	///< relations defined since the last batch with the indices of the symbol tables
+	int m_vecdim;
+	bool m_cleared;
+
+	std::size_t m_memUsage;					///< estimated memory in bytes used by the elements defined since the last batch
+	std::size_t m_memBudget;				///< memory budget triggering a write of a batch (0 for no limit)
+	std::map<Index,std::vector<Index> > m_typeFeatnoMap;	///< features with a vector written per type
+	std::map<Index,std::vector<SimHash> > m_typeSimHashMap;	///< LSH values written per type in the layout SimHashLayoutBlock, merged into their blocks in the commit
+	std::vector<FeatureTypeRelation> m_relations;		///< relations written with the numbers of types and features, appended as sorted runs
+	std::set<std::string> m_typeNames;			///< names of the types written
+	std::set<std::string> m_newTypes;			///< pending types allocated, this transaction holds a reference on
+	std::set<std::string> m_newFeatures;			///< pending features allocated, this transaction holds a reference on
+	Index m_maxTypeno;					///< biggest type number used
+	Index m_maxFeatno;					///< biggest feature number used
 };
 
 }//namespace
@@ -0,0 +1,195 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Program writing a binary dump of a vector storage or restoring a vector storage from it
+#include "vectorStorageBinaryDump.hpp"
+#include "frozenStorage.hpp"
+#include "strus/lib/database_leveldb.hpp"
+#include "strus/lib/error.hpp"
+#include "strus/lib/filelocator.hpp"
+#include "strus/databaseInterface.hpp"
+#include "strus/databaseClientInterface.hpp"
+#include "strus/fileLocatorInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/base/local_ptr.hpp"
+#include "strus/base/string_format.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+
+static void printUsage()
+{
+	std::cerr << "usage: strusVectorDump [options] <dumpfile>" << std::endl;
+	std::cerr << "description: Write all key/value pairs of a vector storage to a binary dump file" << std::endl;
+	std::cerr << "    or restore a vector storage from a binary dump file (option -R)" << std::endl;
+	std::cerr << "    or write a frozen storage file served read only without the database (option -Z)." << std::endl;
+	std::cerr << "    <dumpfile>  :path of the dump file to write or to read with option -R or of the frozen storage file to write with option -Z" << std::endl;
+	std::cerr << "    options     :" << std::endl;
+	std::cerr << "    -h          : print this usage" << std::endl;
+	std::cerr << "    -s <CONFIG> : specify the configuration string of the database of the vector storage as <CONFIG>" << std::endl;
+	std::cerr << "    -R          : restore the vector storage from the dump, the database is created and must not exist" << std::endl;
+	std::cerr << "    -Z          : write a frozen storage file, to be opened with the vector storage client configuration frozen=<dumpfile>" << std::endl;
+	std::cerr << "    -T <THREADS>: use <THREADS> threads for dumping the key ranges or committing the frames of the dump" << std::endl;
+	std::cerr << "    -F <SIZE>   : close a frame of the dump at <SIZE> bytes, default " << (int)strus::VectorBinaryDumpConfig::DefaultFrameSize << std::endl;
+	std::cerr << "    -U          : write the keys of the dump uncompressed, without eliding the prefix shared with the previous key" << std::endl;
+}
+
+static int parsePositiveIntegerArgument( const char* arg, const char* option)
+{
+	int rt = atoi( arg);
+	if (rt <= 0) throw std::runtime_error( strus::string_format( "option %s needs positive integer number as argument", option));
+	return rt;
+}
+
+int main( int argc, const char** argv)
+{
+	strus::local_ptr<strus::ErrorBufferInterface> errorhnd;
+	try
+	{
+		if (argc <= 1)
+		{
+			std::cerr << "too few arguments" << std::endl;
+			printUsage();
+			return 0;
+		}
+		int argi = 1;
+		bool doRestore = false;
+		bool doFreeze = false;
+		std::string databaseConfig;
+		strus::VectorBinaryDumpConfig dumpConfig;
+
+		for (; argi < argc; ++argi)
+		{
+			if (std::strcmp( argv[ argi], "-h") == 0 || std::strcmp( argv[ argi], "--help") == 0)
+			{
+				printUsage();
+				return 0;
+			}
+			else if (std::strcmp( argv[ argi], "-R") == 0 || std::strcmp( argv[ argi], "--restore") == 0)
+			{
+				doRestore = true;
+			}
+			else if (std::strcmp( argv[ argi], "-Z") == 0 || std::strcmp( argv[ argi], "--freeze") == 0)
+			{
+				doFreeze = true;
+			}
+			else if (std::strcmp( argv[ argi], "-U") == 0 || std::strcmp( argv[ argi], "--uncompressed") == 0)
+			{
+				dumpConfig.compress = false;
+			}
+			else if (std::strcmp( argv[ argi], "-s") == 0 || std::strcmp( argv[ argi], "--storage") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -s (database configuration) expects argument");
+				databaseConfig = argv[argi];
+			}
+			else if (std::strcmp( argv[ argi], "-T") == 0 || std::strcmp( argv[ argi], "--threads") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -T (threads) expects argument");
+				dumpConfig.threads = parsePositiveIntegerArgument( argv[argi], "-T (threads)");
+			}
+			else if (std::strcmp( argv[ argi], "-F") == 0 || std::strcmp( argv[ argi], "--framesize") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -F (frame size) expects argument");
+				dumpConfig.frameSize = parsePositiveIntegerArgument( argv[argi], "-F (frame size)");
+			}
+			else if (std::strcmp( argv[ argi], "--") == 0)
+			{
+				++argi;
+				break;
+			}
+			else if (argv[ argi][0] == '-')
+			{
+				std::cerr << "unknown option: " << argv[argi] << std::endl;
+				printUsage();
+				return -1;
+			}
+			else
+			{
+				break;
+			}
+		}
+		if (argi == argc)
+		{
+			std::cerr << "too few arguments" << std::endl;
+			printUsage();
+			return -1;
+		}
+		else if (argi+1 < argc)
+		{
+			std::cerr << "too many arguments" << std::endl;
+			printUsage();
+			return -1;
+		}
+		if (databaseConfig.empty()) throw std::runtime_error( "no database configuration specified (option -s)");
+		if (doRestore && doFreeze) throw std::runtime_error( "options -R (restore) and -Z (freeze) are exclusive");
+
+		errorhnd.reset( strus::createErrorBuffer_standard( 0, dumpConfig.threads+2, NULL/*debug trace interface*/));
+		if (!errorhnd.get()) throw std::runtime_error("failed to create error buffer structure");
+
+		strus::local_ptr<strus::FileLocatorInterface> fileLocator( strus::createFileLocator_std( errorhnd.get()));
+		if (!fileLocator.get()) throw std::runtime_error( "failed to create file locator");
+		strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( fileLocator.get(), errorhnd.get()));
+		if (!dbi.get() || errorhnd->hasError()) throw std::runtime_error( errorhnd->fetchError());
+
+		if (doRestore)
+		{
+			if (dbi->exists( databaseConfig))
+			{
+				throw std::runtime_error( "the database to restore into exists already");
+			}
+			if (!dbi->createDatabase( databaseConfig))
+			{
+				throw std::runtime_error( errorhnd->fetchError());
+			}
+		}
+		strus::local_ptr<strus::DatabaseClientInterface> database( dbi->createClient( databaseConfig));
+		if (!database.get()) throw std::runtime_error( errorhnd->fetchError());
+
+		if (doFreeze)
+		{
+			std::size_t nofPairs = strus::FrozenStorage::exportDatabase( database.get(), argv[ argi]);
+			database->close();
+			if (errorhnd->hasError()) throw std::runtime_error( errorhnd->fetchError());
+			std::cerr << strus::string_format( "frozen %u key/value pairs to %s", (unsigned int)nofPairs, argv[ argi]) << std::endl;
+			return 0;
+		}
+		strus::VectorStorageBinaryDump dumper( dumpConfig, errorhnd.get());
+		strus::VectorBinaryDumpStatistics stats = doRestore
+				? dumper.restore( database.get(), argv[ argi])
+				: dumper.dump( database.get(), argv[ argi]);
+		database->close();
+		if (errorhnd->hasError()) throw std::runtime_error( errorhnd->fetchError());
+
+		std::cerr << strus::string_format(
+				"%s %u key/value pairs in %u frames (%u bytes) in %.2f seconds: %.0f pairs/sec",
+				doRestore ? "restored" : "dumped",
+				(unsigned int)stats.nofPairs, (unsigned int)stats.nofFrames, (unsigned int)stats.nofBytes,
+				stats.seconds, stats.pairsPerSecond())
+			<< std::endl;
+		return 0;
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -1;
+	}
+	catch (const std::bad_alloc& )
+	{
+		std::cerr << "out of memory" << std::endl;
+		return -1;
+	}
+	catch (const std::logic_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -1;
+	}
+}
+
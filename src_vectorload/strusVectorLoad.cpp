@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Program loading the vectors of an embedding file into a vector storage
+#include "vectorBulkLoader.hpp"
+#include "strus/lib/vector_std.hpp"
+#include "strus/lib/database_leveldb.hpp"
+#include "strus/lib/error.hpp"
+#include "strus/lib/filelocator.hpp"
+#include "strus/vectorStorageInterface.hpp"
+#include "strus/vectorStorageClientInterface.hpp"
+#include "strus/databaseInterface.hpp"
+#include "strus/fileLocatorInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/base/local_ptr.hpp"
+#include "strus/base/string_format.hpp"
+#include <vector>
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+
+class ProgressReport
+	:public strus::VectorBulkLoadProgressInterface
+{
+public:
+	ProgressReport(){}
+	virtual ~ProgressReport(){}
+
+	virtual void report( const strus::VectorBulkLoadStatistics& stats)
+	{
+		fprintf( stderr, "\rloaded %u vectors (%.0f vectors/sec)              ", (unsigned int)stats.nofVectors, stats.vectorsPerSecond());
+	}
+};
+
+static void printUsage()
+{
+	std::cerr << "usage: strusVectorLoad [options] <inputfile>" << std::endl;
+	std::cerr << "description: Load the vectors of an embedding file into a vector storage." << std::endl;
+	std::cerr << "    <inputfile> :file with the vectors to load in one of the following formats:" << std::endl;
+	std::cerr << "        text    : word2vec or fastText text format (with header line \"<nofvec> <dim>\")" << std::endl;
+	std::cerr << "                  or GloVe text format (without header line)" << std::endl;
+	std::cerr << "        bin     : word2vec binary format" << std::endl;
+	std::cerr << "        fvecs   : .fvecs format (features are named by their row index)" << std::endl;
+	std::cerr << "        npy     : numpy .npy array of 32 or 64 bit floats (features are named by their row index)" << std::endl;
+	std::cerr << "    options     :" << std::endl;
+	std::cerr << "    -h          : print this usage" << std::endl;
+	std::cerr << "    -s <CONFIG> : specify the configuration string of the vector storage as <CONFIG>" << std::endl;
+	std::cerr << "    -C          : create the vector storage before loading" << std::endl;
+	std::cerr << "    -t <TYPE>   : specify the feature type of the vectors loaded as <TYPE>" << std::endl;
+	std::cerr << "    -f <FORMAT> : specify the format of the input file as <FORMAT> (auto,text,bin,fvecs,npy), default auto" << std::endl;
+	std::cerr << "    -T <THREADS>: use <THREADS> threads for parsing and the calculation of the LSH values" << std::endl;
+	std::cerr << "    -c <SIZE>   : commit after every <SIZE> vectors, default " << (int)strus::VectorBulkLoadConfig::DefaultCommitSize << std::endl;
+	std::cerr << "    -p <PREFIX> : prefix of the feature names built from the row index for formats without names" << std::endl;
+}
+
+static int parsePositiveIntegerArgument( const char* arg, const char* option)
+{
+	int rt = atoi( arg);
+	if (rt <= 0) throw std::runtime_error( strus::string_format( "option %s needs positive integer number as argument", option));
+	return rt;
+}
+
+int main( int argc, const char** argv)
+{
+	strus::local_ptr<strus::ErrorBufferInterface> errorhnd;
+	try
+	{
+		if (argc <= 1)
+		{
+			std::cerr << "too few arguments" << std::endl;
+			printUsage();
+			return 0;
+		}
+		int argi = 1;
+		bool doCreate = false;
+		std::string storageConfig;
+		strus::VectorBulkLoadConfig loadConfig;
+
+		for (; argi < argc; ++argi)
+		{
+			if (std::strcmp( argv[ argi], "-h") == 0 || std::strcmp( argv[ argi], "--help") == 0)
+			{
+				printUsage();
+				return 0;
+			}
+			else if (std::strcmp( argv[ argi], "-C") == 0 || std::strcmp( argv[ argi], "--create") == 0)
+			{
+				doCreate = true;
+			}
+			else if (std::strcmp( argv[ argi], "-s") == 0 || std::strcmp( argv[ argi], "--storage") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -s (storage configuration) expects argument");
+				storageConfig = argv[argi];
+			}
+			else if (std::strcmp( argv[ argi], "-t") == 0 || std::strcmp( argv[ argi], "--type") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -t (feature type) expects argument");
+				loadConfig.type = argv[argi];
+			}
+			else if (std::strcmp( argv[ argi], "-f") == 0 || std::strcmp( argv[ argi], "--format") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -f (format) expects argument");
+				if (!strus::vectorFileFormatFromName( loadConfig.format, argv[argi]))
+				{
+					throw std::runtime_error( strus::string_format( "unknown input file format '%s'", argv[argi]));
+				}
+			}
+			else if (std::strcmp( argv[ argi], "-T") == 0 || std::strcmp( argv[ argi], "--threads") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -T (threads) expects argument");
+				loadConfig.threads = parsePositiveIntegerArgument( argv[argi], "-T (threads)");
+			}
+			else if (std::strcmp( argv[ argi], "-c") == 0 || std::strcmp( argv[ argi], "--commit") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -c (commit size) expects argument");
+				loadConfig.commitSize = parsePositiveIntegerArgument( argv[argi], "-c (commit size)");
+			}
+			else if (std::strcmp( argv[ argi], "-p") == 0 || std::strcmp( argv[ argi], "--prefix") == 0)
+			{
+				++argi;
+				if (argi == argc) throw std::runtime_error("option -p (name prefix) expects argument");
+				loadConfig.namePrefix = argv[argi];
+			}
+			else if (std::strcmp( argv[ argi], "--") == 0)
+			{
+				++argi;
+				break;
+			}
+			else if (argv[ argi][0] == '-')
+			{
+				std::cerr << "unknown option: " << argv[argi] << std::endl;
+				printUsage();
+				return -1;
+			}
+			else
+			{
+				break;
+			}
+		}
+		if (argi == argc)
+		{
+			std::cerr << "too few arguments" << std::endl;
+			printUsage();
+			return -1;
+		}
+		else if (argi+1 < argc)
+		{
+			std::cerr << "too many arguments" << std::endl;
+			printUsage();
+			return -1;
+		}
+		if (storageConfig.empty()) throw std::runtime_error( "no vector storage configuration specified (option -s)");
+		if (loadConfig.type.empty()) throw std::runtime_error( "no feature type specified (option -t)");
+		if (loadConfig.threads && storageConfig.find( "threads=") == std::string::npos)
+		{
+			// ... the vector storage gets the threads for the calculation of the LSH values in the commit
+			storageConfig.append( strus::string_format( ";threads=%u", loadConfig.threads));
+		}
+		errorhnd.reset( strus::createErrorBuffer_standard( 0, loadConfig.threads+2, NULL/*debug trace interface*/));
+		if (!errorhnd.get()) throw std::runtime_error("failed to create error buffer structure");
+
+		strus::local_ptr<strus::FileLocatorInterface> fileLocator( strus::createFileLocator_std( errorhnd.get()));
+		if (!fileLocator.get()) throw std::runtime_error( "failed to create file locator");
+		strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( fileLocator.get(), errorhnd.get()));
+		strus::local_ptr<strus::VectorStorageInterface> sti( strus::createVectorStorage_std( fileLocator.get(), errorhnd.get()));
+		if (!dbi.get() || !sti.get() || errorhnd->hasError()) throw std::runtime_error( errorhnd->fetchError());
+
+		if (doCreate && !sti->createStorage( storageConfig, dbi.get()))
+		{
+			throw std::runtime_error( errorhnd->fetchError());
+		}
+		strus::local_ptr<strus::VectorStorageClientInterface> storage( sti->createClient( storageConfig, dbi.get()));
+		if (!storage.get()) throw std::runtime_error( errorhnd->fetchError());
+
+		ProgressReport progress;
+		strus::VectorBulkLoader loader( storage.get(), loadConfig, errorhnd.get());
+		strus::VectorBulkLoadStatistics stats = loader.load( argv[ argi], &progress);
+		fprintf( stderr, "\n");
+
+		storage->close();
+		if (errorhnd->hasError()) throw std::runtime_error( errorhnd->fetchError());
+
+		std::cerr << strus::string_format(
+				"loaded %u vectors in %u commits in %.2f seconds (parse %.2f, commit %.2f): %.0f vectors/sec",
+				(unsigned int)stats.nofVectors, (unsigned int)stats.nofCommits,
+				stats.seconds, stats.parseSeconds, stats.commitSeconds, stats.vectorsPerSecond())
+			<< std::endl;
+		return 0;
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -1;
+	}
+	catch (const std::bad_alloc& )
+	{
+		std::cerr << "out of memory" << std::endl;
+		return -1;
+	}
+	catch (const std::logic_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -1;
+	}
+}
+
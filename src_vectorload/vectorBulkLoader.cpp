@@ -0,0 +1,706 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Streaming bulk loader of vectors from embedding files into a vector storage
+#include "vectorBulkLoader.hpp"
+#include "strus/vectorStorageClientInterface.hpp"
+#include "strus/vectorStorageTransactionInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/storage/wordVector.hpp"
+#include "strus/base/string_format.hpp"
+#include "strus/base/thread.hpp"
+#include "strus/base/stdint.h"
+#include "strus/reference.hpp"
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace strus;
+
+const char* strus::vectorFileFormatName( VectorFileFormat format)
+{
+	static const char* ar[] = {"auto","text","bin","fvecs","npy"};
+	return ar[ format];
+}
+
+bool strus::vectorFileFormatFromName( VectorFileFormat& res, const std::string& name)
+{
+	if (name == "auto") {res = VectorFileAuto; return true;}
+	if (name == "text" || name == "word2vec" || name == "fasttext" || name == "glove") {res = VectorFileText; return true;}
+	if (name == "bin") {res = VectorFileWord2vecBinary; return true;}
+	if (name == "fvecs") {res = VectorFileFvecs; return true;}
+	if (name == "npy") {res = VectorFileNpy; return true;}
+	return false;
+}
+
+static double getTimeSeconds()
+{
+	struct timeval tv;
+	::gettimeofday( &tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static bool isLittleEndianHost()
+{
+	uint32_t val = 1;
+	return *(const unsigned char*)&val == 1;
+}
+
+static bool isSpace( char ch)
+{
+	return ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n' || ch == '\f' || ch == '\v';
+}
+
+static bool isDigit( char ch)
+{
+	return ch >= '0' && ch <= '9';
+}
+
+static bool endsWith( const std::string& str, const char* suffix)
+{
+	std::size_t suffixlen = std::strlen( suffix);
+	return str.size() >= suffixlen && 0==std::memcmp( str.c_str() + str.size() - suffixlen, suffix, suffixlen);
+}
+
+/// \brief Parse a floating point number in the range [si,se) without relying on a null termination or the locale
+static const char* parseFloat( float& res, const char* si, const char* se)
+{
+	const char* start = si;
+	bool neg = false;
+	if (si != se && (*si == '-' || *si == '+')) {neg = (*si == '-'); ++si;}
+	double val = 0.0;
+	int nofdigits = 0;
+	for (; si != se && isDigit(*si); ++si,++nofdigits) val = val * 10 + (*si - '0');
+	if (si != se && *si == '.')
+	{
+		double fraction = 1.0;
+		for (++si; si != se && isDigit(*si); ++si,++nofdigits)
+		{
+			fraction /= 10;
+			val += (*si - '0') * fraction;
+		}
+	}
+	if (!nofdigits) throw std::runtime_error( strus::string_format( "number expected at '%s'", std::string( start, se - start > 16 ? 16 : se - start).c_str()));
+	if (si != se && (*si == 'e' || *si == 'E'))
+	{
+		++si;
+		bool expneg = false;
+		if (si != se && (*si == '-' || *si == '+')) {expneg = (*si == '-'); ++si;}
+		if (si == se || !isDigit(*si)) throw std::runtime_error( strus::string_format( "exponent expected in number at '%s'", std::string( start, si - start).c_str()));
+		int exp = 0;
+		for (; si != se && isDigit(*si); ++si) if (exp < 1000) exp = exp * 10 + (*si - '0');
+		double factor = 1.0, base = 10.0;
+		for (; exp; exp >>= 1, base *= base) if (exp & 1) factor *= base;
+		val = expneg ? val / factor : val * factor;
+	}
+	if (si != se && !isSpace(*si)) throw std::runtime_error( strus::string_format( "unexpected character in number at '%s'", std::string( start, si - start + 1).c_str()));
+	res = neg ? -val : val;
+	return si;
+}
+
+/// \brief Read only memory map of a file
+class MappedFile
+{
+public:
+	explicit MappedFile( const std::string& filename)
+		:m_fd(-1),m_data(0),m_size(0),m_released(0)
+	{
+		m_fd = ::open( filename.c_str(), O_RDONLY);
+		if (m_fd < 0) throw std::runtime_error( strus::string_format( "failed to open file '%s': %s", filename.c_str(), ::strerror( errno)));
+		struct stat st;
+		if (::fstat( m_fd, &st) != 0)
+		{
+			int ec = errno;
+			::close( m_fd);
+			throw std::runtime_error( strus::string_format( "failed to get size of file '%s': %s", filename.c_str(), ::strerror( ec)));
+		}
+		m_size = st.st_size;
+		if (m_size)
+		{
+			void* ptr = ::mmap( NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+			if (ptr == MAP_FAILED)
+			{
+				int ec = errno;
+				::close( m_fd);
+				throw std::runtime_error( strus::string_format( "failed to map file '%s' into memory: %s", filename.c_str(), ::strerror( ec)));
+			}
+			m_data = (const char*)ptr;
+			(void)::madvise( ptr, m_size, MADV_SEQUENTIAL);
+		}
+	}
+
+	~MappedFile()
+	{
+		if (m_data) ::munmap( (void*)m_data, m_size);
+		if (m_fd >= 0) ::close( m_fd);
+	}
+
+	const char* data() const	{return m_data;}
+	std::size_t size() const	{return m_size;}
+
+	/// \brief Tell the system that the pages before an offset are not needed anymore
+	void release( std::size_t ofs)
+	{
+		std::size_t pagesize = ::sysconf( _SC_PAGESIZE);
+		std::size_t end = ofs - ofs % pagesize;
+		if (end > m_released)
+		{
+			(void)::madvise( (void*)(m_data + m_released), end - m_released, MADV_DONTNEED);
+			m_released = end;
+		}
+	}
+
+private:
+	MappedFile( const MappedFile&){}	//... non copyable
+	void operator=( const MappedFile&){}	//... non copyable
+
+private:
+	int m_fd;
+	const char* m_data;
+	std::size_t m_size;
+	std::size_t m_released;
+};
+
+/// \brief Reference to the data of one vector in the input
+struct RecordRef
+{
+	const char* ptr;
+	std::size_t size;
+	std::size_t rowidx;
+
+	RecordRef()
+		:ptr(0),size(0),rowidx(0){}
+	RecordRef( const char* ptr_, std::size_t size_, std::size_t rowidx_)
+		:ptr(ptr_),size(size_),rowidx(rowidx_){}
+};
+
+/// \brief Splits the input into records and parses them, the splitting is sequential, the parsing of records can be done in parallel
+class RecordScanner
+{
+public:
+	RecordScanner( const MappedFile& file, const std::string& filename, VectorFileFormat format_, const std::string& namePrefix_)
+		:m_format(format_),m_data(file.data()),m_size(file.size()),m_pos(0),m_rowidx(0)
+		,m_dim(0),m_elementSize(4),m_namePrefix(namePrefix_)
+	{
+		if (m_format == VectorFileAuto)
+		{
+			m_format = detectFormat( filename);
+		}
+		if ((m_format == VectorFileWord2vecBinary || m_format == VectorFileFvecs || m_format == VectorFileNpy) && !isLittleEndianHost())
+		{
+			throw std::runtime_error( "binary vector file formats are only supported on little endian hosts");
+		}
+		switch (m_format)
+		{
+			case VectorFileAuto: throw std::runtime_error( "logic error: vector file format not determined");
+			case VectorFileText: initText(); break;
+			case VectorFileWord2vecBinary: initWord2vecBinary(); break;
+			case VectorFileFvecs: initFvecs(); break;
+			case VectorFileNpy: initNpy(); break;
+		}
+	}
+
+	VectorFileFormat format() const		{return m_format;}
+	unsigned int dim() const		{return m_dim;}
+	std::size_t position() const		{return m_pos;}
+
+	/// \brief Get the next record
+	/// \return false if the end of the input is reached
+	bool next( RecordRef& rec)
+	{
+		switch (m_format)
+		{
+			case VectorFileAuto: break;
+			case VectorFileText: return nextText( rec);
+			case VectorFileWord2vecBinary: return nextWord2vecBinary( rec);
+			case VectorFileFvecs: return nextFixedSize( rec, 4);
+			case VectorFileNpy: return nextFixedSize( rec, 0);
+		}
+		return false;
+	}
+
+	/// \brief Parse a record returned by next
+	/// \note Thread safe, does not change the state of the scanner
+	void parse( const RecordRef& rec, std::string& name, WordVector& vec) const
+	{
+		switch (m_format)
+		{
+			case VectorFileAuto: break;
+			case VectorFileText: parseText( rec, name, vec); break;
+			case VectorFileWord2vecBinary: parseWord2vecBinary( rec, name, vec); break;
+			case VectorFileFvecs: parseFloats( rec.ptr + 4, name, vec); rowName( rec, name); break;
+			case VectorFileNpy: parseFloats( rec.ptr, name, vec); rowName( rec, name); break;
+		}
+	}
+
+private:
+	VectorFileFormat detectFormat( const std::string& filename) const
+	{
+		if (endsWith( filename, ".fvecs")) return VectorFileFvecs;
+		if (endsWith( filename, ".npy") || (m_size >= 6 && 0==std::memcmp( m_data, "\x93NUMPY", 6))) return VectorFileNpy;
+		if (endsWith( filename, ".bin")) return VectorFileWord2vecBinary;
+
+		// ... a header line followed by bytes that do not appear in text is the word2vec binary format
+		unsigned int nofvec = 0, dim = 0;
+		std::size_t pos = parseHeaderLine( nofvec, dim);
+		if (pos)
+		{
+			std::size_t ei = pos + 4096 > m_size ? m_size : pos + 4096;
+			for (std::size_t ci = pos; ci != ei; ++ci)
+			{
+				unsigned char ch = m_data[ ci];
+				if (ch < 32 && !isSpace( ch)) return VectorFileWord2vecBinary;
+			}
+		}
+		return VectorFileText;
+	}
+
+	/// \brief Parse a word2vec/fastText header line "<nofvec> <dim>"
+	/// \return the position after the header line or 0 if there is no such header line
+	std::size_t parseHeaderLine( unsigned int& nofvec, unsigned int& dim) const
+	{
+		std::size_t pos = 0;
+		unsigned int val[2] = {0,0};
+		for (int vi=0; vi<2; ++vi)
+		{
+			for (; pos < m_size && (m_data[pos] == ' ' || m_data[pos] == '\t'); ++pos){}
+			if (pos == m_size || !isDigit( m_data[pos])) return 0;
+			for (; pos < m_size && isDigit( m_data[pos]); ++pos) val[vi] = val[vi] * 10 + (m_data[pos] - '0');
+		}
+		for (; pos < m_size && m_data[pos] != '\n'; ++pos)
+		{
+			if (!isSpace( m_data[pos])) return 0;
+		}
+		if (pos < m_size) ++pos;
+		nofvec = val[0];
+		dim = val[1];
+		return pos;
+	}
+
+	/// \brief Test if the token starting at si is a number
+	static bool isNumber( const char* si, const char* se)
+	{
+		try
+		{
+			float val;
+			(void)parseFloat( val, si, se);
+			return true;
+		}
+		catch (const std::runtime_error&)
+		{
+			return false;
+		}
+	}
+
+	/// \brief Get the positions of the whitespace separated tokens in the range [si,se)
+	static void tokenize( std::vector<const char*>& res, const char* si, const char* se)
+	{
+		res.clear();
+		while (si != se)
+		{
+			for (; si != se && isSpace(*si); ++si){}
+			if (si == se) break;
+			res.push_back( si);
+			for (; si != se && !isSpace(*si); ++si){}
+		}
+	}
+
+	void initText()
+	{
+		unsigned int nofvec = 0;
+		m_pos = parseHeaderLine( nofvec, m_dim);
+		if (!m_pos)
+		{
+			// ... GloVe format without header, the dimension is the number of numeric tokens at the end of the first line not including the name
+			const char* eoln = (const char*)std::memchr( m_data, '\n', m_size);
+			const char* se = eoln ? eoln : m_data + m_size;
+			std::vector<const char*> tokens;
+			tokenize( tokens, m_data, se);
+			if (tokens.size() < 2) throw std::runtime_error( "cannot determine the vector dimension from the first line of the input");
+			std::size_t ti = tokens.size();
+			for (; ti > 1 && isNumber( tokens[ ti-1], se); --ti){}
+			m_dim = tokens.size() - ti;
+		}
+		if (!m_dim) throw std::runtime_error( "vector dimension in header of input is 0");
+	}
+
+	void initWord2vecBinary()
+	{
+		unsigned int nofvec = 0;
+		m_pos = parseHeaderLine( nofvec, m_dim);
+		if (!m_pos || !m_dim) throw std::runtime_error( "missing header line \"<nofvec> <dim>\" in word2vec binary input");
+	}
+
+	void initFvecs()
+	{
+		if (m_size < 4) throw std::runtime_error( "input file too small for .fvecs format");
+		int32_t dim;
+		std::memcpy( &dim, m_data, sizeof(dim));
+		if (dim <= 0) throw std::runtime_error( strus::string_format( "illegal dimension %d in .fvecs input", (int)dim));
+		m_dim = dim;
+		m_pos = 0;
+	}
+
+	void initNpy()
+	{
+		if (m_size < 10 || 0!=std::memcmp( m_data, "\x93NUMPY", 6)) throw std::runtime_error( "missing magic number of .npy format");
+		unsigned char majorVersion = m_data[6];
+		std::size_t headerlen;
+		std::size_t headerpos;
+		if (majorVersion == 1)
+		{
+			headerlen = (unsigned char)m_data[8] | ((unsigned char)m_data[9] << 8);
+			headerpos = 10;
+		}
+		else
+		{
+			if (m_size < 12) throw std::runtime_error( "input file too small for .npy format");
+			uint32_t hl;
+			std::memcpy( &hl, m_data + 8, sizeof(hl));
+			headerlen = hl;
+			headerpos = 12;
+		}
+		if (headerpos + headerlen > m_size) throw std::runtime_error( "header of .npy input exceeds the file size");
+		std::string header( m_data + headerpos, headerlen);
+
+		std::string descr = npyHeaderValue( header, "descr");
+		if (descr == "'<f4'" || descr == "'f4'") m_elementSize = 4;
+		else if (descr == "'<f8'" || descr == "'f8'") m_elementSize = 8;
+		else throw std::runtime_error( strus::string_format( "unsupported element type %s in .npy input, only little endian 32 or 64 bit floats are supported", descr.c_str()));
+
+		if (npyHeaderValue( header, "fortran_order") != "False") throw std::runtime_error( "only C order is supported for .npy input");
+
+		std::string shape = npyHeaderValue( header, "shape");
+		std::vector<std::size_t> dims;
+		char const* si = shape.c_str();
+		if (*si != '(') throw std::runtime_error( strus::string_format( "unexpected shape %s in .npy input", shape.c_str()));
+		for (++si; *si && *si != ')'; )
+		{
+			for (; *si == ' ' || *si == ','; ++si){}
+			if (!isDigit(*si)) break;
+			std::size_t val = 0;
+			for (; isDigit(*si); ++si) val = val * 10 + (*si - '0');
+			dims.push_back( val);
+		}
+		if (dims.size() != 2 || !dims[1]) throw std::runtime_error( strus::string_format( "expected a 2 dimensional array in .npy input instead of shape %s", shape.c_str()));
+		m_dim = dims[1];
+		m_pos = headerpos + headerlen;
+		if (m_pos + dims[0] * m_dim * m_elementSize > m_size) throw std::runtime_error( "data of .npy input is truncated");
+		m_size = m_pos + dims[0] * m_dim * m_elementSize;
+	}
+
+	/// \brief Get the value of a key in the python dictionary of a .npy header
+	static std::string npyHeaderValue( const std::string& header, const char* key)
+	{
+		std::string pattern = std::string("'") + key + "'";
+		std::size_t pos = header.find( pattern);
+		if (pos == std::string::npos) throw std::runtime_error( strus::string_format( "missing '%s' in .npy header", key));
+		pos = header.find( ':', pos + pattern.size());
+		if (pos == std::string::npos) throw std::runtime_error( strus::string_format( "missing value of '%s' in .npy header", key));
+		for (++pos; pos < header.size() && header[pos] == ' '; ++pos){}
+		std::size_t end = pos;
+		if (end < header.size() && header[end] == '(')
+		{
+			end = header.find( ')', end);
+			if (end == std::string::npos) throw std::runtime_error( strus::string_format( "unterminated value of '%s' in .npy header", key));
+			++end;
+		}
+		else
+		{
+			for (; end < header.size() && header[end] != ',' && header[end] != '}'; ++end){}
+		}
+		std::size_t last = end;
+		for (; last > pos && header[last-1] == ' '; --last){}
+		return std::string( header.c_str() + pos, last - pos);
+	}
+
+	bool nextText( RecordRef& rec)
+	{
+		while (m_pos < m_size)
+		{
+			const char* start = m_data + m_pos;
+			const char* eoln = (const char*)std::memchr( start, '\n', m_size - m_pos);
+			std::size_t len = eoln ? (eoln - start) : (m_size - m_pos);
+			m_pos += eoln ? len+1 : len;
+
+			const char* si = start;
+			const char* se = start + len;
+			for (; si != se && isSpace(*si); ++si){}
+			if (si == se) continue;
+
+			rec = RecordRef( start, len, m_rowidx++);
+			return true;
+		}
+		return false;
+	}
+
+	bool nextWord2vecBinary( RecordRef& rec)
+	{
+		for (; m_pos < m_size && isSpace( m_data[ m_pos]); ++m_pos){}
+		if (m_pos >= m_size) return false;
+		const char* start = m_data + m_pos;
+		const char* eoname = (const char*)std::memchr( start, ' ', m_size - m_pos);
+		if (!eoname) throw std::runtime_error( strus::string_format( "unterminated feature name in word2vec binary input at row %u", (unsigned int)m_rowidx));
+		std::size_t len = (eoname - start) + 1 + m_dim * 4;
+		if (m_pos + len > m_size) throw std::runtime_error( strus::string_format( "word2vec binary input is truncated at row %u", (unsigned int)m_rowidx));
+		rec = RecordRef( start, len, m_rowidx++);
+		m_pos += len;
+		return true;
+	}
+
+	bool nextFixedSize( RecordRef& rec, std::size_t headersize)
+	{
+		if (m_pos >= m_size) return false;
+		std::size_t len = headersize + m_dim * m_elementSize;
+		if (m_pos + len > m_size) throw std::runtime_error( strus::string_format( "input is truncated at row %u", (unsigned int)m_rowidx));
+		if (headersize)
+		{
+			int32_t dim;
+			std::memcpy( &dim, m_data + m_pos, sizeof(dim));
+			if (dim != (int32_t)m_dim) throw std::runtime_error( strus::string_format( "dimension %d of row %u in .fvecs input differs from the first one (%u)", (int)dim, (unsigned int)m_rowidx, m_dim));
+		}
+		rec = RecordRef( m_data + m_pos, len, m_rowidx++);
+		m_pos += len;
+		return true;
+	}
+
+	void parseText( const RecordRef& rec, std::string& name, WordVector& vec) const
+	{
+		std::vector<const char*> tokens;
+		const char* se = rec.ptr + rec.size;
+		tokenize( tokens, rec.ptr, se);
+		if (tokens.size() < m_dim + 1) throw std::runtime_error( strus::string_format( "expected feature name and %u elements in row %u", m_dim, (unsigned int)rec.rowidx));
+
+		// ... names may contain spaces (e.g. GloVe 840B), so the elements are the last m_dim tokens
+		std::size_t firstElement = tokens.size() - m_dim;
+		const char* ne = tokens[ firstElement];
+		for (; ne != tokens[0] && isSpace( ne[-1]); --ne){}
+		name.assign( tokens[0], ne - tokens[0]);
+
+		vec.resize( m_dim);
+		std::size_t ti = firstElement, te = tokens.size();
+		for (unsigned int di=0; ti != te; ++ti,++di)
+		{
+			(void)parseFloat( vec[ di], tokens[ ti], se);
+		}
+	}
+
+	void parseWord2vecBinary( const RecordRef& rec, std::string& name, WordVector& vec) const
+	{
+		const char* eoname = (const char*)std::memchr( rec.ptr, ' ', rec.size);
+		name.assign( rec.ptr, eoname - rec.ptr);
+		vec.resize( m_dim);
+		std::memcpy( &vec[0], eoname + 1, m_dim * sizeof(float));
+	}
+
+	void parseFloats( const char* ptr, std::string&, WordVector& vec) const
+	{
+		vec.resize( m_dim);
+		if (m_elementSize == sizeof(float))
+		{
+			std::memcpy( &vec[0], ptr, m_dim * sizeof(float));
+		}
+		else
+		{
+			for (unsigned int di=0; di < m_dim; ++di)
+			{
+				double val;
+				std::memcpy( &val, ptr + di * sizeof(double), sizeof(double));
+				vec[ di] = val;
+			}
+		}
+	}
+
+	void rowName( const RecordRef& rec, std::string& name) const
+	{
+		name = strus::string_format( "%s%lu", m_namePrefix.c_str(), (unsigned long)rec.rowidx);
+	}
+
+private:
+	VectorFileFormat m_format;
+	const char* m_data;
+	std::size_t m_size;
+	std::size_t m_pos;
+	std::size_t m_rowidx;
+	unsigned int m_dim;
+	std::size_t m_elementSize;
+	std::string m_namePrefix;
+};
+
+/// \brief Vector parsed from the input
+struct ParsedVector
+{
+	std::string name;
+	WordVector vec;
+
+	ParsedVector()
+		:name(),vec(){}
+	ParsedVector( const ParsedVector& o)
+		:name(o.name),vec(o.vec){}
+};
+
+/// \brief Context of one thread parsing a slice of the records of a chunk
+class RecordParser
+{
+public:
+	RecordParser( const RecordScanner* scanner_, const RecordRef* recar_, ParsedVector* resar_, std::size_t arsize_)
+		:m_scanner(scanner_),m_recar(recar_),m_resar(resar_),m_arsize(arsize_),m_error(){}
+
+	void run()
+	{
+		try
+		{
+			for (std::size_t ai=0; ai != m_arsize; ++ai)
+			{
+				m_scanner->parse( m_recar[ ai], m_resar[ ai].name, m_resar[ ai].vec);
+			}
+		}
+		catch (const std::runtime_error& err)
+		{
+			m_error = err.what();
+		}
+		catch (const std::bad_alloc&)
+		{
+			m_error = "out of memory";
+		}
+		catch (...)
+		{
+			m_error = "uncaught exception";
+		}
+	}
+
+	const std::string& error() const
+	{
+		return m_error;
+	}
+
+private:
+	const RecordScanner* m_scanner;
+	const RecordRef* m_recar;
+	ParsedVector* m_resar;
+	std::size_t m_arsize;
+	std::string m_error;
+};
+
+static void parseRecords( const RecordScanner& scanner, const std::vector<RecordRef>& records, std::vector<ParsedVector>& result, unsigned int threads)
+{
+	if (result.size() < records.size()) result.resize( records.size());
+	std::size_t nofRecords = records.size();
+	if (threads <= 1 || nofRecords < (std::size_t)threads * 16)
+	{
+		RecordParser parser( &scanner, records.data(), result.data(), nofRecords);
+		parser.run();
+		if (!parser.error().empty()) throw std::runtime_error( parser.error());
+		return;
+	}
+	std::vector<strus::Reference<RecordParser> > parserList;
+	parserList.reserve( threads);
+	for (unsigned int ti=0; ti<threads; ++ti)
+	{
+		std::size_t start = nofRecords * ti / threads;
+		std::size_t end = nofRecords * (ti+1) / threads;
+		parserList.push_back( new RecordParser( &scanner, records.data() + start, result.data() + start, end - start));
+	}
+	{
+		std::vector<strus::Reference<strus::thread> > threadGroup;
+		for (unsigned int ti=0; ti<threads; ++ti)
+		{
+			RecordParser* ctx = parserList[ti].get();
+			strus::Reference<strus::thread> th( new strus::thread( &RecordParser::run, ctx));
+			threadGroup.push_back( th);
+		}
+		std::vector<strus::Reference<strus::thread> >::iterator gi = threadGroup.begin(), ge = threadGroup.end();
+		for (; gi != ge; ++gi) (*gi)->join();
+	}
+	for (unsigned int ti=0; ti<threads; ++ti)
+	{
+		if (!parserList[ti]->error().empty())
+		{
+			throw std::runtime_error( strus::string_format( "error parsing input in thread %u: %s", ti+1, parserList[ti]->error().c_str()));
+		}
+	}
+}
+
+VectorBulkLoader::VectorBulkLoader( VectorStorageClientInterface* storage_, const VectorBulkLoadConfig& config_, ErrorBufferInterface* errorhnd_)
+	:m_storage(storage_),m_config(config_),m_errorhnd(errorhnd_)
+{
+	if (m_config.type.empty()) throw std::runtime_error( "no feature type defined for the vectors to load");
+	if (!m_config.commitSize) throw std::runtime_error( "commit size of bulk load must be a positive number");
+}
+
+VectorBulkLoadStatistics VectorBulkLoader::load( const std::string& filename, VectorBulkLoadProgressInterface* progress)
+{
+	VectorBulkLoadStatistics stats;
+	double startTime = getTimeSeconds();
+
+	MappedFile file( filename);
+	RecordScanner scanner( file, filename, m_config.format, m_config.namePrefix);
+
+	strus::Reference<VectorStorageTransactionInterface> transaction( m_storage->createTransaction());
+	if (!transaction.get()) throw std::runtime_error( strus::string_format( "failed to create vector storage transaction: %s", m_errorhnd->fetchError()));
+
+	std::vector<RecordRef> records;
+	std::vector<ParsedVector> parsed;
+	records.reserve( m_config.commitSize);
+
+	RecordRef rec;
+	bool eof = false;
+	while (!eof)
+	{
+		double parseStartTime = getTimeSeconds();
+		records.clear();
+		while (records.size() < m_config.commitSize)
+		{
+			if (!scanner.next( rec))
+			{
+				eof = true;
+				break;
+			}
+			records.push_back( rec);
+		}
+		if (records.empty()) break;
+		parseRecords( scanner, records, parsed, m_config.threads);
+
+		double commitStartTime = getTimeSeconds();
+		stats.parseSeconds += commitStartTime - parseStartTime;
+
+		std::vector<ParsedVector>::const_iterator pi = parsed.begin(), pe = parsed.begin() + records.size();
+		for (; pi != pe; ++pi)
+		{
+			transaction->defineVector( m_config.type, pi->name, pi->vec);
+		}
+		if (!transaction->commit())
+		{
+			throw std::runtime_error( strus::string_format( "failed to commit vectors %u to %u: %s",
+						(unsigned int)stats.nofVectors, (unsigned int)(stats.nofVectors + records.size()),
+						m_errorhnd->fetchError()));
+		}
+		if (m_errorhnd->hasError())
+		{
+			throw std::runtime_error( strus::string_format( "error in bulk load: %s", m_errorhnd->fetchError()));
+		}
+		file.release( scanner.position());
+
+		double endTime = getTimeSeconds();
+		stats.commitSeconds += endTime - commitStartTime;
+		stats.seconds = endTime - startTime;
+		stats.nofVectors += records.size();
+		stats.nofCommits += 1;
+		if (progress) progress->report( stats);
+	}
+	stats.seconds = getTimeSeconds() - startTime;
+	return stats;
+}
+
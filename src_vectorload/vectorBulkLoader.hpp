@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Streaming bulk loader of vectors from embedding files into a vector storage
+#ifndef _STRUS_VECTOR_BULK_LOADER_HPP_INCLUDED
+#define _STRUS_VECTOR_BULK_LOADER_HPP_INCLUDED
+#include <string>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Forward declaration
+class VectorStorageClientInterface;
+/// \brief Forward declaration
+class ErrorBufferInterface;
+
+/// \brief Format of an input file with vectors
+enum VectorFileFormat
+{
+	VectorFileAuto,			///< derive the format from the file extension and the content
+	VectorFileText,			///< text with one vector per line (name followed by the elements), with or without a word2vec/fastText header line "<nofvec> <dim>" (GloVe has none)
+	VectorFileWord2vecBinary,	///< word2vec binary format: header line "<nofvec> <dim>", then records of name, space and <dim> little endian 32-bit floats
+	VectorFileFvecs,		///< .fvecs: records of a little endian 32-bit integer dimension followed by the 32-bit float elements
+	VectorFileNpy			///< .npy: numpy array of 2 dimensions of little endian 32 or 64 bit floats in C order
+};
+
+/// \brief Get the name of a vector file format as used in program options
+const char* vectorFileFormatName( VectorFileFormat format);
+/// \brief Get the vector file format from its name in the program options
+/// \return true on success, false if the name is unknown
+bool vectorFileFormatFromName( VectorFileFormat& res, const std::string& name);
+
+/// \brief Configuration of a bulk load
+struct VectorBulkLoadConfig
+{
+	enum {DefaultCommitSize=50000};
+
+	std::string type;		///< feature type of all vectors loaded
+	VectorFileFormat format;	///< format of the input file
+	unsigned int threads;		///< number of threads used for parsing (0 for parsing in the main thread)
+	unsigned int commitSize;	///< maximum number of vectors per transaction, bounds the memory used
+	std::string namePrefix;		///< prefix of the feature names for formats without names (.fvecs,.npy), the names are built from it and the 0-based row index
+
+	VectorBulkLoadConfig()
+		:type(),format(VectorFileAuto),threads(0),commitSize(DefaultCommitSize),namePrefix(){}
+	VectorBulkLoadConfig( const VectorBulkLoadConfig& o)
+		:type(o.type),format(o.format),threads(o.threads),commitSize(o.commitSize),namePrefix(o.namePrefix){}
+};
+
+/// \brief Statistics of a bulk load
+struct VectorBulkLoadStatistics
+{
+	std::size_t nofVectors;		///< number of vectors loaded
+	std::size_t nofCommits;		///< number of transactions committed
+	double parseSeconds;		///< time in seconds spent in parsing the input
+	double commitSeconds;		///< time in seconds spent in the commits including the calculation of the LSH values
+	double seconds;			///< overall time in seconds
+
+	VectorBulkLoadStatistics()
+		:nofVectors(0),nofCommits(0),parseSeconds(0.0),commitSeconds(0.0),seconds(0.0){}
+
+	/// \brief Get the throughput in vectors per second
+	double vectorsPerSecond() const
+	{
+		return seconds > 0.0 ? (double)nofVectors / seconds : 0.0;
+	}
+};
+
+/// \brief Interface for reporting the progress of a bulk load
+class VectorBulkLoadProgressInterface
+{
+public:
+	virtual ~VectorBulkLoadProgressInterface(){}
+	/// \brief Called after every commit
+	virtual void report( const VectorBulkLoadStatistics& stats)=0;
+};
+
+/// \brief Loader of the vectors of an embedding file into a vector storage
+/// \note The input is memory mapped and read in chunks of the commit size, each chunk is parsed in parallel and committed as one transaction.
+///		The LSH values of a chunk are calculated in bulk by the transaction commit and its writes are emitted in key order.
+///		The memory used is bounded by the commit size and independent of the size of the input.
+class VectorBulkLoader
+{
+public:
+	/// \brief Constructor
+	/// \param[in] storage_ storage client to load the vectors into
+	/// \param[in] config_ configuration of the load
+	/// \param[in] errorhnd_ error buffer of the storage, the errors of the storage are fetched from it
+	VectorBulkLoader( VectorStorageClientInterface* storage_, const VectorBulkLoadConfig& config_, ErrorBufferInterface* errorhnd_);
+
+	/// \brief Load the vectors of a file
+	/// \param[in] filename path of the file to load
+	/// \param[in] progress optional interface called after every commit
+	/// \return the statistics of the load
+	/// \note Throws std::runtime_error on failure, the chunks committed before the failure remain in the storage
+	VectorBulkLoadStatistics load( const std::string& filename, VectorBulkLoadProgressInterface* progress=0);
+
+private:
+	VectorStorageClientInterface* m_storage;
+	VectorBulkLoadConfig m_config;
+	ErrorBufferInterface* m_errorhnd;
+};
+
+}//namespace
+#endif
+
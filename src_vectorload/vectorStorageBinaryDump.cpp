@@ -0,0 +1,631 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Binary dump and restore of the key/value pairs of a vector storage database
+#include "vectorStorageBinaryDump.hpp"
+#include "strus/databaseClientInterface.hpp"
+#include "strus/databaseCursorInterface.hpp"
+#include "strus/databaseTransactionInterface.hpp"
+#include "strus/storage/databaseOptions.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/base/string_format.hpp"
+#include "strus/base/thread.hpp"
+#include "strus/base/hton.hpp"
+#include "strus/base/stdint.h"
+#include "strus/base/local_ptr.hpp"
+#include "strus/reference.hpp"
+#include <vector>
+#include <string>
+#include <stdexcept>
+#include <cstring>
+#include <cstdio>
+#include <cerrno>
+#include <sys/time.h>
+
+using namespace strus;
+
+#define DUMP_FILE_MAGIC "strusvdb"
+enum {DumpFileMagicSize=8, DumpFileVersion=1};
+
+/// \brief Flags of a frame
+enum FrameFlags
+{
+	FramePrefixCompressed=0x1,	///< the keys are stored as the size of the prefix shared with the previous key and the rest
+	FrameEnd=0x2			///< end of the dump, a file without end frame is truncated
+};
+enum {FrameHeaderSize=4*sizeof(uint32_t)};
+enum {MaxFramePayloadSize=1<<30};	///< maximum size of the payload of a frame, a frame can exceed the frame size configured by its last key/value pair
+
+static double getTimeSeconds()
+{
+	struct timeval tv;
+	::gettimeofday( &tv, NULL);
+	return (double)tv.tv_sec + (double)tv.tv_usec / 1000000.0;
+}
+
+static void appendUint32( std::string& buf, uint32_t val)
+{
+	uint32_t nval = ByteOrder<uint32_t>::hton( val);
+	buf.append( (const char*)&nval, sizeof(nval));
+}
+
+static uint32_t getUint32( const char* ptr)
+{
+	uint32_t nval;
+	std::memcpy( &nval, ptr, sizeof(nval));
+	return ByteOrder<uint32_t>::ntoh( nval);
+}
+
+static void appendVarint( std::string& buf, std::size_t val)
+{
+	while (val >= 0x80)
+	{
+		buf.push_back( (char)(unsigned char)((val & 0x7F) | 0x80));
+		val >>= 7;
+	}
+	buf.push_back( (char)(unsigned char)val);
+}
+
+static std::size_t parseVarint( char const*& si, const char* se)
+{
+	std::size_t rt = 0;
+	unsigned int shift = 0;
+	for (; si != se && shift < sizeof(std::size_t) * 8; shift += 7)
+	{
+		unsigned char ch = (unsigned char)*si++;
+		rt |= (std::size_t)(ch & 0x7F) << shift;
+		if (!(ch & 0x80)) return rt;
+	}
+	throw std::runtime_error( "corrupt frame in vector storage dump: bad length encoding");
+}
+
+/// \brief FNV-1a hash of the payload of a frame
+static uint32_t frameChecksum( const char* ptr, std::size_t size)
+{
+	uint32_t rt = 2166136261U;
+	char const* pi = ptr;
+	const char* pe = ptr + size;
+	for (; pi != pe; ++pi)
+	{
+		rt ^= (unsigned char)*pi;
+		rt *= 16777619U;
+	}
+	return rt;
+}
+
+/// \brief Frame of key/value pairs sorted by key
+class FrameBuilder
+{
+public:
+	explicit FrameBuilder( bool compress_)
+		:m_compress(compress_),m_payload(),m_prevkey(),m_nofpairs(0){}
+
+	void append( const DatabaseCursorInterface::Slice& key, const DatabaseCursorInterface::Slice& value)
+	{
+		if (m_compress)
+		{
+			std::size_t shared = 0;
+			std::size_t maxshared = key.size() < m_prevkey.size() ? key.size() : m_prevkey.size();
+			while (shared < maxshared && key.ptr()[ shared] == m_prevkey[ shared]) ++shared;
+			appendVarint( m_payload, shared);
+			appendVarint( m_payload, key.size() - shared);
+			m_payload.append( key.ptr() + shared, key.size() - shared);
+			m_prevkey.assign( key.ptr(), key.size());
+		}
+		else
+		{
+			appendVarint( m_payload, key.size());
+			m_payload.append( key.ptr(), key.size());
+		}
+		appendVarint( m_payload, value.size());
+		m_payload.append( value.ptr(), value.size());
+		++m_nofpairs;
+	}
+
+	std::size_t size() const
+	{
+		return m_payload.size();
+	}
+	std::size_t nofpairs() const
+	{
+		return m_nofpairs;
+	}
+
+	/// \brief Get the frame with header and reset the builder
+	void fetch( std::string& frame)
+	{
+		frame.clear();
+		appendUint32( frame, m_compress ? FramePrefixCompressed : 0);
+		appendUint32( frame, m_nofpairs);
+		appendUint32( frame, m_payload.size());
+		appendUint32( frame, frameChecksum( m_payload.c_str(), m_payload.size()));
+		frame.append( m_payload);
+		m_payload.clear();
+		m_prevkey.clear();
+		m_nofpairs = 0;
+	}
+
+private:
+	bool m_compress;
+	std::string m_payload;
+	std::string m_prevkey;
+	std::size_t m_nofpairs;
+};
+
+/// \brief Output file of a dump shared by the threads
+class DumpOutput
+{
+public:
+	explicit DumpOutput( const std::string& filename_)
+		:m_mutex(),m_filename(filename_),m_file(::fopen( filename_.c_str(), "wb")),m_stats()
+	{
+		if (!m_file) throw std::runtime_error( strus::string_format( "failed to open dump file %s for writing: %s", m_filename.c_str(), ::strerror(errno)));
+		std::string header( DUMP_FILE_MAGIC, DumpFileMagicSize);
+		appendUint32( header, DumpFileVersion);
+		writeBytes( header);
+	}
+	~DumpOutput()
+	{
+		if (m_file) ::fclose( m_file);
+	}
+
+	/// \brief Append a frame, thread safe
+	void write( const std::string& frame, std::size_t nofpairs)
+	{
+		strus::scoped_lock lock( m_mutex);
+		writeBytes( frame);
+		m_stats.nofPairs += nofpairs;
+		m_stats.nofFrames += 1;
+	}
+
+	/// \brief Write the end frame and close the file
+	void close()
+	{
+		std::string frame;
+		appendUint32( frame, FrameEnd);
+		appendUint32( frame, 0);
+		appendUint32( frame, 0);
+		appendUint32( frame, frameChecksum( 0, 0));
+		writeBytes( frame);
+		int rt = ::fclose( m_file);
+		m_file = 0;
+		if (rt) throw std::runtime_error( strus::string_format( "failed to close dump file %s: %s", m_filename.c_str(), ::strerror(errno)));
+	}
+
+	const VectorBinaryDumpStatistics& stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	void writeBytes( const std::string& buf)
+	{
+		if (buf.size() != ::fwrite( buf.c_str(), 1, buf.size(), m_file))
+		{
+			throw std::runtime_error( strus::string_format( "failed to write dump file %s: %s", m_filename.c_str(), ::strerror(errno)));
+		}
+		m_stats.nofBytes += buf.size();
+	}
+
+private:
+	strus::mutex m_mutex;
+	std::string m_filename;
+	FILE* m_file;
+	VectorBinaryDumpStatistics m_stats;
+};
+
+/// \brief Get the ranges of keys sharing the first two bytes, a range with a one byte prefix if there is a key of size one
+static std::vector<std::string> getKeyRanges( const DatabaseClientInterface* database)
+{
+	std::vector<std::string> rt;
+	strus::local_ptr<DatabaseCursorInterface> cursor( database->createCursor( DatabaseOptions()));
+	if (!cursor.get()) throw std::runtime_error( "failed to create database cursor");
+
+	for (unsigned int prefix=0; prefix <= 0xFF; ++prefix)
+	{
+		char domainkey = (char)(unsigned char)prefix;
+		DatabaseCursorInterface::Slice key = cursor->seekFirst( &domainkey, 1);
+		while (key.defined())
+		{
+			if (key.size() == 1)
+			{
+				rt.push_back( std::string( 1, domainkey));
+				break;
+			}
+			rt.push_back( std::string( key.ptr(), 2));
+			unsigned char second = (unsigned char)key.ptr()[1];
+			if (second == 0xFF) break;
+
+			char nextkey[ 2];
+			nextkey[ 0] = domainkey;
+			nextkey[ 1] = (char)(unsigned char)(second + 1);
+			key = cursor->seekUpperBound( nextkey, 2, 1);
+		}
+	}
+	return rt;
+}
+
+/// \brief Context of one thread dumping the key ranges not yet taken by another thread
+class DumpWorker
+{
+public:
+	DumpWorker( const DatabaseClientInterface* database_, const std::vector<std::string>* ranges_, std::size_t* nextRange_, strus::mutex* rangeMutex_, DumpOutput* output_, const VectorBinaryDumpConfig& config_, ErrorBufferInterface* errorhnd_)
+		:m_database(database_),m_ranges(ranges_),m_nextRange(nextRange_),m_rangeMutex(rangeMutex_),m_output(output_),m_config(config_),m_errorhnd(errorhnd_),m_error(){}
+
+	void run()
+	{
+		try
+		{
+			strus::local_ptr<DatabaseCursorInterface> cursor( m_database->createCursor( DatabaseOptions()));
+			if (!cursor.get()) throw std::runtime_error( "failed to create database cursor");
+			FrameBuilder builder( m_config.compress);
+			std::string frame;
+
+			// ... the ranges are taken in ascending order, so the keys appended to a frame are ascending
+			std::size_t ridx;
+			while (nextRange( ridx))
+			{
+				const std::string& prefix = (*m_ranges)[ ridx];
+				DatabaseCursorInterface::Slice key = cursor->seekFirst( prefix.c_str(), prefix.size());
+				for (; key.defined(); key = cursor->seekNext())
+				{
+					builder.append( key, cursor->value());
+					if (builder.size() >= m_config.frameSize)
+					{
+						std::size_t nofpairs = builder.nofpairs();
+						builder.fetch( frame);
+						m_output->write( frame, nofpairs);
+					}
+				}
+			}
+			if (m_errorhnd->hasError())
+			{
+				throw std::runtime_error( strus::string_format( "failed to read the database: %s", m_errorhnd->fetchError()));
+			}
+			if (builder.nofpairs())
+			{
+				std::size_t nofpairs = builder.nofpairs();
+				builder.fetch( frame);
+				m_output->write( frame, nofpairs);
+			}
+		}
+		catch (const std::runtime_error& err)
+		{
+			m_error = err.what();
+		}
+		catch (const std::bad_alloc&)
+		{
+			m_error = "out of memory";
+		}
+		catch (...)
+		{
+			m_error = "uncaught exception";
+		}
+	}
+
+	/// \brief Run the worker in its own thread, releasing the error buffer context of the thread at its end
+	void runThread()
+	{
+		run();
+		m_errorhnd->releaseContext();
+	}
+
+	const std::string& error() const
+	{
+		return m_error;
+	}
+
+private:
+	bool nextRange( std::size_t& ridx)
+	{
+		strus::scoped_lock lock( *m_rangeMutex);
+		if (*m_nextRange >= m_ranges->size()) return false;
+		ridx = (*m_nextRange)++;
+		return true;
+	}
+
+private:
+	const DatabaseClientInterface* m_database;
+	const std::vector<std::string>* m_ranges;
+	std::size_t* m_nextRange;
+	strus::mutex* m_rangeMutex;
+	DumpOutput* m_output;
+	VectorBinaryDumpConfig m_config;
+	ErrorBufferInterface* m_errorhnd;
+	std::string m_error;
+};
+
+/// \brief Frame read from a dump file
+struct DumpFrame
+{
+	uint32_t flags;
+	uint32_t nofpairs;
+	std::string payload;
+
+	DumpFrame()
+		:flags(0),nofpairs(0),payload(){}
+};
+
+/// \brief Input file of a restore shared by the threads
+class DumpInput
+{
+public:
+	explicit DumpInput( const std::string& filename_)
+		:m_mutex(),m_filename(filename_),m_file(::fopen( filename_.c_str(), "rb")),m_eof(false),m_stats()
+	{
+		if (!m_file) throw std::runtime_error( strus::string_format( "failed to open dump file %s for reading: %s", m_filename.c_str(), ::strerror(errno)));
+		char header[ DumpFileMagicSize + sizeof(uint32_t)];
+		readBytes( header, sizeof(header));
+		if (0!=std::memcmp( header, DUMP_FILE_MAGIC, DumpFileMagicSize))
+		{
+			throw std::runtime_error( strus::string_format( "file %s is not a vector storage dump", m_filename.c_str()));
+		}
+		uint32_t version = getUint32( header + DumpFileMagicSize);
+		if (version != DumpFileVersion)
+		{
+			throw std::runtime_error( strus::string_format( "unsupported version %u of vector storage dump %s", (unsigned int)version, m_filename.c_str()));
+		}
+	}
+	~DumpInput()
+	{
+		if (m_file) ::fclose( m_file);
+	}
+
+	/// \brief Read the next frame, thread safe
+	/// \return false at the end of the dump
+	bool read( DumpFrame& frame)
+	{
+		strus::scoped_lock lock( m_mutex);
+		if (m_eof) return false;
+
+		char header[ FrameHeaderSize];
+		readBytes( header, FrameHeaderSize);
+		frame.flags = getUint32( header);
+		frame.nofpairs = getUint32( header + sizeof(uint32_t));
+		uint32_t payloadsize = getUint32( header + 2*sizeof(uint32_t));
+		uint32_t checksum = getUint32( header + 3*sizeof(uint32_t));
+		if ((frame.flags & ~(uint32_t)(FramePrefixCompressed|FrameEnd)) != 0
+		||	((frame.flags & FrameEnd) && (frame.flags != FrameEnd || frame.nofpairs != 0 || payloadsize != 0)))
+		{
+			throw std::runtime_error( strus::string_format( "corrupt header of frame %u of vector storage dump %s", (unsigned int)m_stats.nofFrames, m_filename.c_str()));
+		}
+		if (frame.flags & FrameEnd)
+		{
+			m_eof = true;
+			return false;
+		}
+		if (payloadsize > (uint32_t)MaxFramePayloadSize)
+		{
+			throw std::runtime_error( strus::string_format( "corrupt header of frame %u of vector storage dump %s: payload size %u exceeds the maximum %u", (unsigned int)m_stats.nofFrames, m_filename.c_str(), (unsigned int)payloadsize, (unsigned int)MaxFramePayloadSize));
+		}
+		frame.payload.resize( payloadsize);
+		if (payloadsize) readBytes( &frame.payload[0], payloadsize);
+		if (checksum != frameChecksum( frame.payload.c_str(), frame.payload.size()))
+		{
+			throw std::runtime_error( strus::string_format( "checksum mismatch in frame %u of vector storage dump %s", (unsigned int)m_stats.nofFrames, m_filename.c_str()));
+		}
+		m_stats.nofFrames += 1;
+		m_stats.nofPairs += frame.nofpairs;
+		return true;
+	}
+
+	const VectorBinaryDumpStatistics& stats() const
+	{
+		return m_stats;
+	}
+
+private:
+	void readBytes( char* buf, std::size_t size)
+	{
+		if (size != ::fread( buf, 1, size, m_file))
+		{
+			if (::ferror( m_file))
+			{
+				throw std::runtime_error( strus::string_format( "failed to read dump file %s: %s", m_filename.c_str(), ::strerror(errno)));
+			}
+			throw std::runtime_error( strus::string_format( "unexpected end of vector storage dump %s, the file is truncated", m_filename.c_str()));
+		}
+		m_stats.nofBytes += size;
+	}
+
+private:
+	strus::mutex m_mutex;
+	std::string m_filename;
+	FILE* m_file;
+	bool m_eof;
+	VectorBinaryDumpStatistics m_stats;
+};
+
+/// \brief Write the pairs of a frame into a transaction in the order stored, that is in ascending key order
+static void writeFrame( DatabaseTransactionInterface* transaction, const DumpFrame& frame)
+{
+	std::string key;
+	char const* si = frame.payload.c_str();
+	const char* se = si + frame.payload.size();
+	for (uint32_t pidx=0; pidx != frame.nofpairs; ++pidx)
+	{
+		if (frame.flags & FramePrefixCompressed)
+		{
+			std::size_t shared = parseVarint( si, se);
+			std::size_t unshared = parseVarint( si, se);
+			if (shared > key.size() || unshared > (std::size_t)(se - si))
+			{
+				throw std::runtime_error( "corrupt frame in vector storage dump: key out of range");
+			}
+			key.resize( shared);
+			key.append( si, unshared);
+			si += unshared;
+		}
+		else
+		{
+			std::size_t keysize = parseVarint( si, se);
+			if (keysize > (std::size_t)(se - si))
+			{
+				throw std::runtime_error( "corrupt frame in vector storage dump: key out of range");
+			}
+			key.assign( si, keysize);
+			si += keysize;
+		}
+		std::size_t valuesize = parseVarint( si, se);
+		if (valuesize > (std::size_t)(se - si))
+		{
+			throw std::runtime_error( "corrupt frame in vector storage dump: value out of range");
+		}
+		transaction->write( key.c_str(), key.size(), si, valuesize);
+		si += valuesize;
+	}
+	if (si != se)
+	{
+		throw std::runtime_error( "corrupt frame in vector storage dump: size does not match the number of pairs");
+	}
+}
+
+/// \brief Context of one thread committing the frames not yet taken by another thread
+class RestoreWorker
+{
+public:
+	RestoreWorker( DatabaseClientInterface* database_, DumpInput* input_, ErrorBufferInterface* errorhnd_)
+		:m_database(database_),m_input(input_),m_errorhnd(errorhnd_),m_error(){}
+
+	void run()
+	{
+		try
+		{
+			DumpFrame frame;
+			while (m_input->read( frame))
+			{
+				strus::local_ptr<DatabaseTransactionInterface> transaction( m_database->createTransaction());
+				if (!transaction.get())
+				{
+					throw std::runtime_error( strus::string_format( "failed to create database transaction: %s", m_errorhnd->fetchError()));
+				}
+				writeFrame( transaction.get(), frame);
+				if (!transaction->commit())
+				{
+					throw std::runtime_error( strus::string_format( "failed to commit frame of vector storage dump: %s", m_errorhnd->fetchError()));
+				}
+			}
+		}
+		catch (const std::runtime_error& err)
+		{
+			m_error = err.what();
+		}
+		catch (const std::bad_alloc&)
+		{
+			m_error = "out of memory";
+		}
+		catch (...)
+		{
+			m_error = "uncaught exception";
+		}
+	}
+
+	/// \brief Run the worker in its own thread, releasing the error buffer context of the thread at its end
+	void runThread()
+	{
+		run();
+		m_errorhnd->releaseContext();
+	}
+
+	const std::string& error() const
+	{
+		return m_error;
+	}
+
+private:
+	DatabaseClientInterface* m_database;
+	DumpInput* m_input;
+	ErrorBufferInterface* m_errorhnd;
+	std::string m_error;
+};
+
+template <class Worker>
+static void runWorkers( std::vector<strus::Reference<Worker> >& workers, const char* activity)
+{
+	if (workers.size() == 1)
+	{
+		workers[0]->run();
+	}
+	else
+	{
+		std::vector<strus::Reference<strus::thread> > threadGroup;
+		typename std::vector<strus::Reference<Worker> >::iterator wi = workers.begin(), we = workers.end();
+		for (; wi != we; ++wi)
+		{
+			strus::Reference<strus::thread> th( new strus::thread( &Worker::runThread, wi->get()));
+			threadGroup.push_back( th);
+		}
+		std::vector<strus::Reference<strus::thread> >::iterator gi = threadGroup.begin(), ge = threadGroup.end();
+		for (; gi != ge; ++gi) (*gi)->join();
+	}
+	for (std::size_t wi=0; wi < workers.size(); ++wi)
+	{
+		if (!workers[ wi]->error().empty())
+		{
+			throw std::runtime_error( strus::string_format( "error in %s in thread %u: %s", activity, (unsigned int)wi+1, workers[ wi]->error().c_str()));
+		}
+	}
+}
+
+VectorStorageBinaryDump::VectorStorageBinaryDump( const VectorBinaryDumpConfig& config_, ErrorBufferInterface* errorhnd_)
+	:m_config(config_),m_errorhnd(errorhnd_)
+{
+	if (!m_config.frameSize) throw std::runtime_error( "frame size of vector storage dump must be a positive number");
+	if (m_config.frameSize > (std::size_t)MaxFramePayloadSize / 2) throw std::runtime_error( strus::string_format( "frame size of vector storage dump must not exceed %u bytes", (unsigned int)MaxFramePayloadSize / 2));
+}
+
+VectorBinaryDumpStatistics VectorStorageBinaryDump::dump( const DatabaseClientInterface* database, const std::string& filename) const
+{
+	double startTime = getTimeSeconds();
+	std::vector<std::string> ranges = getKeyRanges( database);
+	if (m_errorhnd->hasError())
+	{
+		throw std::runtime_error( strus::string_format( "error reading the key ranges of the database: %s", m_errorhnd->fetchError()));
+	}
+	DumpOutput output( filename);
+	std::size_t nextRange = 0;
+	strus::mutex rangeMutex;
+
+	std::vector<strus::Reference<DumpWorker> > workers;
+	unsigned int nofWorkers = m_config.threads ? m_config.threads : 1;
+	for (unsigned int wi=0; wi < nofWorkers; ++wi)
+	{
+		workers.push_back( new DumpWorker( database, &ranges, &nextRange, &rangeMutex, &output, m_config, m_errorhnd));
+	}
+	runWorkers( workers, "vector storage dump");
+	if (m_errorhnd->hasError())
+	{
+		throw std::runtime_error( strus::string_format( "error in vector storage dump: %s", m_errorhnd->fetchError()));
+	}
+	output.close();
+
+	VectorBinaryDumpStatistics rt = output.stats();
+	rt.seconds = getTimeSeconds() - startTime;
+	return rt;
+}
+
+VectorBinaryDumpStatistics VectorStorageBinaryDump::restore( DatabaseClientInterface* database, const std::string& filename) const
+{
+	double startTime = getTimeSeconds();
+	DumpInput input( filename);
+
+	std::vector<strus::Reference<RestoreWorker> > workers;
+	unsigned int nofWorkers = m_config.threads ? m_config.threads : 1;
+	for (unsigned int wi=0; wi < nofWorkers; ++wi)
+	{
+		workers.push_back( new RestoreWorker( database, &input, m_errorhnd));
+	}
+	runWorkers( workers, "vector storage restore");
+	if (m_errorhnd->hasError())
+	{
+		throw std::runtime_error( strus::string_format( "error in vector storage restore: %s", m_errorhnd->fetchError()));
+	}
+	VectorBinaryDumpStatistics rt = input.stats();
+	rt.seconds = getTimeSeconds() - startTime;
+	return rt;
+}
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Binary dump and restore of the key/value pairs of a vector storage database
+#ifndef _STRUS_VECTOR_STORAGE_BINARY_DUMP_HPP_INCLUDED
+#define _STRUS_VECTOR_STORAGE_BINARY_DUMP_HPP_INCLUDED
+#include <string>
+#include <cstddef>
+
+namespace strus {
+
+/// \brief Forward declaration
+class DatabaseClientInterface;
+/// \brief Forward declaration
+class ErrorBufferInterface;
+
+/// \brief Configuration of a binary dump or restore
+struct VectorBinaryDumpConfig
+{
+	enum {DefaultFrameSize=1<<20};
+
+	unsigned int threads;		///< number of threads (0 for processing in the calling thread)
+	std::size_t frameSize;		///< size in bytes of the key/value pairs of a frame at which the frame is closed, a restore commits a frame as one transaction
+	bool compress;			///< true if the keys of a frame are stored with the prefix shared with the previous key elided (dump only, a restore accepts both)
+
+	VectorBinaryDumpConfig()
+		:threads(0),frameSize(DefaultFrameSize),compress(true){}
+	VectorBinaryDumpConfig( const VectorBinaryDumpConfig& o)
+		:threads(o.threads),frameSize(o.frameSize),compress(o.compress){}
+};
+
+/// \brief Statistics of a binary dump or restore
+struct VectorBinaryDumpStatistics
+{
+	std::size_t nofPairs;		///< number of key/value pairs written or read
+	std::size_t nofFrames;		///< number of frames written or read
+	std::size_t nofBytes;		///< size of the dump file in bytes
+	double seconds;			///< overall time in seconds
+
+	VectorBinaryDumpStatistics()
+		:nofPairs(0),nofFrames(0),nofBytes(0),seconds(0.0){}
+
+	/// \brief Get the throughput in key/value pairs per second
+	double pairsPerSecond() const
+	{
+		return seconds > 0.0 ? (double)nofPairs / seconds : 0.0;
+	}
+};
+
+/// \brief Binary dump and restore of all key/value pairs of a vector storage database
+/// \note The dump file starts with a header followed by frames of key/value pairs, each frame with a header with its size and a checksum.
+///		The key space is split into ranges of keys sharing the first two bytes, which are the key prefix
+///		and the first byte of the type number for the keys starting with a type. The ranges are dumped in parallel,
+///		every thread in ascending key order, so the pairs of a frame are sorted by key, but the frames of different threads
+///		are interleaved in the file.
+///		A restore commits every frame as one transaction with the writes in key order, the frames in parallel.
+class VectorStorageBinaryDump
+{
+public:
+	/// \brief Constructor
+	/// \param[in] config_ configuration of the dump or restore
+	/// \param[in] errorhnd_ error buffer of the database, the errors of the database are fetched from it
+	VectorStorageBinaryDump( const VectorBinaryDumpConfig& config_, ErrorBufferInterface* errorhnd_);
+
+	/// \brief Dump all key/value pairs of a database to a file
+	/// \param[in] database client of the database to dump, must not be changed during the dump
+	/// \param[in] filename path of the file to write
+	/// \return the statistics of the dump
+	/// \note Throws std::runtime_error on failure
+	VectorBinaryDumpStatistics dump( const DatabaseClientInterface* database, const std::string& filename) const;
+
+	/// \brief Restore all key/value pairs of a dump file into a database
+	/// \param[in] database client of the database to write to, expected to be empty
+	/// \param[in] filename path of the dump file to read
+	/// \return the statistics of the restore
+	/// \note Throws std::runtime_error on failure, the frames committed before the failure remain in the database
+	VectorBinaryDumpStatistics restore( DatabaseClientInterface* database, const std::string& filename) const;
+
+private:
+	VectorBinaryDumpConfig m_config;
+	ErrorBufferInterface* m_errorhnd;
+};
+
+}//namespace
+#endif
+
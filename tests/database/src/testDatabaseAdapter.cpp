@@ -16,6 +16,7 @@
 #include "strus/vectorStorageClientInterface.hpp"
 #include "strus/vectorStorageTransactionInterface.hpp"
 #include "strus/databaseInterface.hpp"
+#include "strus/databaseClientInterface.hpp"
 #include "strus/errorBufferInterface.hpp"
 #include "strus/base/configParser.hpp"
 #include "strus/base/stdint.h"
@@ -28,16 +29,25 @@
 #include "lshModel.hpp"
 #include "simHash.hpp"
 #include "databaseAdapter.hpp"
+#include "frozenStorage.hpp"
+#include "compactionScheduler.hpp"
+#include "vectorEncoding.hpp"
+#include "vectorMemoryStore.hpp"
+#include "productQuantizer.hpp"
+#include "armautils.hpp"
 #include "armadillo"
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <string>
 #include <map>
+#include <set>
 #include <memory>
 #include <iomanip>
 #include <cstdlib>
+#include <cmath>
 #include <limits>
+#include <algorithm>
 
 #define VEC_EPSILON  (1.0E-8)
 
@@ -320,11 +330,8 @@ static bool compare( const strus::LshModel& m1, const strus::LshModel& m2)
 	return m1.isequal( m2);
 }
 
-static void readAndCheckDatabase( const std::string& testdir, const std::string& configstr, const TestDataset& dataset, const strus::LshModel& model)
+static void checkDatabaseContent( strus::DatabaseAdapter& database, const TestDataset& dataset, const strus::LshModel& model)
 {
-	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
-	strus::DatabaseAdapter database( dbi.get(), configstr, g_errorhnd);
-
 	std::size_t nofVariables = 0;
 	database.checkVersion();
 	{
@@ -496,9 +503,440 @@ static void readAndCheckDatabase( const std::string& testdir, const std::string&
 				throw std::runtime_error("stored LSH value arrays do not match");
 			}
 		}
+	}{
+		std::cerr << "checking batch read of vectors and LSH values ..." << std::endl;
+		strus::Index ti = 1, te = dataset.nofTypes();
+		for (ti=1; ti <= te; ++ti)
+		{
+			std::vector<strus::Index> featnolist;
+			strus::Index ni = 1, ne = dataset.nofFeatures();
+			for (; ni <= ne; ++ni)
+			{
+				if (std::rand() % 3 == 1) featnolist.push_back( ni);
+			}
+			std::vector<strus::WordVector> vecar = database.readVectors( ti, featnolist);
+			std::vector<strus::SimHash> lshar = database.readSimHashes( ti, featnolist);
+			if (vecar.size() != featnolist.size() || lshar.size() != featnolist.size())
+			{
+				throw std::runtime_error("size of batch read result does not match");
+			}
+			std::vector<strus::Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+			for (int fidx=0; fi != fe; ++fi,++fidx)
+			{
+				const strus::WordVector& vec = dataset.vector( ti, *fi);
+				if (!compare( vec, vecar[ fidx]))
+				{
+					throw std::runtime_error("batch read vectors do not match");
+				}
+				if (vec.empty() ? lshar[ fidx].defined() : (lshar[ fidx] != model.simHash( vec, *fi) || lshar[ fidx].id() != *fi))
+				{
+					throw std::runtime_error("batch read LSH values do not match");
+				}
+			}
+			std::vector<strus::Index> existing = database.readFeatnosWithVector( ti, featnolist);
+			std::vector<strus::Index>::const_iterator ei = existing.begin(), ee = existing.end();
+			for (fi = featnolist.begin(); fi != fe; ++fi)
+			{
+				bool found = (ei != ee && *ei == *fi);
+				if (found != !dataset.vector( ti, *fi).empty())
+				{
+					throw std::runtime_error("probe of existing vectors does not match");
+				}
+				if (found) ++ei;
+			}
+			std::cerr << "number of elements read in batch: " << featnolist.size() << std::endl;
+		}
+	}{
+		std::cerr << "checking batch read of feature names ..." << std::endl;
+		// ... read twice, the second read is answered partially or completely by the name cache if configured
+		std::vector<strus::Index> featnolist;
+		strus::Index ni = 1, ne = dataset.nofFeatures();
+		for (; ni <= ne; ++ni)
+		{
+			if (std::rand() % 3 == 1) featnolist.push_back( ni);
+		}
+		for (std::size_t fidx=1; fidx < featnolist.size(); ++fidx)
+		{
+			std::swap( featnolist[ fidx], featnolist[ std::rand() % (fidx+1)]);
+		}
+		if (!featnolist.empty()) featnolist.push_back( featnolist[0]);
+		for (int pass=0; pass < 2; ++pass)
+		{
+			std::vector<std::string> names = database.readFeatNames( featnolist);
+			if (names.size() != featnolist.size())
+			{
+				throw std::runtime_error("size of batch read feature names does not match");
+			}
+			std::vector<strus::Index>::const_iterator fi = featnolist.begin(), fe = featnolist.end();
+			for (int fidx=0; fi != fe; ++fi,++fidx)
+			{
+				if (names[ fidx] != getFeatureName( *fi))
+				{
+					throw std::runtime_error("batch read feature names do not match");
+				}
+			}
+		}
+		std::cerr << "number of feature names read in batch: " << featnolist.size() << std::endl;
+	}
+}
+
+static void readAndCheckDatabase( const std::string& testdir, const std::string& configstr, const TestDataset& dataset, const strus::LshModel& model)
+{
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	strus::DatabaseAdapter database( dbi.get(), configstr, g_errorhnd);
+	checkDatabaseContent( database, dataset, model);
+
+	std::cerr << "checking reads with a name cache smaller than the number of names ..." << std::endl;
+	strus::DatabaseAdapter cachedDatabase( dbi.get(), configstr, g_errorhnd, dataset.nofFeatures() / 2 + 1/*nameCacheSize*/);
+	checkDatabaseContent( cachedDatabase, dataset, model);
+}
+
+static void checkNameCacheMisses( const std::string& configstr, const TestDataset& dataset)
+{
+	std::cerr << "checking names not found in a name cache defined by another client afterwards ..." << std::endl;
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	strus::DatabaseAdapter cachedDatabase( dbi.get(), configstr, g_errorhnd, dataset.nofFeatures() + 1/*nameCacheSize*/);
+	strus::DatabaseAdapter otherDatabase( dbi.get(), configstr, g_errorhnd);
+
+	std::string type( "_type_defined_later_");
+	std::string feature( "_feature_defined_later_");
+	strus::Index typeno = dataset.nofTypes() + 3;
+	strus::Index featno = dataset.nofFeatures() + 1;
+	if (cachedDatabase.readTypeno( type) != 0 || cachedDatabase.readFeatno( feature) != 0)
+	{
+		throw std::runtime_error( "names not defined yet found in database");
+	}
+	{
+		// ... the commit of another client does not invalidate the name cache of this one
+		strus::local_ptr<strus::DatabaseAdapter::Transaction> transaction( otherDatabase.createTransaction());
+		transaction->writeType( type, typeno);
+		transaction->writeFeature( feature, featno);
+		if (!transaction->commit()) throw strus::runtime_error( "%s", _TXT("vector storage transaction failed"));
+	}
+	if (cachedDatabase.readTypeno( type) != typeno || cachedDatabase.readFeatno( feature) != featno)
+	{
+		throw std::runtime_error( "names defined by another client not found because of a name cache entry of the name not found before");
+	}
+}
+
+static double vectorEncodingSimilarityTolerance( strus::VectorEncoding encoding)
+{
+	switch (encoding)
+	{
+		case strus::VectorEncodingFloat32: return 1.0E-5;
+		case strus::VectorEncodingFloat16: return 2.0E-3;
+		case strus::VectorEncodingBFloat16: return 2.0E-2;
+		case strus::VectorEncodingInt8: return 2.0E-2;
+	}
+	throw std::runtime_error("unknown vector encoding");
+}
+
+/// \brief Check the similarities used for reranking search results against the exact cosine of the vectors
+static void checkRerankSimilarities( const std::string& configstr, const TestDataset& dataset)
+{
+	enum {NofQueries=20};
+	std::cerr << "checking similarities for reranking against the exact similarities ..." << std::endl;
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	strus::DatabaseAdapter database( dbi.get(), configstr, g_errorhnd);
+	int vecdim = dataset.config().vecdim;
+	double encodingTolerance = vectorEncodingSimilarityTolerance( database.vectorEncoding());
+
+	// ... the maximum and mean absolute error of the asymmetric distance computation of the product quantization with 4 dimensions and 1 dimension per subspace
+	struct QuantizationDef {int nofSubspaces; double maxError; double meanError;};
+	QuantizationDef quantizationDefs[] = {{vecdim / 4, 0.25, 0.05}, {vecdim, 0.02, 0.005}};
+	int nofQuantizationDefs = sizeof(quantizationDefs)/sizeof(quantizationDefs[0]);
+
+	strus::Index ti = 1, te = dataset.nofTypes();
+	for (; ti <= te; ++ti)
+	{
+		strus::VectorMemoryStore memoryStore( &database, ti, vecdim);
+		if ((int)memoryStore.size() != dataset.nofVectors( ti))
+		{
+			throw strus::runtime_error( "in memory store of type %d has %d vectors instead of %d", (int)ti, (int)memoryStore.size(), dataset.nofVectors( ti));
+		}
+		std::vector<strus::Reference<strus::ProductQuantizer> > quantizers;
+		for (int qi=0; qi < nofQuantizationDefs; ++qi)
+		{
+			quantizers.push_back( strus::Reference<strus::ProductQuantizer>( new strus::ProductQuantizer( &database, ti, vecdim, quantizationDefs[ qi].nofSubspaces)));
+		}
+		// ... queries are random vectors and vectors stored of the type
+		std::vector<strus::WordVector> queries;
+		std::map<TestDataset::FeatDef,int>::const_iterator fi = dataset.featmap().begin(), fe = dataset.featmap().end();
+		for (; fi != fe && (int)queries.size() < NofQueries; ++fi)
+		{
+			if (fi->first.typeno == ti && fi->second) queries.push_back( dataset.vector( ti, fi->first.featno));
+		}
+		while ((int)queries.size() < 2 * NofQueries) queries.push_back( getRandomVector( vecdim));
+
+		std::vector<double> maxError( nofQuantizationDefs, 0.0);
+		std::vector<double> sumError( nofQuantizationDefs, 0.0);
+		int nofSimilarities = 0;
+		std::vector<std::vector<float> > luts( nofQuantizationDefs);
+		std::vector<strus::WordVector>::const_iterator qi = queries.begin(), qe = queries.end();
+		for (; qi != qe; ++qi)
+		{
+			arma::fvec normquery = strus::normalizeVector( *qi);
+			for (int pi=0; pi < nofQuantizationDefs; ++pi)
+			{
+				quantizers[ pi]->createLookupTable( luts[ pi], normquery.memptr());
+			}
+			for (fi = dataset.featmap().begin(); fi != fe; ++fi)
+			{
+				if (fi->first.typeno != ti) continue;
+				double sim;
+				bool found = memoryStore.similarity( fi->first.featno, normquery.memptr(), sim);
+				if (!fi->second)
+				{
+					if (found) throw strus::runtime_error( "in memory store of type %d returns a similarity for feature %d without vector", (int)ti, (int)fi->first.featno);
+					continue;
+				}
+				if (!found) throw strus::runtime_error( "vector of feature %d not found in in memory store of type %d", (int)fi->first.featno, (int)ti);
+				double exact = arma::norm_dot( arma::fvec( *qi), arma::fvec( dataset.vector( ti, fi->first.featno)));
+				if (std::fabs( sim - exact) > encodingTolerance)
+				{
+					throw strus::runtime_error( "similarity %f of in memory store differs from the exact similarity %f by more than %f", sim, exact, encodingTolerance);
+				}
+				for (int pi=0; pi < nofQuantizationDefs; ++pi)
+				{
+					if (!quantizers[ pi]->similarity( fi->first.featno, luts[ pi], sim))
+					{
+						throw strus::runtime_error( "vector of feature %d not found in product quantizer of type %d", (int)fi->first.featno, (int)ti);
+					}
+					double err = std::fabs( sim - exact);
+					if (err > maxError[ pi]) maxError[ pi] = err;
+					sumError[ pi] += err;
+				}
+				++nofSimilarities;
+			}
+		}
+		for (int pi=0; nofSimilarities && pi < nofQuantizationDefs; ++pi)
+		{
+			double meanError = sumError[ pi] / nofSimilarities;
+			std::cerr << strus::string_format( "product quantization of type %d with %d subspaces: max error %f mean error %f", (int)ti, quantizationDefs[ pi].nofSubspaces, maxError[ pi], meanError) << std::endl;
+			if (maxError[ pi] > quantizationDefs[ pi].maxError + encodingTolerance || meanError > quantizationDefs[ pi].meanError + encodingTolerance)
+			{
+				throw strus::runtime_error( "error of the similarities of the product quantization with %d subspaces out of tolerance", quantizationDefs[ pi].nofSubspaces);
+			}
+		}
+	}
+}
+
+static void checkCompactionStatistics( const strus::CompactionScheduler& scheduler, std::size_t nofCompactions, std::size_t bytesWritten)
+{
+	strus::CompactionScheduler::Statistics stats = scheduler.statistics();
+	if (stats.nofCompactions != nofCompactions || stats.bytesWritten != bytesWritten)
+	{
+		throw strus::runtime_error( "compaction scheduler did %d compactions with %d bytes written instead of %d compactions with %d bytes written", (int)stats.nofCompactions, (int)stats.bytesWritten, (int)nofCompactions, (int)bytesWritten);
+	}
+}
+
+static void checkCompactionScheduler( const std::string& configstr)
+{
+	enum {WriteThreshold=1000};
+	std::cerr << "checking the compaction of the database in the background ..." << std::endl;
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	strus::local_ptr<strus::DatabaseClientInterface> dbclient( dbi->createClient( configstr));
+	if (!dbclient.get()) throw std::runtime_error( g_errorhnd->fetchError());
+	{
+		// ... commits below the threshold are only counted, a commit reaching it triggers a compaction
+		strus::CompactionScheduler scheduler( dbclient.get(), WriteThreshold, 0/*minInterval*/, g_errorhnd);
+		scheduler.notifyWrites( WriteThreshold / 2);
+		scheduler.waitIdle();
+		checkCompactionStatistics( scheduler, 0, WriteThreshold / 2);
+		scheduler.notifyWrites( WriteThreshold / 2);
+		scheduler.waitIdle();
+		checkCompactionStatistics( scheduler, 1, 0);
+		scheduler.notifyWrites( WriteThreshold * 2);
+		scheduler.waitIdle();
+		checkCompactionStatistics( scheduler, 2, 0);
+		std::string error = scheduler.stop();
+		if (!error.empty()) throw strus::runtime_error( "compaction in the background failed: %s", error.c_str());
+	}
+	{
+		// ... no compaction is triggered before the minimum interval since the last one has passed
+		strus::CompactionScheduler scheduler( dbclient.get(), WriteThreshold, 3600/*minInterval*/, g_errorhnd);
+		scheduler.notifyWrites( WriteThreshold * 2);
+		scheduler.waitIdle();
+		checkCompactionStatistics( scheduler, 0, WriteThreshold * 2);
 	}
 }
 
+static void exportAndCheckFrozenStorage( const std::string& testdir, const std::string& configstr, const TestDataset& dataset, const strus::LshModel& model)
+{
+	std::string frozenPath = strus::joinFilePath( testdir, "vstorage.frozen");
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	{
+		strus::local_ptr<strus::DatabaseClientInterface> dbclient( dbi->createClient( configstr));
+		if (!dbclient.get()) throw std::runtime_error( g_errorhnd->fetchError());
+		std::size_t nofEntries = strus::FrozenStorage::exportDatabase( dbclient.get(), frozenPath);
+		std::cerr << "exported " << nofEntries << " key/value pairs to frozen storage " << frozenPath << std::endl;
+	}
+	std::cerr << "checking reads from the frozen storage ..." << std::endl;
+	strus::Reference<strus::FrozenStorage> frozen( new strus::FrozenStorage( frozenPath));
+	strus::DatabaseAdapter database( frozen, g_errorhnd);
+	checkDatabaseContent( database, dataset, model);
+
+	bool readOnly = false;
+	try
+	{
+		strus::local_ptr<strus::DatabaseAdapter::Transaction> transaction( database.createTransaction());
+	}
+	catch (const std::runtime_error&)
+	{
+		readOnly = true;
+	}
+	if (!readOnly) throw std::runtime_error( "frozen storage is not read only");
+}
+
+struct SimHashIdOrder
+{
+	bool operator()( const strus::SimHash& a, const strus::SimHash& b) const
+	{
+		return a.id() < b.id();
+	}
+};
+
+static void insertFeatnoSampleBatch( strus::DatabaseAdapter& database, const strus::LshModel& model, strus::Index typeno, const std::vector<strus::Index>& batch, int nofVectors)
+{
+	strus::local_ptr<strus::DatabaseAdapter::Transaction> transaction( database.createTransaction());
+	std::vector<strus::Index>::const_iterator bi = batch.begin(), be = batch.end();
+	if (database.simHashLayout() == strus::SimHashLayoutBlock)
+	{
+		while (bi != be)
+		{
+			strus::Index blockno = strus::DatabaseAdapter::simHashBlockno( *bi);
+			std::vector<strus::SimHash> block = database.readSimHashBlock( typeno, blockno);
+			for (; bi != be && strus::DatabaseAdapter::simHashBlockno( *bi) == blockno; ++bi)
+			{
+				block.push_back( model.simHash( getRandomVector( model.vecdim()), *bi));
+			}
+			std::sort( block.begin(), block.end(), SimHashIdOrder());
+			transaction->writeSimHashBlock( typeno, blockno, block);
+		}
+	}
+	else
+	{
+		for (; bi != be; ++bi)
+		{
+			transaction->writeSimHash( typeno, *bi, model.simHash( getRandomVector( model.vecdim()), *bi));
+		}
+	}
+	transaction->writeNofVectors( typeno, nofVectors);
+	database.updateFeatnoSamples( *transaction, typeno, batch, false/*cleared*/);
+	if (!transaction->commit()) throw strus::runtime_error( "%s", _TXT("vector storage transaction failed"));
+}
+
+static void checkFeatnoSamples( const std::string& configstr, const TestDataset& dataset, const strus::LshModel& model, strus::SimHashLayout layout, strus::Index typeno)
+{
+	enum {SampleInterval=16,BatchSize=23,FeatnoStep=13};
+	std::cerr << "checking access by ordinal with position markers in the layout " << strus::simHashLayoutName( layout) << " ..." << std::endl;
+
+	strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+	{
+		strus::DatabaseAdapter database( dbi.get(), configstr, g_errorhnd);
+		strus::local_ptr<strus::DatabaseAdapter::Transaction> transaction( database.createTransaction());
+		transaction->writeVariable( "lshlayout", strus::simHashLayoutName( layout));
+		transaction->writeVariable( "sampleint", strus::string_format( "%d", (int)SampleInterval));
+		if (!transaction->commit()) throw strus::runtime_error( "%s", _TXT("vector storage transaction failed"));
+	}
+	strus::DatabaseAdapter database( dbi.get(), configstr, g_errorhnd);
+	if (database.featnoSampleInterval() != SampleInterval || database.simHashLayout() != layout)
+	{
+		throw std::runtime_error( "configuration of the position markers not read from the storage");
+	}
+	// ... insert the features in three passes, every pass fills gaps before the markers written by the previous ones,
+	//	the feature numbers are spread over several blocks of LSH values
+	std::set<strus::Index> featnoset;
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		std::vector<strus::Index> batch;
+		int fi = 1, fe = dataset.nofFeatures();
+		for (; fi <= fe; ++fi)
+		{
+			if ((fi + pass) % 3 != 0) continue;
+			batch.push_back( fi * FeatnoStep);
+			if ((int)batch.size() == BatchSize || fi + 3 > fe)
+			{
+				featnoset.insert( batch.begin(), batch.end());
+				insertFeatnoSampleBatch( database, model, typeno, batch, featnoset.size());
+				batch.clear();
+			}
+		}
+		std::vector<strus::Index> expected( featnoset.begin(), featnoset.end());
+		int idx = 0, nofMarkers = 0;
+		for (; idx < (int)expected.size(); ++idx)
+		{
+			if (database.readFeatnoStart( typeno, idx) != expected[ idx])
+			{
+				throw strus::runtime_error( "feature accessed by ordinal %d does not match", idx);
+			}
+			if (idx % SampleInterval == 0 && database.readFeatnoSample( typeno, idx / SampleInterval))
+			{
+				if (database.readFeatnoSample( typeno, idx / SampleInterval) != expected[ idx])
+				{
+					throw strus::runtime_error( "position marker %d does not match", idx / SampleInterval);
+				}
+				++nofMarkers;
+			}
+		}
+		if (database.readFeatnoStart( typeno, idx) != 0)
+		{
+			throw std::runtime_error( "feature accessed by ordinal out of range");
+		}
+		if (nofMarkers != ((int)expected.size() - 1) / SampleInterval)
+		{
+			throw strus::runtime_error( "expected %d position markers, got %d", ((int)expected.size() - 1) / SampleInterval, nofMarkers);
+		}
+	}
+	std::cerr << "checked access by ordinal of " << featnoset.size() << " features" << std::endl;
+}
+
+static void checkVectorEncodings( unsigned int dim)
+{
+	static const strus::VectorEncoding encodings[] = {strus::VectorEncodingFloat32, strus::VectorEncodingFloat16, strus::VectorEncodingBFloat16, strus::VectorEncodingInt8};
+	static const double tolerance[] = {VEC_EPSILON, 1.0E-3, 1.0E-2, 1.0E-2};
+	int ei = 0, ee = sizeof(encodings)/sizeof(encodings[0]);
+	for (; ei != ee; ++ei)
+	{
+		strus::VectorEncoding encoding = encodings[ ei];
+		std::cerr << "checking vector encoding " << strus::vectorEncodingName( encoding) << " ..." << std::endl;
+		if (encoding != strus::vectorEncodingFromName( strus::vectorEncodingName( encoding)))
+		{
+			throw std::runtime_error("vector encoding name does not match");
+		}
+		int vi = 0, ve = 100;
+		for (; vi != ve; ++vi)
+		{
+			strus::WordVector vec = getRandomVector( dim);
+			std::string blob = strus::vectorEncodedSerialization( vec, encoding);
+			strus::WordVector decvec = strus::vectorFromEncodedSerialization( blob.c_str(), blob.size(), encoding);
+			if (decvec.size() != vec.size())
+			{
+				throw std::runtime_error("size of decoded vector does not match");
+			}
+			strus::WordVector::const_iterator di = decvec.begin(), de = decvec.end();
+			strus::WordVector::const_iterator oi = vec.begin();
+			for (; di != de; ++di,++oi)
+			{
+				double diff = (*di > *oi)?(*di - *oi):(*oi - *di);
+				if (diff > tolerance[ ei])
+				{
+					std::cerr << strus::string_format( "decoded element %f differs from %f more than %f", *di, *oi, tolerance[ ei]) << std::endl;
+					throw std::runtime_error("decoded vector does not match");
+				}
+			}
+			std::vector<char> elements( dim * strus::vectorEncodingElementSize( encoding));
+			float scale = strus::vectorEncodeElements( &elements[0], &vec[0], dim, encoding);
+			double dotenc = scale * strus::vectorEncodedDotProduct( &vec[0], &elements[0], dim, encoding);
+			double dotref = arma::dot( arma::fvec( vec), arma::fvec( vec));
+			if ((dotenc > dotref ? (dotenc - dotref) : (dotref - dotenc)) > dotref * tolerance[ ei] * 2 + VEC_EPSILON)
+			{
+				std::cerr << strus::string_format( "dot product on encoded elements %f differs from %f", dotenc, dotref) << std::endl;
+				throw std::runtime_error("dot product on encoded elements does not match");
+			}
+		}
+	}
+}
 
 #define DEFAULT_CONFIG \
 	"path=vsmodel;"\
@@ -585,8 +1023,15 @@ int main( int argc, const char** argv)
 		std::string dbconfigstr( configstr);
 		removeKeysFromConfigString( dbconfigstr, vectorconfigkeys, g_errorhnd);
 
+		checkVectorEncodings( dataset.config().vecdim);
 		writeDatabase( workdir, dbconfigstr, dataset, model);
 		readAndCheckDatabase( workdir, dbconfigstr, dataset, model);
+		exportAndCheckFrozenStorage( workdir, dbconfigstr, dataset, model);
+		checkFeatnoSamples( dbconfigstr, dataset, model, strus::SimHashLayoutKey, nofTypes+1);
+		checkFeatnoSamples( dbconfigstr, dataset, model, strus::SimHashLayoutBlock, nofTypes+2);
+		checkRerankSimilarities( dbconfigstr, dataset);
+		checkNameCacheMisses( dbconfigstr, dataset);
+		checkCompactionScheduler( dbconfigstr);
 
 		strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
 		if (dbi.get())
@@ -0,0 +1,265 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Test program for the binary dump and restore of a vector storage
+#include "vectorStorageBinaryDump.hpp"
+#include "strus/lib/vector_std.hpp"
+#include "strus/lib/database_leveldb.hpp"
+#include "strus/lib/error.hpp"
+#include "strus/lib/filelocator.hpp"
+#include "strus/vectorStorageInterface.hpp"
+#include "strus/vectorStorageClientInterface.hpp"
+#include "strus/vectorStorageTransactionInterface.hpp"
+#include "strus/databaseInterface.hpp"
+#include "strus/databaseClientInterface.hpp"
+#include "strus/databaseCursorInterface.hpp"
+#include "strus/fileLocatorInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/storage/databaseOptions.hpp"
+#include "strus/storage/wordVector.hpp"
+#include "strus/base/fileio.hpp"
+#include "strus/base/local_ptr.hpp"
+#include "strus/base/string_format.hpp"
+#include "strus/base/pseudoRandom.hpp"
+#include "vectorUtils.hpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstring>
+#include <stdexcept>
+
+#define VEC_EPSILON 1e-5
+static bool g_verbose = false;
+static strus::PseudoRandom g_random;
+static strus::ErrorBufferInterface* g_errorhnd = 0;
+static strus::FileLocatorInterface* g_fileLocator = 0;
+
+enum {VecDim=32,NofVectors=1000,NofTypes=3};
+#define STORAGE_CONFIG "path=vdumpstorage;vecdim=32"
+#define SOURCE_DATABASE_CONFIG "path=vdumpstorage"
+#define RESTORE_DATABASE_CONFIG "path=vrestorestorage"
+
+typedef std::map<std::string,std::string> KeyValueMap;
+
+static KeyValueMap readAllKeyValues( const strus::DatabaseClientInterface* database)
+{
+	KeyValueMap rt;
+	strus::local_ptr<strus::DatabaseCursorInterface> cursor( database->createCursor( strus::DatabaseOptions()));
+	if (!cursor.get()) throw std::runtime_error( g_errorhnd->fetchError());
+	for (unsigned int prefix=0; prefix <= 0xFF; ++prefix)
+	{
+		char domainkey = (char)(unsigned char)prefix;
+		strus::DatabaseCursorInterface::Slice key = cursor->seekFirst( &domainkey, 1);
+		for (; key.defined(); key = cursor->seekNext())
+		{
+			rt[ key.tostring()] = cursor->value().tostring();
+		}
+	}
+	return rt;
+}
+
+static void testDumpRestore(
+		strus::DatabaseInterface* dbi,
+		const KeyValueMap& expected,
+		const std::string& filename,
+		unsigned int threads,
+		std::size_t frameSize,
+		bool compress)
+{
+	strus::VectorBinaryDumpConfig config;
+	config.threads = threads;
+	config.frameSize = frameSize;
+	config.compress = compress;
+	strus::VectorStorageBinaryDump dumper( config, g_errorhnd);
+	{
+		strus::local_ptr<strus::DatabaseClientInterface> database( dbi->createClient( SOURCE_DATABASE_CONFIG));
+		if (!database.get()) throw std::runtime_error( g_errorhnd->fetchError());
+		strus::VectorBinaryDumpStatistics stats = dumper.dump( database.get(), filename);
+		if (g_verbose) std::cerr << strus::string_format( "dumped %u pairs in %u frames (%u bytes) to %s", (unsigned int)stats.nofPairs, (unsigned int)stats.nofFrames, (unsigned int)stats.nofBytes, filename.c_str()) << std::endl;
+		if (stats.nofPairs != expected.size())
+		{
+			throw std::runtime_error( strus::string_format( "number of pairs dumped to %s (%u) does not match expected (%u)", filename.c_str(), (unsigned int)stats.nofPairs, (unsigned int)expected.size()));
+		}
+	}
+	if (!dbi->destroyDatabase( RESTORE_DATABASE_CONFIG))
+	{
+		(void)g_errorhnd->fetchError();
+	}
+	if (!dbi->createDatabase( RESTORE_DATABASE_CONFIG))
+	{
+		throw std::runtime_error( g_errorhnd->fetchError());
+	}
+	{
+		strus::local_ptr<strus::DatabaseClientInterface> database( dbi->createClient( RESTORE_DATABASE_CONFIG));
+		if (!database.get()) throw std::runtime_error( g_errorhnd->fetchError());
+		strus::VectorBinaryDumpStatistics stats = dumper.restore( database.get(), filename);
+		if (stats.nofPairs != expected.size())
+		{
+			throw std::runtime_error( strus::string_format( "number of pairs restored from %s (%u) does not match expected (%u)", filename.c_str(), (unsigned int)stats.nofPairs, (unsigned int)expected.size()));
+		}
+		if (readAllKeyValues( database.get()) != expected)
+		{
+			throw std::runtime_error( strus::string_format( "content of storage restored from %s does not match the original", filename.c_str()));
+		}
+	}
+}
+
+/// \brief Offset of the payload size in the header of the first frame of a dump (after the magic and the version of the file header and the flags and the number of pairs of the frame header)
+enum {FirstFramePayloadSizeOffset=8+4+4+4};
+
+static void testCorruptDump( strus::DatabaseInterface* dbi, const std::string& filename, bool corruptPayloadSize)
+{
+	std::string content;
+	int ec = strus::readFile( filename, content);
+	if (ec) throw std::runtime_error( strus::string_format( "failed to read dump file %s: %s", filename.c_str(), ::strerror(ec)));
+	if (corruptPayloadSize)
+	{
+		// ... a payload size of nearly 4GB has to be rejected before the payload buffer is allocated
+		if (content.size() < FirstFramePayloadSizeOffset + 4) throw std::runtime_error( strus::string_format( "dump file %s too small", filename.c_str()));
+		std::memset( &content[ FirstFramePayloadSizeOffset], 0xFF, 4);
+	}
+	else
+	{
+		content[ content.size() / 2] ^= 0x5A;
+	}
+	std::string corruptFilename = filename + ".corrupt";
+	ec = strus::writeFile( corruptFilename, content);
+	if (ec) throw std::runtime_error( strus::string_format( "failed to write dump file %s: %s", corruptFilename.c_str(), ::strerror(ec)));
+
+	if (!dbi->destroyDatabase( RESTORE_DATABASE_CONFIG))
+	{
+		(void)g_errorhnd->fetchError();
+	}
+	if (!dbi->createDatabase( RESTORE_DATABASE_CONFIG))
+	{
+		throw std::runtime_error( g_errorhnd->fetchError());
+	}
+	strus::local_ptr<strus::DatabaseClientInterface> database( dbi->createClient( RESTORE_DATABASE_CONFIG));
+	if (!database.get()) throw std::runtime_error( g_errorhnd->fetchError());
+	strus::VectorStorageBinaryDump dumper( strus::VectorBinaryDumpConfig(), g_errorhnd);
+	try
+	{
+		(void)dumper.restore( database.get(), corruptFilename);
+	}
+	catch (const std::runtime_error& err)
+	{
+		if (g_verbose) std::cerr << "corrupt dump detected: " << err.what() << std::endl;
+		return;
+	}
+	throw std::runtime_error( "corrupt dump was not detected");
+}
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		g_errorhnd = strus::createErrorBuffer_standard( 0, 8, NULL/*debug trace interface*/);
+		if (!g_errorhnd) {std::cerr << "FAILED " << "strus::createErrorBuffer_standard" << std::endl; return -1;}
+		g_fileLocator = strus::createFileLocator_std( g_errorhnd);
+		if (!g_fileLocator) {std::cerr << "FAILED " << "strus::createFileLocator_std" << std::endl; return -1;}
+
+		if (argc > 1 && 0==std::strcmp( argv[1], "-V"))
+		{
+			g_verbose = true;
+		}
+		std::string configstr( STORAGE_CONFIG);
+
+		strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+		strus::local_ptr<strus::VectorStorageInterface> sti( strus::createVectorStorage_std( g_fileLocator, g_errorhnd));
+		if (!dbi.get() || !sti.get() || g_errorhnd->hasError()) throw std::runtime_error( g_errorhnd->fetchError());
+
+		if (!dbi->destroyDatabase( configstr))
+		{
+			(void)g_errorhnd->fetchError();
+		}
+		if (!sti->createStorage( configstr, dbi.get()))
+		{
+			throw std::runtime_error( g_errorhnd->fetchError());
+		}
+		std::vector<strus::WordVector> vectors;
+		{
+			strus::local_ptr<strus::VectorStorageClientInterface> storage( sti->createClient( configstr, dbi.get()));
+			if (!storage.get()) throw std::runtime_error( g_errorhnd->fetchError());
+			strus::local_ptr<strus::VectorStorageTransactionInterface> transaction( storage->createTransaction());
+			if (!transaction.get()) throw std::runtime_error( g_errorhnd->fetchError());
+			for (int vi=0; vi<NofVectors; ++vi)
+			{
+				vectors.push_back( strus::test::createRandomVector( g_random, VecDim));
+				std::string type = strus::string_format( "type%d", vi % NofTypes);
+				transaction->defineVector( type, strus::string_format( "w%d", vi), vectors.back());
+			}
+			if (!transaction->commit()) throw std::runtime_error( g_errorhnd->fetchError());
+			storage->close();
+		}
+		KeyValueMap expected;
+		{
+			strus::local_ptr<strus::DatabaseClientInterface> database( dbi->createClient( SOURCE_DATABASE_CONFIG));
+			if (!database.get()) throw std::runtime_error( g_errorhnd->fetchError());
+			expected = readAllKeyValues( database.get());
+		}
+		testDumpRestore( dbi.get(), expected, "vdump.bin", 0, strus::VectorBinaryDumpConfig::DefaultFrameSize, true);
+		testDumpRestore( dbi.get(), expected, "vdump_threads.bin", 3, 4096, true);
+		testDumpRestore( dbi.get(), expected, "vdump_uncompressed.bin", 2, 1000, false);
+		testCorruptDump( dbi.get(), "vdump_threads.bin", false/*corruptPayloadSize*/);
+		testCorruptDump( dbi.get(), "vdump_threads.bin", true/*corruptPayloadSize*/);
+
+		// ... the storage restored from the last dump is usable as vector storage
+		testDumpRestore( dbi.get(), expected, "vdump.bin", 4, 16384, true);
+		{
+			strus::local_ptr<strus::VectorStorageClientInterface> storage( sti->createClient( RESTORE_DATABASE_CONFIG, dbi.get()));
+			if (!storage.get()) throw std::runtime_error( g_errorhnd->fetchError());
+			std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+			for (int vidx=0; vi != ve; ++vi,++vidx)
+			{
+				std::string type = strus::string_format( "type%d", vidx % NofTypes);
+				strus::WordVector vec = storage->featureVector( type, strus::string_format( "w%d", vidx));
+				if (!strus::test::compareVector( *vi, vec, VEC_EPSILON))
+				{
+					throw std::runtime_error( strus::string_format( "restored vector w%d does not match its image", vidx));
+				}
+			}
+		}
+		if (g_errorhnd->hasError())
+		{
+			throw std::runtime_error( "uncaught exception");
+		}
+		std::cerr << "OK" << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 0;
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::string msg;
+		if (g_errorhnd && g_errorhnd->hasError())
+		{
+			msg.append( " (");
+			msg.append( g_errorhnd->fetchError());
+			msg.append( ")");
+		}
+		std::cerr << "error: " << err.what() << msg << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 1;
+	}
+	catch (const std::bad_alloc& )
+	{
+		std::cerr << "out of memory" << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 2;
+	}
+	catch (const std::logic_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 3;
+	}
+}
+
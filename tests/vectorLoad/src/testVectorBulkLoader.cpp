@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Test program for the bulk loading of vectors from files in the supported formats
+#include "vectorBulkLoader.hpp"
+#include "strus/lib/vector_std.hpp"
+#include "strus/lib/database_leveldb.hpp"
+#include "strus/lib/error.hpp"
+#include "strus/lib/filelocator.hpp"
+#include "strus/vectorStorageInterface.hpp"
+#include "strus/vectorStorageClientInterface.hpp"
+#include "strus/databaseInterface.hpp"
+#include "strus/fileLocatorInterface.hpp"
+#include "strus/errorBufferInterface.hpp"
+#include "strus/storage/wordVector.hpp"
+#include "strus/base/stdint.h"
+#include "strus/base/fileio.hpp"
+#include "strus/base/local_ptr.hpp"
+#include "strus/base/string_format.hpp"
+#include "strus/base/pseudoRandom.hpp"
+#include "vectorUtils.hpp"
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdexcept>
+
+#define VEC_EPSILON 1e-5
+static bool g_verbose = false;
+static strus::PseudoRandom g_random;
+static strus::ErrorBufferInterface* g_errorhnd = 0;
+static strus::FileLocatorInterface* g_fileLocator = 0;
+
+enum {VecDim=32,NofVectors=1000,CommitSize=128};
+#define STORAGE_CONFIG "path=vloadstorage;vecdim=32"
+
+static void writeTestFile( const std::string& filename, const std::string& content)
+{
+	int ec = strus::writeFile( filename, content);
+	if (ec) throw std::runtime_error( strus::string_format( "failed to write test file %s: %s", filename.c_str(), ::strerror(ec)));
+}
+
+static void appendBinary( std::string& buf, const void* ptr, std::size_t size)
+{
+	buf.append( (const char*)ptr, size);
+}
+
+static void appendVectorText( std::string& buf, const strus::WordVector& vec)
+{
+	strus::WordVector::const_iterator vi = vec.begin(), ve = vec.end();
+	for (; vi != ve; ++vi)
+	{
+		buf.append( strus::string_format( " %.9g", *vi));
+	}
+	buf.push_back( '\n');
+}
+
+static std::string textFileContent( const std::vector<strus::WordVector>& vectors, bool withHeader)
+{
+	std::string rt;
+	if (withHeader) rt.append( strus::string_format( "%u %u\n", (unsigned int)vectors.size(), (unsigned int)VecDim));
+	std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+	for (int vidx=0; vi != ve; ++vi,++vidx)
+	{
+		rt.append( strus::string_format( "w%d", vidx));
+		appendVectorText( rt, *vi);
+	}
+	return rt;
+}
+
+static std::string word2vecBinaryFileContent( const std::vector<strus::WordVector>& vectors)
+{
+	std::string rt = strus::string_format( "%u %u\n", (unsigned int)vectors.size(), (unsigned int)VecDim);
+	std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+	for (int vidx=0; vi != ve; ++vi,++vidx)
+	{
+		rt.append( strus::string_format( "w%d ", vidx));
+		appendBinary( rt, &(*vi)[0], vi->size() * sizeof(float));
+		rt.push_back( '\n');
+	}
+	return rt;
+}
+
+static std::string fvecsFileContent( const std::vector<strus::WordVector>& vectors)
+{
+	std::string rt;
+	std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+	for (; vi != ve; ++vi)
+	{
+		int32_t dim = VecDim;
+		appendBinary( rt, &dim, sizeof(dim));
+		appendBinary( rt, &(*vi)[0], vi->size() * sizeof(float));
+	}
+	return rt;
+}
+
+static std::string npyFileContent( const std::vector<strus::WordVector>& vectors)
+{
+	std::string header = strus::string_format( "{'descr': '<f8', 'fortran_order': False, 'shape': (%u, %u), }", (unsigned int)vectors.size(), (unsigned int)VecDim);
+	while ((10 + header.size() + 1) % 64 != 0) header.push_back( ' ');
+	header.push_back( '\n');
+
+	std::string rt( "\x93NUMPY\x01\x00", 8);
+	rt.push_back( (char)(header.size() & 0xFF));
+	rt.push_back( (char)(header.size() >> 8));
+	rt.append( header);
+	std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+	for (; vi != ve; ++vi)
+	{
+		strus::WordVector::const_iterator ei = vi->begin(), ee = vi->end();
+		for (; ei != ee; ++ei)
+		{
+			double val = *ei;
+			appendBinary( rt, &val, sizeof(val));
+		}
+	}
+	return rt;
+}
+
+static void testLoad(
+		strus::VectorStorageClientInterface* storage,
+		const std::vector<strus::WordVector>& vectors,
+		const std::string& filename,
+		const std::string& type,
+		strus::VectorFileFormat format,
+		const char* namePrefix,
+		unsigned int threads)
+{
+	strus::VectorBulkLoadConfig config;
+	config.type = type;
+	config.format = format;
+	config.threads = threads;
+	config.commitSize = CommitSize;
+	config.namePrefix = namePrefix;
+
+	strus::VectorBulkLoader loader( storage, config, g_errorhnd);
+	strus::VectorBulkLoadStatistics stats = loader.load( filename);
+	if (g_verbose) std::cerr << strus::string_format( "loaded %u vectors of type %s from %s in %u commits", (unsigned int)stats.nofVectors, type.c_str(), filename.c_str(), (unsigned int)stats.nofCommits) << std::endl;
+
+	if (stats.nofVectors != vectors.size())
+	{
+		throw std::runtime_error( strus::string_format( "number of vectors loaded from %s (%u) does not match expected (%u)", filename.c_str(), (unsigned int)stats.nofVectors, (unsigned int)vectors.size()));
+	}
+	if (stats.nofCommits != (vectors.size() + CommitSize - 1) / CommitSize)
+	{
+		throw std::runtime_error( strus::string_format( "number of commits loading %s (%u) does not match expected", filename.c_str(), (unsigned int)stats.nofCommits));
+	}
+	if (storage->nofVectors( type) != (int)vectors.size())
+	{
+		throw std::runtime_error( strus::string_format( "stored vector count of %s does not match", type.c_str()));
+	}
+	std::vector<strus::WordVector>::const_iterator vi = vectors.begin(), ve = vectors.end();
+	for (int vidx=0; vi != ve; ++vi,++vidx)
+	{
+		std::string name = strus::string_format( "%s%d", namePrefix, vidx);
+		strus::WordVector vec = storage->featureVector( type, name);
+		if (!strus::test::compareVector( *vi, vec, VEC_EPSILON))
+		{
+			throw std::runtime_error( strus::string_format( "stored vector of %s loaded from %s does not match its image", name.c_str(), filename.c_str()));
+		}
+	}
+}
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		g_errorhnd = strus::createErrorBuffer_standard( 0, 4, NULL/*debug trace interface*/);
+		if (!g_errorhnd) {std::cerr << "FAILED " << "strus::createErrorBuffer_standard" << std::endl; return -1;}
+		g_fileLocator = strus::createFileLocator_std( g_errorhnd);
+		if (!g_fileLocator) {std::cerr << "FAILED " << "strus::createFileLocator_std" << std::endl; return -1;}
+
+		if (argc > 1 && 0==std::strcmp( argv[1], "-V"))
+		{
+			g_verbose = true;
+		}
+		std::string configstr( STORAGE_CONFIG);
+
+		strus::local_ptr<strus::DatabaseInterface> dbi( strus::createDatabaseType_leveldb( g_fileLocator, g_errorhnd));
+		strus::local_ptr<strus::VectorStorageInterface> sti( strus::createVectorStorage_std( g_fileLocator, g_errorhnd));
+		if (!dbi.get() || !sti.get() || g_errorhnd->hasError()) throw std::runtime_error( g_errorhnd->fetchError());
+
+		if (!dbi->destroyDatabase( configstr))
+		{
+			(void)g_errorhnd->fetchError();
+		}
+		if (!sti->createStorage( configstr, dbi.get()))
+		{
+			throw std::runtime_error( g_errorhnd->fetchError());
+		}
+		strus::local_ptr<strus::VectorStorageClientInterface> storage( sti->createClient( configstr, dbi.get()));
+		if (!storage.get()) throw std::runtime_error( g_errorhnd->fetchError());
+
+		std::vector<strus::WordVector> vectors;
+		for (int vi=0; vi<NofVectors; ++vi)
+		{
+			vectors.push_back( strus::test::createRandomVector( g_random, VecDim));
+		}
+		writeTestFile( "vectors.vec", textFileContent( vectors, true));
+		writeTestFile( "vectors.glove.txt", textFileContent( vectors, false));
+		writeTestFile( "vectors.bin", word2vecBinaryFileContent( vectors));
+		writeTestFile( "vectors.fvecs", fvecsFileContent( vectors));
+		writeTestFile( "vectors.npy", npyFileContent( vectors));
+
+		testLoad( storage.get(), vectors, "vectors.vec", "word2vec", strus::VectorFileAuto, "w", 0);
+		testLoad( storage.get(), vectors, "vectors.glove.txt", "glove", strus::VectorFileText, "w", 3);
+		testLoad( storage.get(), vectors, "vectors.bin", "binary", strus::VectorFileAuto, "w", 2);
+		testLoad( storage.get(), vectors, "vectors.fvecs", "fvecs", strus::VectorFileAuto, "f", 3);
+		testLoad( storage.get(), vectors, "vectors.npy", "npy", strus::VectorFileAuto, "n", 0);
+
+		if (storage->nofTypes() != 5)
+		{
+			throw std::runtime_error( "number of types loaded does not match");
+		}
+		if (g_errorhnd->hasError())
+		{
+			throw std::runtime_error( "uncaught exception");
+		}
+		std::cerr << "OK" << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 0;
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::string msg;
+		if (g_errorhnd && g_errorhnd->hasError())
+		{
+			msg.append( " (");
+			msg.append( g_errorhnd->fetchError());
+			msg.append( ")");
+		}
+		std::cerr << "error: " << err.what() << msg << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 1;
+	}
+	catch (const std::bad_alloc& )
+	{
+		std::cerr << "out of memory" << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 2;
+	}
+	catch (const std::logic_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		delete g_fileLocator;
+		delete g_errorhnd;
+		return 3;
+	}
+}
+
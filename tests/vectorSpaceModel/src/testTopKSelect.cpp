@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) 2018 Patrick P. Frey
+ *
+ * This Source Code Form is subject to the terms of the Mozilla Public
+ * License, v. 2.0. If a copy of the MPL was not distributed with this
+ * file, You can obtain one at http://mozilla.org/MPL/2.0/.
+ */
+/// \brief Test program for the selection of the best k elements with the ranklist, the heap and the distance buckets
+#include "topKSelect.hpp"
+#include "simHashRankList.hpp"
+#include <iostream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <ctime>
+#include <algorithm>
+#include <stdexcept>
+
+#undef STRUS_LOWLEVEL_DEBUG
+
+static void initRandomNumberGenerator()
+{
+	time_t nowtime;
+	struct tm* now;
+
+	::time( &nowtime);
+	now = ::localtime( &nowtime);
+
+	unsigned int seed = (now->tm_year+10000) + (now->tm_mon+100) + (now->tm_mday+1);
+	std::srand( seed+3);
+}
+
+struct SimHashRankDistance
+{
+	static int get( const strus::SimHashRank& elem)
+	{
+		return elem.simdist;
+	}
+};
+
+static std::string resultToString( const std::vector<strus::SimHashRank>& res)
+{
+	std::ostringstream buf;
+	std::vector<strus::SimHashRank>::const_iterator ri = res.begin(), re = res.end();
+	for (; ri != re; ++ri)
+	{
+		buf << "(" << ri->index << "->" << ri->simdist << ") ";
+	}
+	return buf.str();
+}
+
+template <class TopKSelect>
+static std::vector<strus::SimHashRank> selectBest( TopKSelect& select, const std::vector<strus::SimHashRank>& elements)
+{
+	std::vector<strus::SimHashRank>::const_iterator ei = elements.begin(), ee = elements.end();
+	for (; ei != ee; ++ei)
+	{
+		select.insert( *ei);
+	}
+	std::vector<strus::SimHashRank> rt;
+	select.getResult( rt);
+	return rt;
+}
+
+static void checkResult( const char* method, const std::vector<strus::SimHashRank>& res, const std::vector<strus::SimHashRank>& exp, bool tiesInInsertOrder)
+{
+	bool equal = (res.size() == exp.size());
+	std::size_t ri = 0, re = equal ? res.size() : 0;
+	for (; ri != re; ++ri)
+	{
+		if (res[ ri].simdist != exp[ ri].simdist)
+		{
+			equal = false;
+		}
+		else if (res[ ri].index != exp[ ri].index)
+		{
+			// ... with the ties at the cutoff distance decided by the order of insertion only the elements with the cutoff distance may differ
+			if (!tiesInInsertOrder || res[ ri].simdist != exp.back().simdist) equal = false;
+		}
+	}
+	if (!equal)
+	{
+		std::cerr << "RES " << resultToString( res) << std::endl;
+		std::cerr << "EXP " << resultToString( exp) << std::endl;
+		throw std::runtime_error( std::string("top-k selection with method '") + method + "' does not match the expected result");
+	}
+}
+
+static void testSelect( int nofElements, int maxNofRanks, int maxDistance, bool insertSorted)
+{
+	std::vector<strus::SimHashRank> elements;
+	for (int ei=0; ei < nofElements; ++ei)
+	{
+		elements.push_back( strus::SimHashRank( ei+1, rand() % (maxDistance+1)));
+	}
+	if (!insertSorted)
+	{
+		std::random_shuffle( elements.begin(), elements.end());
+	}
+	std::vector<strus::SimHashRank> expected( elements);
+	std::sort( expected.begin(), expected.end());
+	if (expected.size() > (std::size_t)maxNofRanks)
+	{
+		expected.resize( maxNofRanks);
+	}
+	if (maxNofRanks <= strus::RankList<strus::SimHashRank>::MaxSize)
+	{
+		strus::RankList<strus::SimHashRank> ranklist( maxNofRanks);
+		checkResult( "list", selectBest( ranklist, elements), expected, false);
+	}
+	strus::TopKHeap<strus::SimHashRank> heap( maxNofRanks);
+	checkResult( "heap", selectBest( heap, elements), expected, false);
+
+	strus::TopKDistanceBuckets<strus::SimHashRank,SimHashRankDistance> buckets( maxNofRanks);
+	// ... elements inserted in the order of operator < of the element decide ties the same way as the other methods
+	checkResult( "bucket", selectBest( buckets, elements), expected, !insertSorted);
+}
+
+static void testBucketCutoff( int maxNofRanks)
+{
+	strus::TopKDistanceBuckets<strus::SimHashRank,SimHashRankDistance> buckets( maxNofRanks);
+	enum {CutoffDistance=10};
+	strus::Index index = 1;
+	for (int ei=0; ei < maxNofRanks; ++ei)
+	{
+		if (!buckets.insert( strus::SimHashRank( index++, CutoffDistance))) throw std::runtime_error( "top-k buckets rejected an element before holding enough elements");
+	}
+	// ... once enough elements are kept, elements with the cutoff distance or a bigger one are rejected
+	for (int ei=0; ei < 1000; ++ei)
+	{
+		if (buckets.insert( strus::SimHashRank( index++, CutoffDistance + (ei % 2))))
+		{
+			throw std::runtime_error( "top-k buckets accepted an element not closer than the cutoff distance");
+		}
+	}
+	if (!buckets.insert( strus::SimHashRank( index++, CutoffDistance-1)))
+	{
+		throw std::runtime_error( "top-k buckets rejected an element closer than the cutoff distance");
+	}
+	std::vector<strus::SimHashRank> res;
+	buckets.getResult( res);
+	if (res.size() != (std::size_t)maxNofRanks || res[0].simdist != CutoffDistance-1)
+	{
+		std::cerr << "RES " << resultToString( res) << std::endl;
+		throw std::runtime_error( "unexpected result of top-k buckets after cutoff");
+	}
+}
+
+int main( int argc, const char** argv)
+{
+	try
+	{
+		enum {NofTests=200,MaxNofElements=3000,MaxNofRanks=300,MaxDistance=64};
+		initRandomNumberGenerator();
+		for (int ti=0; ti < NofTests; ++ti)
+		{
+			int nofElements = rand() % MaxNofElements + 1;
+			int maxNofRanks = rand() % MaxNofRanks + 1;
+			int maxDistance = rand() % MaxDistance;
+			bool insertSorted = (ti % 2 == 0);
+#ifdef STRUS_LOWLEVEL_DEBUG
+			std::cerr << "test " << (ti+1) << " elements " << nofElements << " ranks " << maxNofRanks << " max distance " << maxDistance << (insertSorted ? " sorted":"") << std::endl;
+#endif
+			testSelect( nofElements, maxNofRanks, maxDistance, insertSorted);
+		}
+		testBucketCutoff( 1);
+		testBucketCutoff( 20);
+		std::cerr << "OK" << std::endl;
+		return 0;
+	}
+	catch (const std::runtime_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -1;
+	}
+	catch (const std::bad_alloc& )
+	{
+		std::cerr << "out of memory" << std::endl;
+		return -2;
+	}
+	catch (const std::logic_error& err)
+	{
+		std::cerr << "error: " << err.what() << std::endl;
+		return -3;
+	}
+}
+
@@ -12,8 +12,10 @@
 #include "strus/lib/filelocator.hpp"
 #include "strus/vectorStorageInterface.hpp"
 #include "strus/vectorStorageClientInterface.hpp"
+#include "strus/vectorStorageSearchInterface.hpp"
 #include "strus/vectorStorageTransactionInterface.hpp"
 #include "strus/databaseInterface.hpp"
+#include "strus/databaseClientInterface.hpp"
 #include "strus/fileLocatorInterface.hpp"
 #include "strus/errorBufferInterface.hpp"
 #include "strus/storage/wordVector.hpp"
@@ -26,12 +28,16 @@
 #include "strus/base/numstring.hpp"
 #include "strus/base/pseudoRandom.hpp"
 #include "strus/base/math.hpp"
+#include "strus/base/thread.hpp"
+#include "strus/reference.hpp"
 #include "vectorUtils.hpp"
+#include "frozenStorage.hpp"
 #include "armadillo"
 #include <iostream>
 #include <sstream>
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 #include <memory>
 #include <iomanip>
@@ -107,6 +113,194 @@ struct FeatureDef
 		:type(o.type),feat(o.feat),vec(o.vec){}
 };
 
+/// \brief Thread preparing the searchers of all types concurrently with other threads doing the same
+class PrepareSearchWorker
+{
+public:
+	PrepareSearchWorker( const strus::VectorStorageClientInterface* storage_, const std::vector<std::string>& types_)
+		:m_storage(storage_),m_types(types_),m_error(){}
+
+	void run()
+	{
+		std::vector<std::string>::const_iterator ti = m_types.begin(), te = m_types.end();
+		for (; ti != te; ++ti)
+		{
+			m_storage->prepareSearch( *ti);
+		}
+		// ... the error of this thread has to be fetched before its context is released
+		if (g_errorhnd->hasError())
+		{
+			m_error = g_errorhnd->fetchError();
+		}
+		g_errorhnd->releaseContext();
+	}
+
+	const std::string& error() const
+	{
+		return m_error;
+	}
+
+private:
+	const strus::VectorStorageClientInterface* m_storage;
+	std::vector<std::string> m_types;
+	std::string m_error;
+};
+
+static bool isEqualResult( const std::vector<strus::VectorQueryResult>& result, const std::vector<strus::VectorQueryResult>& expect)
+{
+	if (result.size() != expect.size()) return false;
+	std::vector<strus::VectorQueryResult>::const_iterator ri = result.begin(), re = result.end();
+	std::vector<strus::VectorQueryResult>::const_iterator ei = expect.begin();
+	for (; ri != re; ++ri,++ei)
+	{
+		if (ri->value() != ei->value() || !strus::Math::isequal( ri->weight(), ei->weight(), VEC_EPSILON)) return false;
+	}
+	return true;
+}
+
+/// \brief Consumer of the results of a radius search collecting them, optionally stopping the search after a number of results
+class RadiusResultCollector
+	:public strus::VectorQueryResultConsumerInterface
+{
+public:
+	explicit RadiusResultCollector( int maxNofResults_=-1)
+		:m_maxNofResults(maxNofResults_),m_results(){}
+	virtual ~RadiusResultCollector(){}
+
+	virtual bool consume( const strus::VectorQueryResult& result)
+	{
+		m_results.push_back( result);
+		return m_maxNofResults < 0 || (int)m_results.size() < m_maxNofResults;
+	}
+
+	const std::vector<strus::VectorQueryResult>& results() const
+	{
+		return m_results;
+	}
+
+private:
+	int m_maxNofResults;
+	std::vector<strus::VectorQueryResult> m_results;
+};
+
+/// \brief Order of results by name for comparing result sets
+struct VectorQueryResultNameOrder
+{
+	bool operator()( const strus::VectorQueryResult& a, const strus::VectorQueryResult& b) const
+	{
+		return a.value() < b.value();
+	}
+};
+
+/// \brief Check the search over multiple types against the searches of each type
+static void checkMultiTypeSearch( const strus::VectorStorageClientInterface* storage, const std::vector<std::string>& types, const strus::WordVector& vec, int maxNofResults, double minSimilarity, double speedRecallFactor, bool realVecWeights)
+{
+	const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage);
+	if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+
+	std::vector<std::vector<strus::VectorQueryResult> > expect;
+	std::size_t nofExpected = 0;
+	std::vector<std::string>::const_iterator ti = types.begin(), te = types.end();
+	for (; ti != te; ++ti)
+	{
+		expect.push_back( storage->findSimilar( *ti, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights));
+		nofExpected += expect.back().size();
+	}
+	std::vector<std::vector<strus::VectorQueryResult> > multi = search->findSimilarMulti( types, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+	if (multi.size() != types.size()) throw std::runtime_error( "search over multiple types returned a wrong number of result lists");
+	for (std::size_t tidx=0; tidx < types.size(); ++tidx)
+	{
+		if (!isEqualResult( multi[ tidx], expect[ tidx]))
+		{
+			std::cerr << "result:" << std::endl;
+			printResult( std::cerr, multi[ tidx]);
+			std::cerr << "expected:" << std::endl;
+			printResult( std::cerr, expect[ tidx]);
+			throw std::runtime_error( strus::string_format( "result of search over multiple types does not match the search of type '%s'", types[ tidx].c_str()));
+		}
+	}
+	std::vector<strus::VectorQueryTypedResult> merged = search->findSimilarMultiMerged( types, vec, maxNofResults, minSimilarity, speedRecallFactor, realVecWeights);
+	if (merged.size() != std::min( nofExpected, (std::size_t)maxNofResults))
+	{
+		throw std::runtime_error( strus::string_format( "merged search over multiple types returned %d results instead of %d", (int)merged.size(), (int)std::min( nofExpected, (std::size_t)maxNofResults)));
+	}
+	std::vector<strus::VectorQueryTypedResult>::const_iterator mi = merged.begin(), me = merged.end();
+	for (; mi != me; ++mi)
+	{
+		if (mi != merged.begin() && (mi-1)->weight() < mi->weight())
+		{
+			throw std::runtime_error( "merged results of search over multiple types not sorted by weight");
+		}
+		std::size_t tidx = std::find( types.begin(), types.end(), mi->type()) - types.begin();
+		if (tidx == types.size()) throw std::runtime_error( "merged result of search over multiple types with unknown type");
+		const std::vector<strus::VectorQueryResult>& typeResults = expect[ tidx];
+		std::vector<strus::VectorQueryResult>::const_iterator ei = typeResults.begin(), ee = typeResults.end();
+		for (; ei != ee && ei->value() != mi->value(); ++ei){}
+		if (ei != ee)
+		{
+			if (!strus::Math::isequal( ei->weight(), mi->weight(), VEC_EPSILON))
+			{
+				throw std::runtime_error( "weight of merged result of search over multiple types does not match");
+			}
+		}
+		else if ((int)typeResults.size() < maxNofResults || !strus::Math::isequal( typeResults.back().weight(), mi->weight(), VEC_EPSILON))
+		{
+			// ... only a result with the same weight as the last result of its type may replace it
+			throw std::runtime_error( strus::string_format( "merged result '%s' of search over multiple types not found in the results of type '%s'", mi->value().c_str(), mi->type().c_str()));
+		}
+	}
+}
+
+/// \brief Define a feature with a vector in a transaction followed by enough vectors of filler features to write a batch allocating its number
+static void defineFeatureInBatch( strus::VectorStorageTransactionInterface* transaction, const std::string& type, const std::string& feature, const strus::WordVector& vec, const std::string& fillerPrefix, unsigned int vecdim, unsigned int transactionMemoryMB)
+{
+	transaction->defineVector( type, feature, vec);
+	std::size_t nofFillers = ((std::size_t)transactionMemoryMB << 20) / (vecdim * sizeof(float)) + 1;
+	for (std::size_t fi=0; fi < nofFillers; ++fi)
+	{
+		transaction->defineVector( type, strus::string_format( "%s%d", fillerPrefix.c_str(), (int)fi), strus::test::createRandomVector( g_random, vecdim));
+	}
+}
+
+/// \brief Check that a feature allocated by concurrent transactions gets one number even if one of them is rolled back
+static void checkSharedPendingFeature( strus::VectorStorageClientInterface* storage, unsigned int vecdim, unsigned int transactionMemoryMB)
+{
+	std::string typeA( "_pending_type_AB_");
+	std::string typeC( "_pending_type_C_");
+	std::string feature( "_pending_feature_");
+	strus::WordVector vecB = strus::test::createRandomVector( g_random, vecdim);
+	strus::WordVector vecC = strus::test::createRandomVector( g_random, vecdim);
+
+	strus::local_ptr<strus::VectorStorageTransactionInterface> transactionA( storage->createTransaction());
+	strus::local_ptr<strus::VectorStorageTransactionInterface> transactionB( storage->createTransaction());
+	if (!transactionA.get() || !transactionB.get()) throw std::runtime_error( g_errorhnd->fetchError());
+	defineFeatureInBatch( transactionA.get(), typeA, feature, strus::test::createRandomVector( g_random, vecdim), "_pending_filler_A_", vecdim, transactionMemoryMB);
+	defineFeatureInBatch( transactionB.get(), typeA, feature, vecB, "_pending_filler_B_", vecdim, transactionMemoryMB);
+	transactionA->rollback();
+
+	// ... the number of the feature and the type is still held by B, C has to get the same one
+	strus::local_ptr<strus::VectorStorageTransactionInterface> transactionC( storage->createTransaction());
+	if (!transactionC.get()) throw std::runtime_error( g_errorhnd->fetchError());
+	transactionC->defineVector( typeC, feature, vecC);
+	if (!transactionB->commit() || !transactionC->commit())
+	{
+		throw std::runtime_error( "commit of transactions sharing a pending feature failed");
+	}
+	if (g_errorhnd->hasError()) throw std::runtime_error( "error in transactions sharing a pending feature");
+
+	if (!strus::test::compareVector( vecB, storage->featureVector( typeA, feature), VEC_EPSILON)
+	||  !strus::test::compareVector( vecC, storage->featureVector( typeC, feature), VEC_EPSILON))
+	{
+		throw std::runtime_error( "vector of a feature committed by transactions sharing its pending number not found");
+	}
+	std::vector<std::string> types = storage->featureTypes( feature);
+	std::sort( types.begin(), types.end());
+	if (types.size() != 2 || types[0] != typeA || types[1] != typeC)
+	{
+		throw std::runtime_error( "relations of a feature committed by transactions sharing its pending number do not match");
+	}
+}
+
 int main( int argc, const char** argv)
 {
 	try
@@ -122,8 +316,12 @@ int main( int argc, const char** argv)
 		strus::Index nofFeatures = 1000;
 		unsigned int vecdim = 300/*strus::VectorStorage::DefaultDim*/;
 		unsigned int threads = 0;
+		unsigned int searchThreads = 0;
+		unsigned int resultCacheSize = 0;
+		unsigned int transactionMemoryMB = 0;
 		std::string workdir = "./";
 		bool printUsageAndExit = false;
+		bool freeze = false;
 		float sim_cos = 0.9;
 		float result_sim_cos = 0.95;
 		double minSimilarity = 0.9;
@@ -142,6 +340,10 @@ int main( int argc, const char** argv)
 			{
 				g_verbose = true;
 			}
+			else if (0==std::strcmp( argv[argidx], "-F"))
+			{
+				freeze = true;
+			}
 			else if (0==std::strcmp( argv[argidx], "-s"))
 			{
 				if (argidx+1 == argc)
@@ -183,6 +385,7 @@ int main( int argc, const char** argv)
 			std::cerr << "-h                     : print this usage" << std::endl;
 			std::cerr << "-V                     : verbose output to stderr" << std::endl;
 			std::cerr << "-s <CONFIG>            :specify test configuration string as <CONFIG>" << std::endl;
+			std::cerr << "-F                     :run the checks on a frozen storage file exported after the inserts" << std::endl;
 			std::cerr << "<workdir>              :working directory, default './'" << std::endl;
 			std::cerr << "<number of features>   :number of features, default 1000" << std::endl;
 			std::cerr << "<number of types>      :number of types, default 1" << std::endl;
@@ -194,12 +397,15 @@ int main( int argc, const char** argv)
 		{
 			std::string configsrc = configstr;
 			(void)extractUIntFromConfigString( threads, configsrc, "threads", g_errorhnd);
+			(void)extractUIntFromConfigString( searchThreads, configsrc, "searchthreads", g_errorhnd);
+			(void)extractUIntFromConfigString( resultCacheSize, configsrc, "resultcache", g_errorhnd);
+			(void)extractUIntFromConfigString( transactionMemoryMB, configsrc, "txmem", g_errorhnd);
 			(void)extractUIntFromConfigString( vecdim, configsrc, "vecdim", g_errorhnd);
 		}
-		if (threads > 1)
+		if (threads > 1 || searchThreads)
 		{
 			delete g_errorhnd;
-			g_errorhnd = strus::createErrorBuffer_standard( 0, threads+2, NULL/*debug trace interface*/);
+			g_errorhnd = strus::createErrorBuffer_standard( 0, threads+searchThreads+2, NULL/*debug trace interface*/);
 			if (!g_errorhnd) throw std::runtime_error("failed to create error buffer structure");
 		}
 		// Build all objects:
@@ -315,6 +521,31 @@ int main( int argc, const char** argv)
 			++nofCommits;
 			if (g_verbose) std::cerr << strus::string_format( "inserted %d vectors, %d features, %d types, in %d commits.", nofVectors, nofFeatures, nofTypes, nofCommits) << std::endl;
 		}
+		if (freeze)
+		{
+			// ... the storage is exported to a frozen storage file and all checks are done with a client reading from it
+			if (g_verbose) std::cerr << "export test repository to a frozen storage file ..." << std::endl;
+			storage.reset();
+			std::string dbpath;
+			std::string configsrc = configstr;
+			if (!extractStringFromConfigString( dbpath, configsrc, "path", g_errorhnd))
+			{
+				throw std::runtime_error( "path of the database not specified in the configuration");
+			}
+			std::string frozenPath = strus::joinFilePath( workdir, "vstorage.frozen");
+			{
+				strus::local_ptr<strus::DatabaseClientInterface> dbclient( dbi->createClient( std::string("path=") + dbpath));
+				if (!dbclient.get()) throw std::runtime_error( g_errorhnd->fetchError());
+				std::size_t nofEntries = strus::FrozenStorage::exportDatabase( dbclient.get(), frozenPath);
+				if (g_verbose) std::cerr << strus::string_format( "exported %d key/value pairs to %s", (int)nofEntries, frozenPath.c_str()) << std::endl;
+			}
+			storage.reset( sti->createClient( configstr + ";frozen=" + frozenPath, dbi.get()));
+			if (!storage.get()) throw std::runtime_error( g_errorhnd->fetchError());
+
+			strus::local_ptr<strus::VectorStorageTransactionInterface> transaction( storage->createTransaction());
+			if (transaction.get()) throw std::runtime_error( "transaction created on a frozen storage");
+			(void)g_errorhnd->fetchError();
+		}
 		typedef strus::VectorQueryResult SimFeat;
 		typedef std::vector<strus::VectorQueryResult> SimFeatList;
 		typedef std::map<std::string,SimFeatList> SimMatrix;
@@ -473,7 +704,43 @@ int main( int argc, const char** argv)
 				{
 					throw std::runtime_error( "error in test reading feature type relations");
 				}
-			}{
+			}
+			if (threads > 1)
+			{
+				if (g_verbose) std::cerr << "test concurrent creation of the searchers ..." << std::endl;
+				std::vector<std::string> types = storage->types();
+				std::vector<strus::Reference<PrepareSearchWorker> > workers;
+				std::vector<strus::Reference<strus::thread> > threadGroup;
+				unsigned int tidx = 0;
+				for (; tidx < threads; ++tidx)
+				{
+					workers.push_back( strus::Reference<PrepareSearchWorker>( new PrepareSearchWorker( storage.get(), types)));
+					strus::Reference<strus::thread> th( new strus::thread( &PrepareSearchWorker::run, workers.back().get()));
+					threadGroup.push_back( th);
+				}
+				std::vector<strus::Reference<strus::thread> >::iterator gi = threadGroup.begin(), ge = threadGroup.end();
+				for (; gi != ge; ++gi) (*gi)->join();
+				std::vector<strus::Reference<PrepareSearchWorker> >::const_iterator wi = workers.begin(), we = workers.end();
+				for (; wi != we; ++wi)
+				{
+					if (!(*wi)->error().empty())
+					{
+						throw std::runtime_error( strus::string_format( "error in test concurrent creation of the searchers: %s", (*wi)->error().c_str()));
+					}
+				}
+				if (g_errorhnd->hasError())
+				{
+					throw std::runtime_error( "error in test concurrent creation of the searchers");
+				}
+				// ... the searcher of each type has been created once, the threads asking for a searcher in creation waited for it
+				const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage.get());
+				if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+				if (search->nofSearchersCreated() != (int)types.size())
+				{
+					throw std::runtime_error( strus::string_format( "searchers created %d times for %d types in test concurrent creation of the searchers", search->nofSearchersCreated(), (int)types.size()));
+				}
+			}
+			{
 				if (g_verbose) std::cerr << "test similarity search ..." << std::endl;
 				strus::Index ti = 1, te = nofTypes;
 				int nofSearchesWithRealWeights = 0;
@@ -498,6 +765,15 @@ int main( int argc, const char** argv)
 						{
 							if (g_verbose) std::cerr << strus::string_format( "find similar of '%s'",di->feat.c_str()) << std::endl;
 							std::vector<strus::VectorQueryResult> simar = storage->findSimilar( type, di->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, useRealWeights);
+							if (resultCacheSize)
+							{
+								// ... the repeated search is answered by the result cache and has to return the same results
+								std::vector<strus::VectorQueryResult> cachedar = storage->findSimilar( type, di->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, useRealWeights);
+								if (simar.size() != cachedar.size() || !compareResult( simar, cachedar, 0.0) || !compareResult( cachedar, simar, 0.0))
+								{
+									throw std::runtime_error("cached search result does not match");
+								}
+							}
 							std::vector<strus::VectorQueryResult> expect;
 
 							SimMatrix::const_iterator mi = simMatrix.find( di->feat);
@@ -551,6 +827,258 @@ int main( int argc, const char** argv)
 					throw std::runtime_error( "error in test similarity search");
 				}
 				if (g_verbose) std::cerr << strus::string_format( "performed %d searches with real weights and %d searches with LSH approximation only.", nofSearchesWithRealWeights, nofSearchesWithApproxWeights) << std::endl;
+				if (resultCacheSize)
+				{
+					// ... the repeated searches have been answered by the result cache
+					const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage.get());
+					if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+					strus::VectorQueryResultCacheStatistics stats = search->queryResultCacheStatistics();
+					if (g_verbose) std::cerr << strus::string_format( "result cache hits %d misses %d entries %d", (int)stats.hits, (int)stats.misses, (int)stats.entries) << std::endl;
+					if (stats.hits == 0 || stats.entries == 0)
+					{
+						throw std::runtime_error( "repeated searches not answered by the result cache");
+					}
+				}
+			}
+			{
+				if (g_verbose) std::cerr << "test similarity search over multiple types ..." << std::endl;
+				std::vector<std::string> types = storage->types();
+				int nofMultiTypeSearches = 0;
+				std::vector<FeatureDef>::const_iterator di = defs.begin(), de = defs.end();
+				for (int didx=0; di != de; ++di,++didx)
+				{
+					if (!di->vec.empty() && didx % 7 == 0)
+					{
+						bool useRealWeights = (g_random.get(0,2) == 1);
+						checkMultiTypeSearch( storage.get(), types, di->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, useRealWeights);
+						++nofMultiTypeSearches;
+					}
+				}
+				if (g_errorhnd->hasError())
+				{
+					throw std::runtime_error( "error in test similarity search over multiple types");
+				}
+				if (g_verbose) std::cerr << strus::string_format( "performed %d searches over %d types", nofMultiTypeSearches, (int)types.size()) << std::endl;
+			}
+			{
+				if (g_verbose) std::cerr << "test similarity search within a radius ..." << std::endl;
+				const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage.get());
+				if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+
+				int nofRadiusSearches = 0;
+				std::vector<FeatureDef>::const_iterator di = defs.begin(), de = defs.end();
+				for (int didx=0; di != de; ++di,++didx)
+				{
+					if (di->vec.empty() || didx % 5 != 0) continue;
+					bool useRealWeights = (g_random.get(0,2) == 1);
+					RadiusResultCollector sortedCollector;
+					RadiusResultCollector streamCollector;
+					int nofSorted = search->findSimilarWithinRadius( sortedCollector, di->type, di->vec, minSimilarity, speedRecallFactor, useRealWeights, true/*sorted*/);
+					int nofStreamed = search->findSimilarWithinRadius( streamCollector, di->type, di->vec, minSimilarity, speedRecallFactor, useRealWeights, false/*sorted*/);
+					std::vector<strus::VectorQueryResult> simar = sortedCollector.results();
+					std::vector<strus::VectorQueryResult> streamar = streamCollector.results();
+					if (nofSorted != (int)simar.size() || nofStreamed != (int)streamar.size())
+					{
+						throw std::runtime_error( strus::string_format( "radius search of '%s' returned a count different from the number of results passed", di->feat.c_str()));
+					}
+					std::vector<strus::VectorQueryResult>::const_iterator ri = simar.begin(), re = simar.end();
+					for (; ri != re; ++ri)
+					{
+						if (ri->weight() < minSimilarity)
+						{
+							throw std::runtime_error( strus::string_format( "radius search of '%s' returned '%s' with a weight below the minimum similarity", di->feat.c_str(), ri->value().c_str()));
+						}
+						if (ri != simar.begin() && (ri-1)->weight() < ri->weight())
+						{
+							throw std::runtime_error( strus::string_format( "sorted radius search of '%s' returned results not sorted by weight", di->feat.c_str()));
+						}
+					}
+					// ... the streaming search passes the same results as the sorted one in the order of the scan
+					std::sort( streamar.begin(), streamar.end(), VectorQueryResultNameOrder());
+					std::vector<strus::VectorQueryResult> sortedByName = simar;
+					std::sort( sortedByName.begin(), sortedByName.end(), VectorQueryResultNameOrder());
+					if (!isEqualResult( streamar, sortedByName))
+					{
+						std::cerr << "streamed:" << std::endl;
+						printResult( std::cerr, streamar);
+						std::cerr << "sorted:" << std::endl;
+						printResult( std::cerr, sortedByName);
+						throw std::runtime_error( strus::string_format( "streaming and sorted radius search of '%s' differ", di->feat.c_str()));
+					}
+					if (simar.empty() || !strus::Math::isequal( simar[0].weight(), 1.0, VEC_EPSILON*40))
+					{
+						throw std::runtime_error( strus::string_format( "similarity of '%s' to itself not found in radius search", di->feat.c_str()));
+					}
+					// ... all similar features have to be found without a limit of the number of results
+					SimMatrixMap::const_iterator si = simMatrixMap.find( di->type);
+					if (si == simMatrixMap.end()) throw std::runtime_error( "logic error: sim matrix not defined");
+					SimMatrix::const_iterator mi = si->second.find( di->feat);
+					if (mi == si->second.end())
+					{
+						throw std::runtime_error( strus::string_format( "expected vector query result is empty for %s '%s'", di->type.c_str(), di->feat.c_str()));
+					}
+					if (!compareResult( simar, mi->second, result_sim_cos)
+					||  !compareResult( mi->second, simar, result_sim_cos))
+					{
+						std::cerr << "result:" << std::endl;
+						printResult( std::cerr, simar);
+						std::cerr << "expected:" << std::endl;
+						printResult( std::cerr, mi->second);
+						throw std::runtime_error( strus::string_format( "radius search result of '%s' does not match", di->feat.c_str()));
+					}
+					// ... a consumer stopping the search gets no further results, the result it stopped on is counted
+					if (simar.size() > 1)
+					{
+						int nofStop = (int)simar.size() / 2;
+						RadiusResultCollector stopCollector( nofStop);
+						int nofStopped = search->findSimilarWithinRadius( stopCollector, di->type, di->vec, minSimilarity, speedRecallFactor, useRealWeights, nofRadiusSearches % 2 == 0/*sorted*/);
+						if (nofStopped != nofStop || (int)stopCollector.results().size() != nofStop)
+						{
+							throw std::runtime_error( strus::string_format( "radius search of '%s' stopped after %d results returned %d and passed %d results", di->feat.c_str(), nofStop, nofStopped, (int)stopCollector.results().size()));
+						}
+					}
+					++nofRadiusSearches;
+				}
+				if (g_errorhnd->hasError())
+				{
+					throw std::runtime_error( "error in test similarity search within a radius");
+				}
+				if (g_verbose) std::cerr << strus::string_format( "performed %d radius searches", nofRadiusSearches) << std::endl;
+			}
+			{
+				if (g_verbose) std::cerr << "test similarity search restricted to a set of features ..." << std::endl;
+				const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage.get());
+				if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+
+				// ... every second feature with a vector of the type, a feature without vector of the type and a feature not known to the storage
+				std::string type = getTypeName( 1);
+				std::set<std::string> allowed;
+				std::vector<std::string> restrictionFeatures;
+				const FeatureDef* defWithoutVector = 0;
+				std::vector<FeatureDef>::const_iterator di = defs.begin(), de = defs.end();
+				for (int didx=0; di != de; ++di,++didx)
+				{
+					if (di->type != type) continue;
+					if (di->vec.empty())
+					{
+						if (!defWithoutVector) defWithoutVector = &*di;
+					}
+					else if (didx % 2 == 0)
+					{
+						allowed.insert( di->feat);
+					}
+				}
+				if (defWithoutVector) allowed.insert( defWithoutVector->feat);
+				restrictionFeatures.insert( restrictionFeatures.end(), allowed.begin(), allowed.end());
+				restrictionFeatures.push_back( "_unknown_feature_");
+
+				strus::local_ptr<strus::VectorSearchRestrictionInterface> restriction( search->createSearchRestriction( restrictionFeatures));
+				if (!restriction.get()) throw std::runtime_error( g_errorhnd->fetchError());
+				if (restriction->nofFeatures() != (int)allowed.size())
+				{
+					throw std::runtime_error( strus::string_format( "search restriction has %d features instead of %d", restriction->nofFeatures(), (int)allowed.size()));
+				}
+				int nofRestrictedSearches = 0;
+				for (di = defs.begin(); di != de; ++di)
+				{
+					if (di->type != type || di->vec.empty()) continue;
+					bool useRealWeights = (g_random.get(0,2) == 1);
+					std::vector<strus::VectorQueryResult> simar = search->findSimilarRestricted( type, di->vec, *restriction, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, useRealWeights);
+					std::vector<strus::VectorQueryResult>::const_iterator ri = simar.begin(), re = simar.end();
+					for (; ri != re; ++ri)
+					{
+						if (allowed.find( ri->value()) == allowed.end())
+						{
+							throw std::runtime_error( strus::string_format( "restricted search of '%s' returned feature '%s' not in the restriction", di->feat.c_str(), ri->value().c_str()));
+						}
+					}
+					if (allowed.find( di->feat) != allowed.end())
+					{
+						if (simar.empty() || !strus::Math::isequal( simar[0].weight(), 1.0, VEC_EPSILON*40))
+						{
+							throw std::runtime_error( strus::string_format( "similarity of '%s' to itself not found in restricted search", di->feat.c_str()));
+						}
+					}
+					++nofRestrictedSearches;
+				}
+				if (defWithoutVector && !freeze)
+				{
+					// ... a commit replaces the searcher of the type, the set of slots of the restriction has to be rebuilt for the new one
+					strus::WordVector vec = strus::test::createRandomVector( g_random, vecdim);
+					strus::local_ptr<strus::VectorStorageTransactionInterface> transaction( storage->createTransaction());
+					if (!transaction.get()) throw std::runtime_error( g_errorhnd->fetchError());
+					transaction->defineVector( type, defWithoutVector->feat, vec);
+					if (!transaction->commit()) throw std::runtime_error( "adding vector for restricted search failed");
+
+					std::vector<strus::VectorQueryResult> simar = search->findSimilarRestricted( type, vec, *restriction, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, true/*realVecWeights*/);
+					if (simar.empty() || simar[0].value() != defWithoutVector->feat || !strus::Math::isequal( simar[0].weight(), 1.0, VEC_EPSILON*40))
+					{
+						throw std::runtime_error( strus::string_format( "vector of '%s' added after the creation of the restriction not found in restricted search", defWithoutVector->feat.c_str()));
+					}
+					++nofRestrictedSearches;
+				}
+				if (g_errorhnd->hasError())
+				{
+					throw std::runtime_error( "error in test similarity search restricted to a set of features");
+				}
+				if (g_verbose) std::cerr << strus::string_format( "performed %d restricted searches with %d features allowed", nofRestrictedSearches, (int)allowed.size()) << std::endl;
+			}
+			if (resultCacheSize && !freeze)
+			{
+				if (g_verbose) std::cerr << "test invalidation of the result cache by a commit ..." << std::endl;
+				const strus::VectorStorageSearchInterface* search = dynamic_cast<const strus::VectorStorageSearchInterface*>( storage.get());
+				if (!search) throw std::runtime_error( "vector storage client does not implement the search interface");
+
+				// ... search a vector of each of two types, a commit to the first type has to drop its cached results but keep the ones of the second type
+				std::string changedType = getTypeName( 1);
+				std::string keptType = getTypeName( 2);
+				const FeatureDef* changedDef = 0;
+				const FeatureDef* keptDef = 0;
+				std::vector<FeatureDef>::const_iterator di = defs.begin(), de = defs.end();
+				for (; di != de && (!changedDef || !keptDef); ++di)
+				{
+					if (di->vec.empty()) continue;
+					if (!changedDef && di->type == changedType) changedDef = &*di;
+					if (!keptDef && di->type == keptType) keptDef = &*di;
+				}
+				if (!changedDef || !keptDef) throw std::runtime_error( "no features with vectors for the test of the result cache");
+
+				(void)storage->findSimilar( changedType, changedDef->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, true/*realVecWeights*/);
+				(void)storage->findSimilar( keptType, keptDef->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, true/*realVecWeights*/);
+				strus::VectorQueryResultCacheStatistics stats = search->queryResultCacheStatistics();
+
+				strus::local_ptr<strus::VectorStorageTransactionInterface> transaction( storage->createTransaction());
+				if (!transaction.get()) throw std::runtime_error( g_errorhnd->fetchError());
+				transaction->defineVector( changedType, "_result_cache_feature_", strus::test::createRandomVector( g_random, vecdim));
+				if (!transaction->commit()) throw std::runtime_error( "adding vector for test of the result cache failed");
+
+				strus::VectorQueryResultCacheStatistics commitStats = search->queryResultCacheStatistics();
+				if (commitStats.entries >= stats.entries || commitStats.entries == 0)
+				{
+					throw std::runtime_error( strus::string_format( "commit changed the result cache entries from %d to %d instead of dropping the ones of type '%s' only", (int)stats.entries, (int)commitStats.entries, changedType.c_str()));
+				}
+				(void)storage->findSimilar( keptType, keptDef->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, true/*realVecWeights*/);
+				strus::VectorQueryResultCacheStatistics keptStats = search->queryResultCacheStatistics();
+				if (keptStats.hits != commitStats.hits + 1)
+				{
+					throw std::runtime_error( strus::string_format( "cached result of type '%s' not changed by the commit has been dropped", keptType.c_str()));
+				}
+				(void)storage->findSimilar( changedType, changedDef->vec, 20/*maxNofResults*/, minSimilarity, speedRecallFactor, true/*realVecWeights*/);
+				strus::VectorQueryResultCacheStatistics changedStats = search->queryResultCacheStatistics();
+				if (changedStats.hits != keptStats.hits || changedStats.misses != keptStats.misses + 1)
+				{
+					throw std::runtime_error( strus::string_format( "cached result of type '%s' changed by the commit has not been dropped", changedType.c_str()));
+				}
+				if (g_errorhnd->hasError())
+				{
+					throw std::runtime_error( "error in test invalidation of the result cache by a commit");
+				}
+			}
+			if (transactionMemoryMB && !freeze)
+			{
+				// ... the number of a feature is allocated when a batch of a transaction is written, before its commit
+				if (g_verbose) std::cerr << "test features allocated by concurrent transactions with one rolled back ..." << std::endl;
+				checkSharedPendingFeature( storage.get(), vecdim, transactionMemoryMB);
 			}
 		}
 		if (g_errorhnd->hasError())